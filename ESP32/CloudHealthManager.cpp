@@ -0,0 +1,123 @@
+#include "CloudHealthManager.h"
+#include <Arduino.h>
+
+static const uint32_t FAILURES_TO_OPEN  = 3;                    // consecutive failures that trip the breaker
+static const uint32_t SLOW_REQUEST_MS   = 5000;                 // slower than this counts as a failure
+static const uint32_t COOLDOWN_MIN_MS   = 15UL * 1000UL;        // first OPEN period
+static const uint32_t COOLDOWN_MAX_MS   = 5UL * 60UL * 1000UL;  // OPEN period cap (doubles each failed trial)
+static const uint32_t TRIAL_MAX_MS      = 2UL * SLOW_REQUEST_MS; // trial never reported this long -> failed
+
+static CloudHealthStats g_health = {BREAKER_CLOSED, 0, 0, 0, 0, 0, 0, 0, COOLDOWN_MIN_MS};
+static unsigned long g_openedAtMs = 0;
+static bool g_trialInFlight = false;     // HALF_OPEN: the single trial request is running
+static unsigned long g_trialStartMs = 0;
+
+static const char* stateName(BreakerState s) {
+  switch (s) {
+    case BREAKER_CLOSED:    return "CLOSED";
+    case BREAKER_OPEN:      return "OPEN";
+    case BREAKER_HALF_OPEN: return "HALF_OPEN";
+  }
+  return "?";
+}
+
+static void setState(BreakerState s) {
+  if (g_health.state == s) return;
+  Serial.printf("[Health] breaker %s -> %s (cooldown=%lu ms)\n",
+                stateName(g_health.state), stateName(s),
+                (unsigned long)g_health.cooldownMs);
+  g_health.state = s;
+}
+
+static void tripOpen() {
+  g_openedAtMs = millis();
+  g_health.opens++;
+  g_trialInFlight = false;
+  setState(BREAKER_OPEN);
+}
+
+static void failedTrial() {
+  // trial failed -> back off longer
+  g_health.cooldownMs *= 2;
+  if (g_health.cooldownMs > COOLDOWN_MAX_MS) g_health.cooldownMs = COOLDOWN_MAX_MS;
+  tripOpen();
+}
+
+// OPEN -> HALF_OPEN once the cooldown passed; a lost trial counts as failed
+static void updateState() {
+  if (g_health.state == BREAKER_OPEN && (millis() - g_openedAtMs) >= g_health.cooldownMs) {
+    setState(BREAKER_HALF_OPEN);
+  }
+  if (g_health.state == BREAKER_HALF_OPEN && g_trialInFlight &&
+      (millis() - g_trialStartMs) > TRIAL_MAX_MS) {
+    Serial.println("[Health] trial request never reported -> counted as failed");
+    g_health.failures++;
+    g_health.consecutiveFailures++;
+    failedTrial();
+  }
+}
+
+bool cloudHealthCanRequest() {
+  updateState();
+  if (g_health.state == BREAKER_OPEN) return false;
+  return !(g_health.state == BREAKER_HALF_OPEN && g_trialInFlight);
+}
+
+bool cloudHealthAllowRequest() {
+  if (!cloudHealthCanRequest()) return false;
+  if (g_health.state == BREAKER_HALF_OPEN) {
+    // the one trial request; everyone else waits for its outcome
+    g_trialInFlight = true;
+    g_trialStartMs = millis();
+  }
+  return true;
+}
+
+void cloudHealthRecord(bool ok, uint32_t latencyMs) {
+  if (latencyMs > SLOW_REQUEST_MS) ok = false;
+  g_trialInFlight = false;
+
+  g_health.requests++;
+  g_health.lastLatencyMs = latencyMs;
+  if (latencyMs > g_health.maxLatencyMs) g_health.maxLatencyMs = latencyMs;
+
+  if (ok) {
+    g_health.avgLatencyMs = (g_health.avgLatencyMs == 0)
+                                ? latencyMs
+                                : (g_health.avgLatencyMs * 7 + latencyMs) / 8;
+    g_health.consecutiveFailures = 0;
+    if (g_health.state != BREAKER_CLOSED) {
+      g_health.cooldownMs = COOLDOWN_MIN_MS;
+      setState(BREAKER_CLOSED);
+    }
+    return;
+  }
+
+  g_health.failures++;
+  g_health.consecutiveFailures++;
+
+  if (g_health.state == BREAKER_HALF_OPEN) {
+    failedTrial();
+    return;
+  }
+
+  if (g_health.state == BREAKER_CLOSED &&
+      g_health.consecutiveFailures >= FAILURES_TO_OPEN) {
+    tripOpen();
+  }
+}
+
+BreakerState cloudHealthState() {
+  return g_health.state;
+}
+
+void cloudHealthGetStats(CloudHealthStats &out) {
+  out = g_health;
+}
+
+void cloudHealthReset() {
+  g_trialInFlight = false;
+  g_health.consecutiveFailures = 0;
+  g_health.cooldownMs = COOLDOWN_MIN_MS;
+  setState(BREAKER_CLOSED);
+}
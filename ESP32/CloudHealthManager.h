@@ -0,0 +1,47 @@
+#ifndef CLOUDHEALTHMANAGER_H
+#define CLOUDHEALTHMANAGER_H
+
+#include <stdint.h>
+
+// Cloud (Firebase) health tracking + circuit breaker.
+// Every real Firebase request reports its outcome and latency here.
+//  CLOSED    : requests go through normally
+//  OPEN      : too many failures -> requests are skipped (no blocking timeouts),
+//              the device runs on the local schedule + queue
+//  HALF_OPEN : cooldown passed -> one trial request decides CLOSED / OPEN again
+enum BreakerState {
+  BREAKER_CLOSED,
+  BREAKER_OPEN,
+  BREAKER_HALF_OPEN
+};
+
+struct CloudHealthStats {
+  BreakerState state;
+  uint32_t requests;
+  uint32_t failures;
+  uint32_t consecutiveFailures;
+  uint32_t lastLatencyMs;
+  uint32_t avgLatencyMs;      // moving average (successful requests)
+  uint32_t maxLatencyMs;
+  uint32_t opens;             // how many times the breaker tripped
+  uint32_t cooldownMs;        // current OPEN cooldown
+};
+
+// false while the breaker is OPEN (caller should go local immediately).
+// In HALF_OPEN the first caller gets the trial; others get false until
+// cloudHealthRecord() reports it. Every true must be followed by a record.
+bool cloudHealthAllowRequest();
+
+// Same answer without claiming the trial (status checks)
+bool cloudHealthCanRequest();
+
+// Report one finished request (slow requests count as failures)
+void cloudHealthRecord(bool ok, uint32_t latencyMs);
+
+BreakerState cloudHealthState();
+void cloudHealthGetStats(CloudHealthStats &out);
+
+// Forget history (e.g. WiFi just came back)
+void cloudHealthReset();
+
+#endif
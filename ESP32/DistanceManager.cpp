@@ -1,5 +1,6 @@
 #include "Adafruit_VL53L0X.h"
 #include "DistanceManager.h"
+#include "SpscQueue.h"
 #include <Wire.h>
 
 // ---------- VL53L0X distance sensor configuration ----------
@@ -13,6 +14,10 @@ unsigned long lastMeasureMillisDist = 0;
 unsigned long now_distance = 0;
 const unsigned long MEASURE_INTERVAL_MS = 200;  // Distance measurement interval (ms)
 
+// Sensor task (distanceAttachTask): measured there, results to loop()
+static SpscQueue<bool, 16> g_emptySamples;      // sensor task -> loop()
+static bool g_taskMode = false;
+
 void initDistance(){ //setup for distance sensor
 
     // I2C for VL53L0X
@@ -25,18 +30,40 @@ void initDistance(){ //setup for distance sensor
   }
 }
 
+// One ranging; false = out of range (last result kept)
+static bool measureEmpty(bool &empty) {
+    VL53L0X_RangingMeasurementData_t measure;
+    lox.rangingTest(&measure, false);
+    if (measure.RangeStatus == 4) return false;  // 4 = out of range
+    distance_mm = measure.RangeMilliMeter;
+    empty = (distance_mm > EMPTY_THRESHOLD_MM);
+    return true;
+}
+
 void updateDistance(){ //measure distance
+    if (g_taskMode) {
+        // newest result from the sensor task
+        bool empty;
+        while (g_emptySamples.pop(empty)) containerIsEmpty = empty;
+        return;
+    }
+
     now_distance = millis();
     if (now_distance - lastMeasureMillisDist < MEASURE_INTERVAL_MS) 
         return;
     lastMeasureMillisDist = now_distance;
 
-    VL53L0X_RangingMeasurementData_t measure;
-    lox.rangingTest(&measure, false);
-    if (measure.RangeStatus != 4) {  // 4 = out of range
-        distance_mm = measure.RangeMilliMeter;
-        containerIsEmpty= (distance_mm > EMPTY_THRESHOLD_MM);
-    }
+    bool empty;
+    if (measureEmpty(empty)) containerIsEmpty = empty;
+}
+
+void distanceAttachTask() {
+    g_taskMode = true;
+}
+
+void distanceTaskTick() {
+    bool empty;
+    if (measureEmpty(empty)) (void)g_emptySamples.push(empty);  // full -> dropped, see scaleTaskTick()
 }
 
 bool isContainerEmpty() {
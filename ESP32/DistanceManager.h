@@ -4,4 +4,11 @@
 void updateDistance();
 void initDistance();
 bool isContainerEmpty();
+
+// Sensor task (TaskManager): after distanceAttachTask() the VL53L0X is only
+// read by that task and updateDistance() takes its newest result.
+void distanceAttachTask();
+
+// Sensor task only: one measurement for loop()
+void distanceTaskTick();
 #endif
\ No newline at end of file
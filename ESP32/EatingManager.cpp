@@ -0,0 +1,99 @@
+#include "EatingManager.h"
+#include <Arduino.h>
+
+static const float STABLE_BAND_G            = 3.0f;    // readings inside this band = bowl settled
+static const uint32_t STABLE_MS             = 3000;    // band held this long -> settled level
+static const uint32_t SESSION_END_QUIET_MS  = 90000;   // settled this long after the last activity -> session over
+static const float MIN_EATEN_G              = 2.0f;    // less removed = bump / noise, not a session
+
+static bool g_running = false;
+
+// current stability window
+static float g_winMin = 0.0f;
+static float g_winMax = 0.0f;
+static unsigned long g_winStartMs = 0;
+
+static float g_level = 0.0f;                // last settled level
+
+static bool g_inSession = false;
+static float g_sessionStartLevel = 0.0f;
+static unsigned long g_sessionStartMs = 0;
+static unsigned long g_lastMoveMs = 0;
+
+static bool g_haveResult = false;
+static EatingSession g_result;
+
+static void restartWindow(float grams, unsigned long nowMs) {
+  g_winMin = grams;
+  g_winMax = grams;
+  g_winStartMs = nowMs;
+}
+
+void eatingStart(float bowlGrams) {
+  g_running = true;
+  g_level = bowlGrams;
+  g_inSession = false;
+  restartWindow(bowlGrams, millis());
+}
+
+void eatingStop() {
+  // a session cut short by the next feed is not reported (the feed-start
+  // path accounts for everything eaten by then)
+  g_running = false;
+  g_inSession = false;
+}
+
+void eatingSample(float grams) {
+  if (!g_running) return;
+  const unsigned long nowMs = millis();
+
+  if (grams < g_winMin) g_winMin = grams;
+  if (grams > g_winMax) g_winMax = grams;
+
+  if (g_winMax - g_winMin > STABLE_BAND_G) {
+    // bowl moving
+    if (!g_inSession) {
+      g_inSession = true;
+      g_sessionStartLevel = g_level;
+      g_sessionStartMs = nowMs;
+    }
+    g_lastMoveMs = nowMs;
+    restartWindow(grams, nowMs);
+    return;
+  }
+
+  if ((nowMs - g_winStartMs) < STABLE_MS) return;
+
+  // windows roll every STABLE_MS, so slow drift (temperature, creep) is
+  // never mistaken for activity
+  const float settled = 0.5f * (g_winMin + g_winMax);
+  restartWindow(grams, nowMs);
+  if (!g_inSession) {
+    g_level = settled; // follows slow drift while nobody is at the bowl
+    return;
+  }
+  if ((nowMs - g_lastMoveMs) < SESSION_END_QUIET_MS) return;
+
+  g_inSession = false;
+  g_level = settled;
+
+  const float removed = g_sessionStartLevel - settled;
+  if (removed < MIN_EATEN_G) return;
+
+  g_result.startMs = (uint32_t)g_sessionStartMs;
+  g_result.durationMs = (uint32_t)(g_lastMoveMs - g_sessionStartMs);
+  g_result.gramsRemoved = removed;
+  g_result.levelAfter = settled;
+  g_haveResult = true;
+}
+
+bool eatingPollSession(EatingSession &out) {
+  if (!g_haveResult) return false;
+  out = g_result;
+  g_haveResult = false;
+  return true;
+}
+
+bool eatingActive() {
+  return g_running && g_inSession;
+}
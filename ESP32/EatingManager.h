@@ -0,0 +1,38 @@
+#ifndef EATINGMANAGER_H
+#define EATINGMANAGER_H
+
+#include <stdint.h>
+
+// Eating-session detector on the idle weight stream (constant memory):
+// - the bowl is "settled" when the reading stays inside a small band for a
+//   few seconds; leaving the band = activity (dog at the bowl)
+// - a session runs from the first activity until the bowl has been settled
+//   again for SESSION_END_QUIET_MS (short pauses between bites stay inside)
+// - grams removed = settled level before - settled level after; sessions
+//   that removed almost nothing (bowl bumped) are dropped
+// So the meal record / daily stats can be finalized minutes after the dog
+// stops eating instead of at the next feed.
+
+struct EatingSession {
+  uint32_t startMs;        // millis() of the first activity
+  uint32_t durationMs;     // first -> last activity
+  float gramsRemoved;
+  float levelAfter;        // settled bowl weight after the session (g)
+};
+
+// Feed finished: bowl weight now (g); detection starts
+void eatingStart(float bowlGrams);
+
+// Feed starting / scale re-zeroed: detection paused until eatingStart()
+void eatingStop();
+
+// Every idle loop with the current (filtered) weight
+void eatingSample(float grams);
+
+// true once per finished session
+bool eatingPollSession(EatingSession &out);
+
+// A session is running (dog at the bowl)
+bool eatingActive();
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef EVENTBUS_H
+#define EVENTBUS_H
+
+#include <Arduino.h>
+#include <stdint.h>
+
+// Typed event bus for the loop() task (no heap, no virtuals):
+// - one static subscriber table per event type; the table is picked by the
+//   event's C++ type at compile time, so publishing is a plain loop over
+//   that table (O(subscribers)), nothing is looked up at run time
+// - subscribers are added once in setup() and run in subscription order,
+//   synchronously, in the task that publishes (loop() only; the motion and
+//   sensor tasks talk through their SpscQueues)
+// - events carry what the subscribers need, so no subscriber depends on
+//   another having run first
+
+#define EVENT_MAX_SUBSCRIBERS 4   // per event type
+
+template <typename E>
+class EventChannel {
+ public:
+  typedef void (*Handler)(const E &event);
+
+  static bool subscribe(Handler handler) {
+    if (count_ >= EVENT_MAX_SUBSCRIBERS) {
+      Serial.println("[Events] subscriber table full");
+      return false;
+    }
+    handlers_[count_++] = handler;
+    return true;
+  }
+
+  static void publish(const E &event) {
+    for (uint8_t i = 0; i < count_; i++) handlers_[i](event);
+  }
+
+ private:
+  static Handler handlers_[EVENT_MAX_SUBSCRIBERS];
+  static uint8_t count_;
+};
+
+template <typename E>
+typename EventChannel<E>::Handler EventChannel<E>::handlers_[EVENT_MAX_SUBSCRIBERS] = {};
+template <typename E>
+uint8_t EventChannel<E>::count_ = 0;
+
+template <typename E>
+inline bool eventSubscribe(void (*handler)(const E &)) {
+  return EventChannel<E>::subscribe(handler);
+}
+
+template <typename E>
+inline void eventPublish(const E &event) {
+  EventChannel<E>::publish(event);
+}
+
+// ---------- Feeder events ----------
+
+// A feed was asked for (button, schedule, offline interval, app)
+struct FeedRequested {
+  float portionGrams;
+};
+
+enum FeedEndReason : uint8_t {
+  FEED_END_TARGET_REACHED,
+  FEED_END_TIMEOUT,        // target not reached after every recovery wiggle
+  FEED_END_EMPTY,          // container ran empty
+  FEED_END_DISABLED,       // motor disabled
+  FEED_END_CANCELLED       // app "cancel"
+};
+
+// A running feed stopped (published once per feed)
+struct FeedEnded {
+  FeedEndReason reason;
+  uint64_t eventId;        // the feed's event ID
+  float bowlGrams;         // bowl weight when it stopped
+};
+
+// Debounced container level changed
+struct ContainerChanged {
+  bool empty;
+};
+
+// WiFi link went down / came back
+struct WifiChanged {
+  bool connected;
+};
+
+#endif
@@ -0,0 +1,27 @@
+#include "EventIdManager.h"
+#include <Arduino.h>
+#include <stdio.h>
+
+static uint32_t g_bootId = 0;
+static uint32_t g_seq = 0;
+
+void initEventIds(uint32_t bootCounter) { // set the high half of all IDs issued this boot
+  g_bootId = bootCounter;
+  g_seq = 0;
+  Serial.printf(" Event IDs: boot=%lu\n", (unsigned long)g_bootId);
+}
+
+uint64_t eventIdNext() { // generate a unique id (boot counter + sequence)
+  g_seq++; // starts at 1, so an ID is never EVENT_ID_NONE (bootCounter >= 1)
+  return ((uint64_t)g_bootId << 32) | (uint64_t)g_seq;
+}
+
+uint32_t eventIdBoot(uint64_t id) {
+  return (uint32_t)(id >> 32);
+}
+
+void eventIdToKey(uint64_t id, char *out, size_t outSize) {
+  if (!out || outSize == 0) return;
+  snprintf(out, outSize, "e%08lx%08lx",
+           (unsigned long)(id >> 32), (unsigned long)(id & 0xFFFFFFFFUL));
+}
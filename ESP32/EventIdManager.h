@@ -0,0 +1,28 @@
+#ifndef EVENTIDMANAGER_H
+#define EVENTIDMANAGER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// 64-bit event IDs: (bootCounter << 32) | sequence
+// - bootCounter is persisted in NVS and incremented every boot
+// - sequence restarts at 1 on each boot
+// so IDs never collide (same second / reboot without NTP) and only grow.
+#define EVENT_ID_NONE 0ULL
+
+// "e" + 16 hex digits + '\0' (sorts the same way as the numeric ID)
+#define EVENT_KEY_SIZE 18
+
+// Call once in setup(), after the boot counter was incremented
+void initEventIds(uint32_t bootCounter);
+
+// Next unique ID (never EVENT_ID_NONE)
+uint64_t eventIdNext();
+
+// Boot counter part of an ID
+uint32_t eventIdBoot(uint64_t id);
+
+// RTDB key for an ID, used as the dedupe key for every cloud write
+void eventIdToKey(uint64_t id, char *out, size_t outSize);
+
+#endif
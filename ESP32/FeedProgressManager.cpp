@@ -0,0 +1,202 @@
+#include "FeedProgressManager.h"
+#include "EventIdManager.h"
+#include <Arduino.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+static const uint32_t PROGRESS_MIN_INTERVAL_MS = 250;   // 4 Hz cap
+static const uint32_t PROGRESS_RATE_WINDOW_MS  = 500;   // flow rate measured over this window
+static const uint32_t PROGRESS_FINAL_GIVEUP_MS = 5000;  // final write still not taken -> drop it
+
+#define PROGRESS_PAYLOAD_MAX 160
+
+// ---------------- Fields (fixed slots, integer units) ----------------
+enum Field {
+  F_GRAMS,  // dispensed (0.1 g)
+  F_RATE,   // flow rate (0.1 g/s)
+  F_ETA,    // seconds left (-1 = unknown)
+  F_COUNT
+};
+
+struct FieldDef {
+  const char* key;
+  int32_t deadband;  // change needed before the field is sent again
+  int32_t scale;     // printed as value / scale
+};
+
+static const FieldDef kFields[F_COUNT] = {
+  {"g", 5, 10},   // 0.5 g
+  {"fr", 2, 10},  // 0.2 g/s
+  {"eta", 1, 1},
+};
+
+static int32_t g_cur[F_COUNT];
+static int32_t g_sent[F_COUNT];
+
+static bool g_tracking = false;      // a feed is running or its final write is pending
+static bool g_final = false;         // feed ended; send the rest, then stop
+static bool g_startSent = false;     // first write of this feed (sends everything)
+static char g_eventKey[EVENT_KEY_SIZE];
+static char g_state[12];
+static char g_sentState[12];
+static float g_targetGrams = 0.0f;
+static float g_startWeight = 0.0f;
+
+static float g_rate = 0.0f;          // smoothed g/s
+static bool g_rateValid = false;     // first window seeds the average
+static float g_rateWeight = 0.0f;    // weight at the start of the current rate window
+static unsigned long g_rateMs = 0;
+
+static unsigned long g_lastSendMs = 0;
+static unsigned long g_endMs = 0;
+
+static char g_payload[PROGRESS_PAYLOAD_MAX];
+
+static void setState(const char* s) {
+  strncpy(g_state, s, sizeof(g_state) - 1);
+  g_state[sizeof(g_state) - 1] = '\0';
+}
+
+static void updateFields(float weightGrams) {
+  float grams = weightGrams - g_startWeight;
+  if (grams < 0.0f) grams = 0.0f;
+
+  unsigned long nowMs = millis();
+  uint32_t dt = (uint32_t)(nowMs - g_rateMs);
+  if (dt >= PROGRESS_RATE_WINDOW_MS) {
+    float inst = (weightGrams - g_rateWeight) * 1000.0f / (float)dt;
+    if (inst < 0.0f) inst = 0.0f;  // bowl bumped / scale noise
+    g_rate = g_rateValid ? 0.5f * g_rate + 0.5f * inst : inst;
+    g_rateValid = true;
+    g_rateWeight = weightGrams;
+    g_rateMs = nowMs;
+  }
+
+  float left = g_targetGrams - grams;
+  int32_t eta;
+  if (left <= 0.0f) eta = 0;
+  else if (g_rate >= 0.2f) eta = (int32_t)ceilf(left / g_rate);
+  else eta = -1;
+
+  g_cur[F_GRAMS] = (int32_t)lroundf(grams * 10.0f);
+  g_cur[F_RATE] = (int32_t)lroundf(g_rate * 10.0f);
+  g_cur[F_ETA] = eta;
+}
+
+void feedProgressBegin(uint64_t eventId, float targetGrams, float startWeight) {
+  eventIdToKey(eventId, g_eventKey, sizeof(g_eventKey));
+  g_targetGrams = targetGrams;
+  g_startWeight = startWeight;
+  g_rate = 0.0f;
+  g_rateValid = false;
+  g_rateWeight = startWeight;
+  g_rateMs = millis();
+  setState("running");
+  g_sentState[0] = '\0';
+
+  updateFields(startWeight);
+  memset(g_sent, 0, sizeof(g_sent));
+
+  g_tracking = true;
+  g_final = false;
+  g_startSent = false;
+  g_lastSendMs = 0;
+}
+
+void feedProgressSample(float weightGrams, bool recovering) {
+  if (!g_tracking || g_final) return;
+  setState(recovering ? "recovering" : "running");
+  updateFields(weightGrams);
+}
+
+void feedProgressEnd(const char* result, float weightGrams) {
+  if (!g_tracking || g_final) return;
+  updateFields(weightGrams);
+  g_cur[F_RATE] = 0;
+  g_cur[F_ETA] = 0;
+  setState(result ? result : "done");
+  g_final = true;
+  g_endMs = millis();
+}
+
+bool feedProgressActive() {
+  return g_tracking;
+}
+
+// Appends to g_payload; false if it would not fit
+static bool appendField(size_t &len, const char* fmt, const char* key, long whole, long frac, bool withFrac) {
+  int n = withFrac ? snprintf(g_payload + len, sizeof(g_payload) - len, fmt, key, whole, frac)
+                   : snprintf(g_payload + len, sizeof(g_payload) - len, fmt, key, whole);
+  if (n < 0 || len + (size_t)n >= sizeof(g_payload)) return false;
+  len += (size_t)n;
+  return true;
+}
+
+// Builds the delta write; returns false if there is nothing to send
+static bool buildPayload() {
+  size_t len = 0;
+  int n;
+  if (!g_startSent) {
+    n = snprintf(g_payload, sizeof(g_payload), "{\"ev\":\"%s\",\"tg\":%ld,",
+                 g_eventKey, (long)lroundf(g_targetGrams));
+  } else {
+    n = snprintf(g_payload, sizeof(g_payload), "{");
+  }
+  if (n < 0 || (size_t)n >= sizeof(g_payload)) return false;
+  len = (size_t)n;
+  const size_t emptyLen = len;
+
+  bool ok = true;
+  if (!g_startSent || strcmp(g_state, g_sentState) != 0) {
+    n = snprintf(g_payload + len, sizeof(g_payload) - len, "\"st\":\"%s\",", g_state);
+    ok = (n > 0 && len + (size_t)n < sizeof(g_payload));
+    if (ok) len += (size_t)n;
+  }
+
+  for (int i = 0; i < F_COUNT && ok; i++) {
+    int32_t d = g_cur[i] - g_sent[i];
+    if (d < 0) d = -d;
+    // final write: exact values, no deadband
+    if (g_startSent && (g_final ? d == 0 : d < kFields[i].deadband)) continue;
+
+    const int32_t v = g_cur[i];
+    if (kFields[i].scale == 1) {
+      ok = appendField(len, "\"%s\":%ld,", kFields[i].key, (long)v, 0, false);
+    } else {
+      const int32_t a = v < 0 ? -v : v;
+      ok = appendField(len, v < 0 ? "\"%s\":-%ld.%ld," : "\"%s\":%ld.%ld,", kFields[i].key,
+                       (long)(a / kFields[i].scale), (long)(a % kFields[i].scale), true);
+    }
+  }
+  if (!ok || len == emptyLen) return false;
+
+  n = snprintf(g_payload + len, sizeof(g_payload) - len, "\"ts\":{\".sv\":\"timestamp\"}}");
+  return n > 0 && len + (size_t)n < sizeof(g_payload);
+}
+
+bool feedProgressTick(FeedProgressUploadFn uploadFn) {
+  if (!g_tracking || !uploadFn) return false;
+  if (g_startSent && (millis() - g_lastSendMs) < PROGRESS_MIN_INTERVAL_MS) return false;
+
+  if (!buildPayload()) {
+    if (g_final) g_tracking = false;  // cloud already has the final values
+    return false;
+  }
+
+  if (!uploadFn(g_payload)) {
+    // busy / breaker open: keep the delta; give up on a stale final write
+    if (g_final && (millis() - g_endMs) > PROGRESS_FINAL_GIVEUP_MS) {
+      Serial.println("[Progress] final write dropped");
+      g_tracking = false;
+    }
+    return false;
+  }
+
+  memcpy(g_sent, g_cur, sizeof(g_sent));
+  strncpy(g_sentState, g_state, sizeof(g_sentState));
+  g_startSent = true;
+  g_lastSendMs = millis();
+  if (g_final) g_tracking = false;
+  return true;
+}
@@ -0,0 +1,41 @@
+#ifndef FEEDPROGRESSMANAGER_H
+#define FEEDPROGRESSMANAGER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Live feeding progress for the app, merged into /status/feeding while a
+// feed runs:
+// - throttled: at most one write every 250 ms (4 Hz), and the upload is
+//   async so the stepper keeps getting its updateMotor() calls
+// - delta encoded: only fields that moved past their deadband since the
+//   last write are sent
+// - one final write (result + final grams) when the feed stops, then quiet
+//
+// Node fields (short keys, like the telemetry heartbeat):
+//   ev  event key of the feeding     st  running/recovering/<result>
+//   tg  target grams                 g   dispensed grams (0.1 g)
+//   fr  flow rate (g/s, 0.1)         eta seconds left (-1 = unknown)
+//   ts  server time of the last write
+
+// Upload-callback (we will pass firebasePublishFeedProgress here).
+// Returns false if it could not take the write now (kept for the next tick).
+typedef bool (*FeedProgressUploadFn)(const char *json);
+
+// Motor started for this feeding (startWeight = scale reading at start)
+void feedProgressBegin(uint64_t eventId, float targetGrams, float startWeight);
+
+// Every loop() while FEED_ACTIVE
+void feedProgressSample(float weightGrams, bool recovering);
+
+// Feed stopped; result = "done" / "timeout" / "empty" / "disabled" / "cancelled".
+// Ignored if no feed is being tracked.
+void feedProgressEnd(const char *result, float weightGrams);
+
+// Every loop(); sends when due. Returns true if a write went out.
+bool feedProgressTick(FeedProgressUploadFn uploadFn);
+
+// A feed is running or its final write is still pending
+bool feedProgressActive();
+
+#endif
@@ -13,26 +13,69 @@
 #include <cstring>
 #include <math.h>   // lroundf
 #include "LocalManager.h"
+#include "EventIdManager.h"
+#include "JsonPool.h"
+#include "CloudHealthManager.h"
+#include "ScheduleManager.h"
 #include "Secrets.h"
 
 
 
+// Root CA (PEM) used to pin the Firebase/Google servers. Leave empty in
+// Secrets.h to fall back to setInsecure().
+#ifndef FIREBASE_ROOT_CA
+#define FIREBASE_ROOT_CA ""
+#endif
+
+// ---------------- TLS connection metering ----------------
+// Every (re)connect of the secure client is a full TLS handshake (~1-2 s CPU,
+// ~40 KB heap on the ESP32), so we count and time them.
+static FirebaseTlsStats g_tlsStats = {0, 0, 0, 0, 0, 0};
+
+class MeteredSecureClient : public WiFiClientSecure {
+public:
+  using WiFiClientSecure::connect;
+
+  int connect(const char *host, uint16_t port) override {
+    const uint32_t heapBefore = ESP.getFreeHeap();
+    const unsigned long t0 = millis();
+
+    int ok = WiFiClientSecure::connect(host, port);
+
+    const uint32_t ms = (uint32_t)(millis() - t0);
+    g_tlsStats.handshakes++;
+    if (!ok) g_tlsStats.failures++;
+    g_tlsStats.lastMs = ms;
+    g_tlsStats.totalMs += ms;
+    if (ms > g_tlsStats.maxMs) g_tlsStats.maxMs = ms;
+    g_tlsStats.lastHeapCost = (int32_t)heapBefore - (int32_t)ESP.getFreeHeap();
+
+    Serial.printf("[TLS] handshake #%lu to %s %s: %lu ms, heap cost %ld B\n",
+                  (unsigned long)g_tlsStats.handshakes,
+                  host ? host : "?",
+                  ok ? "ok" : "FAILED",
+                  (unsigned long)ms,
+                  (long)g_tlsStats.lastHeapCost);
+    return ok;
+  }
+};
+
+void firebaseGetTlsStats(FirebaseTlsStats &out) {
+  out = g_tlsStats;
+}
+
 // Auth + Firebase objects
 UserAuth user_auth(Web_API_KEY, USER_EMAIL, USER_PASS);
 FirebaseApp app;
-WiFiClientSecure ssl_client;
+MeteredSecureClient ssl_client;
 using AsyncClient = AsyncClientClass;
 AsyncClient aClient(ssl_client);
 RealtimeDatabase Database;
-bool didRead = false;
-
-// ---------------- Schedule State ----------------
-static FeedingScheduleEntry g_schedule[6];
-static bool g_firedToday[6] = {false,false,false,false,false,false};
-static int g_lastYDay = -1;
 
-// per-slot signature so changing a slot resets only that slot’s fired flag
-static uint32_t g_slotSig[6] = {0,0,0,0,0,0};
+// Second connection for the /commands stream (an open SSE stream occupies its client)
+MeteredSecureClient stream_ssl_client;
+AsyncClient streamClient(stream_ssl_client);
+bool didRead = false;
 
 static uint32_t fnv1a32(const char* s) {//helper function for parsing the schedule
   uint32_t h = 2166136261u;
@@ -44,20 +87,61 @@ static uint32_t fnv1a32(const char* s) {//helper function for parsing the schedu
   return h;
 }
 
-static uint32_t computeScheduleSig(const FeedingScheduleEntry& e) { //helper function for parsing the schedule
-  if (!e.enabled) return 0;
+// Forward declarations (used before definition)
+static bool fetchScheduleFromRTDB_V2();
+static void printLastFirebaseError(const char* ctx);
 
-  uint32_t h = 2166136261u;
-  h ^= (uint32_t)e.hour;        h *= 16777619u;
-  h ^= (uint32_t)e.minute;      h *= 16777619u;
-  h ^= (uint32_t)e.amountGrams; h *= 16777619u;
-  h ^= fnv1a32(e.mealName);     h *= 16777619u;
+// ---------------- Request accounting (cloud health) ----------------
+// Every real request goes through requestBegin()/requestEnd() so the circuit
+// breaker sees its outcome + latency. While the breaker is open we return
+// immediately instead of waiting for another timeout. Writers check
+// app.ready() first: not authenticated yet (boot) is not a backend failure.
+static unsigned long g_requestStartMs = 0;
 
-  return h;
+static bool requestBegin() {
+  if (!cloudHealthAllowRequest()) return false;
+  g_requestStartMs = millis();
+  return true;
+}
+
+static bool requestEnd(bool ok) {
+  cloudHealthRecord(ok, (uint32_t)(millis() - g_requestStartMs));
+  return ok;
 }
 
-// Forward declaration (used in firebaseLoop before definition)
-static void fetchScheduleFromRTDB_V2();
+// ---------------- Schedule change probe ----------------
+// The app bumps /feedings_version (server timestamp) on every schedule edit.
+// We read that tiny node and download /feedings only when it moved.
+// (RTDB ETags only guard writes via if-match; a GET never returns 304.)
+static const char* kFeedingsVersionPath = "/feedings_version";
+static String g_feedingsVersion;                 // version of the parsed schedule ("" = unknown)
+static uint32_t g_scheduleBodyHash = 0;          // hash of the last parsed /feedings body
+static bool g_haveScheduleBodyHash = false;
+static unsigned long g_lastFullFetchMs = 0;
+static const unsigned long FULL_FETCH_MAX_AGE_MS = 10UL * 60UL * 1000UL; // safety refresh
+
+// Returns true if /feedings must be downloaded; outVersion = current version
+static bool scheduleNeedsFetch(String &outVersion) {
+  outVersion = "";
+  if (!requestBegin()) return false;
+
+  outVersion = Database.get<String>(aClient, kFeedingsVersionPath);
+  if (!requestEnd(aClient.lastError().code() == 0)) {
+    outVersion = "";
+    return true; // can't tell -> fetch
+  }
+
+  if (outVersion.length() == 0 || outVersion == "null") {
+    outVersion = "";
+    return true; // no version published (older app) -> always fetch
+  }
+
+  if (g_lastFullFetchMs == 0 || (millis() - g_lastFullFetchMs) >= FULL_FETCH_MAX_AGE_MS) {
+    return true;
+  }
+
+  return outVersion != g_feedingsVersion;
+}
 
 void firebaseCB(AsyncResult &aResult) { //deprecated function, we dont use it
   if (!aResult.isResult()) return;
@@ -81,354 +165,143 @@ void firebaseCB(AsyncResult &aResult) { //deprecated function, we dont use it
   }
 }
 
-// Parse time string (ISO or HH:MM[:SS])
-static bool parseHourMinute(const char* s, int &hourOut, int &minuteOut) { // helper function for parsing meals
-  if (!s || !*s) return false;
-
-  const char* t = strchr(s, 'T');
-  const char* p = (t) ? (t + 1) : s;
-
-  if (!(p[0] && p[1] && p[2] == ':' && p[3] && p[4])) return false;
-
-  hourOut = (p[0]-'0')*10 + (p[1]-'0');
-  minuteOut = (p[3]-'0')*10 + (p[4]-'0');
-
-  if (hourOut < 0 || hourOut > 23 || minuteOut < 0 || minuteOut > 59) return false;
-  return true;
-}
-
-// Reset the "fired" flags once per new day
-static void resetDailyFiredIfNeeded() { // helps to make sure we only deploy each feeding once
-  time_t now = time(nullptr);
-  if (now < 100000) return;
-
-  struct tm tmNow;
-  localtime_r(&now, &tmNow);
+static bool g_appInitialized = false;
 
-  if (g_lastYDay == -1) {
-    g_lastYDay = tmNow.tm_yday;
+void initFirebase() { //initialize connection to firebase
+  // Called again after every WiFi reconnect. Re-initializing the app would
+  // drop the keep-alive connection and the auth token (= extra handshakes)
+  // and wipe the schedule/fired state, so only the first call does the work.
+  if (g_appInitialized) {
+    Serial.println("Firebase already initialized -> reusing app + connection");
     return;
   }
+  g_appInitialized = true;
 
-  if (tmNow.tm_yday != g_lastYDay) {
-    g_lastYDay = tmNow.tm_yday;
-    for (int i = 0; i < 6; i++) g_firedToday[i] = false;
+  if (strlen(FIREBASE_ROOT_CA) > 0) {
+    ssl_client.setCACert(FIREBASE_ROOT_CA);
+    stream_ssl_client.setCACert(FIREBASE_ROOT_CA);
+  } else {
+    Serial.println("[TLS] FIREBASE_ROOT_CA not set -> server certificate NOT verified");
+    ssl_client.setInsecure();
+    stream_ssl_client.setInsecure();
   }
-}
-
-void initFirebase() { //initialize connection to firebase
-  ssl_client.setInsecure();
 
   initializeApp(aClient, app, getAuth(user_auth), firebaseCB, "authTask");
   app.getApp<RealtimeDatabase>(Database);
   Database.url(DATABASE_URL);
 
-  for (int i = 0; i < 6; i++) {
-    g_schedule[i].enabled = false;
-    g_schedule[i].hour = 0;
-    g_schedule[i].minute = 0;
-    g_schedule[i].amountGrams = 0;
-    g_schedule[i].mealName[0] = '\0';
-
-    g_firedToday[i] = false;
-    g_slotSig[i] = 0;
-  }
-
   Serial.println("Firebase init done, waiting for app.ready()...");
 }
 
-// (Legacy) Fetch "/feedings" as one JSON string and update g_schedule[].
-static void fetchScheduleFromRTDB() { // deprecated function, we dont use it
-  String json = Database.get<String>(aClient, "/feedings");
-
-  if (json.length() == 0 || json == "null") {
-    Serial.println("No feedings found at /feedings");
-    return;
-  }
-
-  DynamicJsonDocument doc(2048);
-  DeserializationError err = deserializeJson(doc, json);
-  if (err) {
-    Serial.print("deserializeJson failed: ");
-    Serial.println(err.c_str());
-    return;
-  }
-
-  for (int i = 0; i < 6; i++) {
-    g_schedule[i].enabled = false;
-    g_schedule[i].hour = 0;
-    g_schedule[i].minute = 0;
-    g_schedule[i].amountGrams = 0;
-    g_schedule[i].mealName[0] = '\0';
-  }
-
-  if (doc.is<JsonObject>()) {
-    JsonObject root = doc.as<JsonObject>();
-
-    for (int i = 0; i < 6; i++) {
-      String key = String(i);
-      if (!root.containsKey(key)) continue;
-
-      JsonObject feeding = root[key].as<JsonObject>();
-
-      const char* timeStr = feeding["timeOfFeeding"]   | "";
-      int amount          = feeding["amountOfFeeding"] | 0;
-
-      int hh = 0, mm = 0;
-      if (!parseHourMinute(timeStr, hh, mm)) continue;
-      if (amount <= 0) continue;
-
-      const char* mealStr = feeding["meal_name"] | "";
-
-      g_schedule[i].enabled = true;
-      g_schedule[i].hour = hh;
-      g_schedule[i].minute = mm;
-      g_schedule[i].amountGrams = amount;
-      strncpy(g_schedule[i].mealName, mealStr, sizeof(g_schedule[i].mealName) - 1);
-      g_schedule[i].mealName[sizeof(g_schedule[i].mealName) - 1] = '\0';
-    }
-  } else if (doc.is<JsonArray>()) {
-    JsonArray arr = doc.as<JsonArray>();
-    for (int i = 0; i < (int)arr.size() && i < 6; i++) {
-      JsonObject feeding = arr[i].as<JsonObject>();
-
-      const char* timeStr = feeding["timeOfFeeding"]   | "";
-      int amount          = feeding["amountOfFeeding"] | 0;
-
-      int hh = 0, mm = 0;
-      if (!parseHourMinute(timeStr, hh, mm)) continue;
-      if (amount <= 0) continue;
-
-      const char* mealStr = feeding["meal_name"] | "";
-
-      g_schedule[i].enabled = true;
-      g_schedule[i].hour = hh;
-      g_schedule[i].minute = mm;
-      g_schedule[i].amountGrams = amount;
-      strncpy(g_schedule[i].mealName, mealStr, sizeof(g_schedule[i].mealName) - 1);
-      g_schedule[i].mealName[sizeof(g_schedule[i].mealName) - 1] = '\0';
-    }
-  }
-
-  Serial.println(" Schedule updated from RTDB:");
-  for (int i = 0; i < 6; i++) {
-    if (!g_schedule[i].enabled) {
-      Serial.printf("#%d: (disabled)\n", i);
-      continue;
-    }
-    Serial.printf("#%d: %02d:%02d amount=%d\n",
-                  i,
-                  g_schedule[i].hour,
-                  g_schedule[i].minute,
-                  g_schedule[i].amountGrams);
-  }
-}
-
 void firebaseLoop() { // make sure we dont pull the entire schedule too soon
   app.loop();
 
-  resetDailyFiredIfNeeded();
   if (!app.ready()) return;
 
   static unsigned long lastFetchMs = 0;
   const unsigned long FETCH_INTERVAL_MS = 15UL * 1000UL;
 
-  if (lastFetchMs == 0 || (millis() - lastFetchMs) >= FETCH_INTERVAL_MS) {
-    lastFetchMs = millis();
-    fetchScheduleFromRTDB_V2();
-  }
-}
-
-bool firebaseGetDueFeeding(int &amountOut, int &feed_hour, int &feed_minute,
-                           char *mealNameOut, size_t mealNameOutSize) { // check if now is feeding time
-  amountOut = 0;
-  feed_hour = 0;
-  feed_minute = 0;
-  if (mealNameOut && mealNameOutSize > 0) {
-    mealNameOut[0] = '\0';
-  }
-
-  time_t now = time(nullptr);
-  if (now < 100000) return false;
+  static unsigned long lastTlsReportMs = 0; // TLS + cloud health report
+  const unsigned long TLS_REPORT_INTERVAL_MS = 10UL * 60UL * 1000UL;
 
-  struct tm tmNow;
-  localtime_r(&now, &tmNow);
+  if (millis() - lastTlsReportMs >= TLS_REPORT_INTERVAL_MS) {
+    lastTlsReportMs = millis();
+    Serial.printf("[TLS] handshakes=%lu failed=%lu avg=%lu ms max=%lu ms\n",
+                  (unsigned long)g_tlsStats.handshakes,
+                  (unsigned long)g_tlsStats.failures,
+                  (unsigned long)(g_tlsStats.handshakes ? g_tlsStats.totalMs / g_tlsStats.handshakes : 0),
+                  (unsigned long)g_tlsStats.maxMs);
 
-  for (int i = 0; i < 6; i++) {
-    if (!g_schedule[i].enabled) continue;
-    if (g_firedToday[i]) continue;
-
-    if (tmNow.tm_hour == g_schedule[i].hour &&
-        tmNow.tm_min  == g_schedule[i].minute) {
+    CloudHealthStats h;
+    cloudHealthGetStats(h);
+    Serial.printf("[Health] requests=%lu failed=%lu avg=%lu ms max=%lu ms breaker-opens=%lu\n",
+                  (unsigned long)h.requests,
+                  (unsigned long)h.failures,
+                  (unsigned long)h.avgLatencyMs,
+                  (unsigned long)h.maxLatencyMs,
+                  (unsigned long)h.opens);
+  }
 
-      g_firedToday[i] = true;
-      amountOut = g_schedule[i].amountGrams;
-      feed_hour = g_schedule[i].hour;
-      feed_minute = g_schedule[i].minute;
+  if (lastFetchMs == 0 || (millis() - lastFetchMs) >= FETCH_INTERVAL_MS) {
+    lastFetchMs = millis();
 
-      if (mealNameOut && mealNameOutSize > 0) {
-        strncpy(mealNameOut, g_schedule[i].mealName, mealNameOutSize - 1);
-        mealNameOut[mealNameOutSize - 1] = '\0';
-      }
+    String version;
+    if (!scheduleNeedsFetch(version)) return; // unchanged: a few bytes, no parse, no flash I/O
 
-      return true;
+    if (fetchScheduleFromRTDB_V2()) {
+      g_feedingsVersion = version;
+      g_lastFullFetchMs = millis();
     }
   }
+}
 
-  return false;
+bool firebaseGetDueFeeding(int &amountOut, int &feed_hour, int &feed_minute,
+                           char *mealNameOut, size_t mealNameOutSize) { // check if now is feeding time
+  return scheduleGetDue(time(nullptr), amountOut, feed_hour, feed_minute, mealNameOut, mealNameOutSize);
 }
 
-// New parser for DB schema:
-// /feedings/{0..5}/hour = "HH:MM"
-// /feedings/{0..5}/amount_grams = int
-// /feedings/{0..5}/meal_name = string (optional)
-static void fetchScheduleFromRTDB_V2() { // fetch schedule from firebasae and parse it
+// DB schema (parsed by ScheduleManager):
+// /feedings/<id>/hour = "HH:MM"
+// /feedings/<id>/amount_grams = int
+// /feedings/<id>/meal_name = string (optional)
+// /feedings/<id>/days = weekday mask or [0..6] (optional, default every day)
+// /feedings/<id>/every_hours = N (optional, repeat every N hours until midnight)
+static bool fetchScheduleFromRTDB_V2() { // fetch schedule from firebasae and parse it
   const char* PATH = "/feedings";
 
+  if (!requestBegin()) return false;
   String json = Database.get<String>(aClient, PATH);
+  if (!requestEnd(aClient.lastError().code() == 0)) return false;
 
   if (json.length() == 0 || json == "null") {
     Serial.printf("No feedings found at %s\n", PATH);
-    return;
-  }
-
-  // cache offline
-  localStoreScheduleIfChanged(json.c_str());
-
-  DynamicJsonDocument doc(4096);
-  DeserializationError err = deserializeJson(doc, json);
-  if (err) {
-    Serial.print("V2 deserializeJson failed: ");
-    Serial.println(err.c_str());
-    return;
-  }
-
-  for (int i = 0; i < 6; i++) {
-    g_schedule[i].enabled = false;
-    g_schedule[i].hour = 0;
-    g_schedule[i].minute = 0;
-    g_schedule[i].amountGrams = 0;
-    g_schedule[i].mealName[0] = '\0';
-  }
-
-  auto loadOne = [&](JsonObject feeding, int slot) {
-    const char* hourStr = feeding["hour"] | "";
-    int grams           = feeding["amount_grams"] | 0;
-    const char* mealStr = feeding["meal_name"] | "";
-
-    int hh = 0, mm = 0;
-    if (!parseHourMinute(hourStr, hh, mm)) return;
-    if (grams <= 0) return;
-
-    g_schedule[slot].enabled = true;
-    g_schedule[slot].hour = hh;
-    g_schedule[slot].minute = mm;
-    g_schedule[slot].amountGrams = grams;
-
-    strncpy(g_schedule[slot].mealName, mealStr, sizeof(g_schedule[slot].mealName) - 1);
-    g_schedule[slot].mealName[sizeof(g_schedule[slot].mealName) - 1] = '\0';
-  };
-
-  if (doc.is<JsonObject>()) {
-    JsonObject root = doc.as<JsonObject>();
-    for (int i = 0; i < 6; i++) {
-      String key = String(i);
-      if (!root.containsKey(key)) continue;
-
-      JsonObject feeding = root[key].as<JsonObject>();
-      if (feeding.isNull()) continue;
-
-      loadOne(feeding, i);
-    }
-  } else if (doc.is<JsonArray>()) {
-    JsonArray arr = doc.as<JsonArray>();
-    for (int i = 0; i < (int)arr.size() && i < 6; i++) {
-      JsonObject feeding = arr[i].as<JsonObject>();
-      if (feeding.isNull()) continue;
-
-      loadOne(feeding, i);
-    }
-  } else {
-    Serial.println("V2 schedule format error: expected JSON object or array under /feedings");
-    return;
+    return false;
   }
 
-  Serial.println(" Schedule updated from RTDB (V2 schema):");
-  for (int i = 0; i < 6; i++) {
-    if (!g_schedule[i].enabled) {
-      Serial.printf("#%d: (disabled)\n", i);
-    } else {
-      if (g_schedule[i].mealName[0]) {
-        Serial.printf("#%d: %02d:%02d grams=%d meal=%s\n",
-                      i, g_schedule[i].hour, g_schedule[i].minute,
-                      g_schedule[i].amountGrams, g_schedule[i].mealName);
-      } else {
-        Serial.printf("#%d: %02d:%02d grams=%d\n",
-                      i, g_schedule[i].hour, g_schedule[i].minute,
-                      g_schedule[i].amountGrams);
-      }
-    }
+  // Same body as the last successful parse -> nothing to parse or cache
+  const uint32_t bodyHash = fnv1a32(json.c_str());
+  if (g_haveScheduleBodyHash && bodyHash == g_scheduleBodyHash) {
+    return true;
   }
 
-  // reset fired flag ONLY if that slot’s schedule changed
-  for (int i = 0; i < 6; i++) {
-    uint32_t newSig = computeScheduleSig(g_schedule[i]);
+  if (!scheduleLoadJson(json.c_str(), "RTDB")) return false;
 
-    if (newSig != g_slotSig[i]) {
-      g_firedToday[i] = false;
-      g_slotSig[i] = newSig;
-      Serial.printf("[DBG] slot %d changed -> reset firedToday\n", i);
-    }
+  // cache the compiled rules for offline / next boot
+  localStoreScheduleIfChanged();
 
-    if (!g_schedule[i].enabled) {
-      g_firedToday[i] = false;
-      g_slotSig[i] = 0;
-    }
-  }
+  g_scheduleBodyHash = bodyHash;
+  g_haveScheduleBodyHash = true;
+  return true;
 }
 
 void firebaseSetContainerEmpty(bool empty) { // container is empty helper function
   app.loop();
   if (!app.ready()) return;
+  if (!requestBegin()) return;
 
-  Database.set(aClient, "/deviceState/containerEmpty", empty);
+  requestEnd(Database.set(aClient, "/deviceState/containerEmpty", empty));
 }
 
-// Finds next numeric index under /weights (0,1,2,...)
-static int getNextWeightIndex() { // helper to update weight, make sure that in db the meals have unique index number
-  const char *PATH = "/weights";
-
-  String json = Database.get<String>(aClient, PATH);
-  if (json.length() == 0 || json == "null") {
-    return 0;
-  }
-
-  DynamicJsonDocument doc(4096);
-  DeserializationError err = deserializeJson(doc, json);
-  if (err) {
-    Serial.print("getNextWeightIndex deserializeJson failed: ");
-    Serial.println(err.c_str());
-    return 0;
-  }
-
-  if (doc.is<JsonArray>()) {
-    JsonArray arr = doc.as<JsonArray>();
-    return (int)arr.size();
-  }
-
-  if (doc.is<JsonObject>()) {
-    JsonObject obj = doc.as<JsonObject>();
-    int maxIdx = -1;
-
-    for (JsonPair kv : obj) {
-      const char *k = kv.key().c_str();
-      int idx = atoi(k);
-      if (idx > maxIdx) maxIdx = idx;
-    }
-    return maxIdx + 1;
-  }
+// Fill one /weights record (same fields for the live and the queued path)
+static void fillWeightRecord(JsonObject o,
+                             int amount_grams,
+                             int feed_hour,
+                             int feed_minute,
+                             const char *meal_name,
+                             const char *day,
+                             const char *date,
+                             float prev_current_weight,
+                             float new_current_weight) {
+  char hourStr[6];
+  snprintf(hourStr, sizeof(hourStr), "%02d:%02d", feed_hour, feed_minute);
 
-  return 0;
+  o["amount_grams"]        = amount_grams;
+  o["prev_current_weight"] = (int)lroundf(prev_current_weight);
+  o["new_current_weight"]  = (int)lroundf(new_current_weight);
+  o["day"]                 = day ? day : "";
+  o["date"]                = date ? date : "";
+  o["hour"]                = hourStr;
+  o["meal_name"]           = meal_name ? meal_name : "";
 }
 
 bool update_weight(int amount_grams,
@@ -438,28 +311,31 @@ bool update_weight(int amount_grams,
                    const char *day,
                    const char *date,
                    float prev_current_weight,
-                   float new_current_weight) { //upload meal to statistics
+                   float new_current_weight,
+                   uint64_t eventId) { //upload meal to statistics
   app.loop();
   if (!app.ready()) return false;
 
-  char hourStr[6];
-  snprintf(hourStr, sizeof(hourStr), "%02d:%02d", feed_hour, feed_minute);
-
-  int prevWeightInt = (int)lroundf(prev_current_weight);
-  int newWeightInt  = (int)lroundf(new_current_weight);
+  // /weights/<eventKey>: the feeding's event ID is the dedupe key, so a retry
+  // (live, offline queue or no-clock accumulator) rewrites the same node.
+  // A fresh ID here would give every retry its own node -> callers own it.
+  if (eventId == EVENT_ID_NONE) {
+    Serial.println("update_weight: no event ID -> rejected (caller must keep one per meal)");
+    return false;
+  }
+  char key[EVENT_KEY_SIZE];
+  eventIdToKey(eventId, key, sizeof(key));
+  String base = String("/weights/") + key;
 
-  int idx = getNextWeightIndex();
-  String base = String("/weights/") + String(idx);
+  DynamicJsonDocument doc(512);
+  fillWeightRecord(doc.to<JsonObject>(), amount_grams, feed_hour, feed_minute,
+                   meal_name, day, date, prev_current_weight, new_current_weight);
 
-  bool ok = true;
+  String payload;
+  serializeJson(doc, payload);
 
-  ok &= Database.set(aClient, base + "/amount_grams", amount_grams);
-  ok &= Database.set(aClient, base + "/prev_current_weight", prevWeightInt);
-  ok &= Database.set(aClient, base + "/new_current_weight", newWeightInt);
-  ok &= Database.set(aClient, base + "/day", String(day ? day : ""));
-  ok &= Database.set(aClient, base + "/date", String(date ? date : ""));
-  ok &= Database.set(aClient, base + "/hour", String(hourStr));
-  ok &= Database.set(aClient, base + "/meal_name", String(meal_name ? meal_name : ""));
+  if (!requestBegin()) return false;
+  bool ok = requestEnd(Database.set<object_t>(aClient, base, object_t(payload)));
 
   if (ok) {
     Serial.printf(" update_weight uploaded to %s\n", base.c_str());
@@ -470,10 +346,44 @@ bool update_weight(int amount_grams,
   return ok;
 }
 
+// Upload up to WEIGHTS_BATCH_MAX queued meals with ONE multi-location update:
+// PATCH /weights { "<key>": {...}, "<key>": {...} }
+// Each record lands under its own idempotency key, so there is no /weights read
+// and re-sending the same batch after a failure just rewrites the same nodes.
+bool update_weights_batch(const WeightQueueRecord *records, size_t count) {
+  if (!records || count == 0) return true;
+
+  app.loop();
+  if (!app.ready()) return false;
+
+  DynamicJsonDocument doc(256 + count * 256);
+
+  for (size_t i = 0; i < count; i++) {
+    const WeightQueueRecord &r = records[i];
+
+    fillWeightRecord(doc[r.key].to<JsonObject>(), r.amountGrams, r.feedHour, r.feedMinute,
+                     r.mealName, r.day, r.dateISO, r.prevWeight, r.currentWeight);
+  }
+
+  String payload;
+  serializeJson(doc, payload);
+
+  if (!requestBegin()) return false;
+  bool ok = requestEnd(Database.update(aClient, "/weights", object_t(payload)));
+  if (!ok) {
+    printLastFirebaseError("RTDB batch update /weights");
+    return false;
+  }
+
+  Serial.printf(" update_weights_batch uploaded %u records (%u bytes)\n",
+                (unsigned)count, (unsigned)payload.length());
+  return true;
+}
+
 // ---------------- Container Status (RTDB) ----------------
 static const char* kContainerStatusPath = "/status/container";
 
-static int32_t makeEventIdEpochSeconds() { // generate unique id base of the time
+static int32_t nowEpochSecondsOrUptime() { // timestamp for ts/emptySince fields
   time_t now = time(nullptr);
   if (now >= 100000) return (int32_t)now;
   return (int32_t)(millis() / 1000UL);
@@ -485,7 +395,7 @@ static void printLastFirebaseError(const char* ctx) { //debugging purposes
   Serial.printf(" %s failed: code=%d msg=%s\n", ctx, code, msg.c_str());
 }
 
-bool firebasePublishContainerEmpty(bool emptyNow) { //upload container is empty notification to firebase
+bool firebasePublishContainerEmpty(bool emptyNow, uint64_t eventId) { //upload container is empty notification to firebase
   Serial.printf("[DBG] entered firebasePublishContainerEmpty empty=%d\n", emptyNow);
 
   app.loop();
@@ -494,32 +404,27 @@ bool firebasePublishContainerEmpty(bool emptyNow) { //upload container is empty
     return false;
   }
 
-  const int32_t nowSec = makeEventIdEpochSeconds();
+  const int32_t nowSec = nowEpochSecondsOrUptime();
 
-  bool ok = Database.set<bool>(aClient, String(kContainerStatusPath) + "/empty", emptyNow);
-  if (!ok) {
-    printLastFirebaseError("RTDB set /status/container/empty");
-    return false;
+  // One multi-location update. eventId belongs to the transition (not to the
+  // attempt), so a retried publish is seen by the app as the same event.
+  DynamicJsonDocument doc(256);
+  doc["empty"] = emptyNow;
+  if (emptyNow) {
+    doc["eventId"]    = eventId;
+    doc["emptySince"] = nowSec;
+  } else {
+    doc["clearedAt"] = nowSec;
   }
 
-  if (emptyNow) {
-    ok = Database.set<int>(aClient, String(kContainerStatusPath) + "/eventId", (int)nowSec);
-    if (!ok) {
-      printLastFirebaseError("RTDB set /status/container/eventId");
-      return false;
-    }
+  String payload;
+  serializeJson(doc, payload);
 
-    ok = Database.set<int>(aClient, String(kContainerStatusPath) + "/emptySince", (int)nowSec);
-    if (!ok) {
-      printLastFirebaseError("RTDB set /status/container/emptySince");
-      return false;
-    }
-  } else {
-    ok = Database.set<int>(aClient, String(kContainerStatusPath) + "/clearedAt", (int)nowSec);
-    if (!ok) {
-      printLastFirebaseError("RTDB set /status/container/clearedAt");
-      // still return true because /empty already succeeded
-    }
+  if (!requestBegin()) return false;
+  bool ok = requestEnd(Database.update(aClient, kContainerStatusPath, object_t(payload)));
+  if (!ok) {
+    printLastFirebaseError("RTDB update /status/container");
+    return false;
   }
 
   Serial.printf("Published container status to RTDB: empty=%s\n", emptyNow ? "true" : "false");
@@ -548,44 +453,12 @@ static bool getCurrentDateISO(char* out, size_t outSize) {// log meal helper fun
   return true;
 }
 
-static int getNextMealNotificationIndex(const String& basePath) { // log meal helper function
-  String json = Database.get<String>(aClient, basePath);
-
-  if (json.length() == 0 || json == "null") return 0;
-
-  DynamicJsonDocument doc(4096);
-  DeserializationError err = deserializeJson(doc, json);
-  if (err) {
-    Serial.print("getNextMealNotificationIndex deserializeJson failed: ");
-    Serial.println(err.c_str());
-    return 0;
-  }
-
-  if (doc.is<JsonArray>()) {
-    JsonArray arr = doc.as<JsonArray>();
-    return (int)arr.size();
-  }
-
-  if (doc.is<JsonObject>()) {
-    JsonObject obj = doc.as<JsonObject>();
-    int maxIdx = -1;
-
-    for (JsonPair kv : obj) {
-      int idx = atoi(kv.key().c_str());
-      if (idx > maxIdx) maxIdx = idx;
-    }
-    return maxIdx + 1;
-  }
-
-  return 0;
-}
-
 bool firebaseLogMealNotification(const char* type,
                                  const char* mealName,
                                  int hour,
                                  int minute,
                                  int amountGrams,
-                                 int32_t eventId) { // upload to meal data for statistics
+                                 uint64_t eventId) { // upload to meal data for statistics
   app.loop();
   if (!app.ready()) {
     Serial.println(" firebaseLogMealNotification: app not ready yet");
@@ -598,20 +471,28 @@ bool firebaseLogMealNotification(const char* type,
     return false;
   }
 
-  const int32_t nowSec = makeEventIdEpochSeconds();
+  const int32_t nowSec = nowEpochSecondsOrUptime();
+
+  // /logs/meal_notifications/<date>/<eventKey>_<type>
+  // (one feeding logs several types under the same eventId)
+  char key[EVENT_KEY_SIZE];
+  eventIdToKey(eventId, key, sizeof(key));
+  String base = String("/logs/meal_notifications/") + String(dateISO) + "/" + key + "_" + String(type ? type : "");
 
-  String dayPath = String("/logs/meal_notifications/") + String(dateISO);
-  int idx = getNextMealNotificationIndex(dayPath);
-  String base = dayPath + "/" + String(idx);
+  DynamicJsonDocument doc(384);
+  doc["ts"]           = nowSec;
+  doc["type"]         = type ? type : "";
+  doc["meal_name"]    = mealName ? mealName : "";
+  doc["hour"]         = hour;
+  doc["minute"]       = minute;
+  doc["amount_grams"] = amountGrams;
+  doc["eventId"]      = eventId;
 
-  bool ok = true;
-  ok &= Database.set<int>(aClient, base + "/ts", (int)nowSec);
-  ok &= Database.set<String>(aClient, base + "/type", String(type ? type : ""));
-  ok &= Database.set<String>(aClient, base + "/meal_name", String(mealName ? mealName : ""));
-  ok &= Database.set<int>(aClient, base + "/hour", hour);
-  ok &= Database.set<int>(aClient, base + "/minute", minute);
-  ok &= Database.set<int>(aClient, base + "/amount_grams", amountGrams);
-  ok &= Database.set<int>(aClient, base + "/eventId", (int)eventId);
+  String payload;
+  serializeJson(doc, payload);
+
+  if (!requestBegin()) return false;
+  bool ok = requestEnd(Database.set<object_t>(aClient, base, object_t(payload)));
 
   if (!ok) {
     printLastFirebaseError("RTDB set daily /logs/meal_notifications/<date>");
@@ -619,38 +500,359 @@ bool firebaseLogMealNotification(const char* type,
     return false;
   }
 
-  Serial.printf("Logged DAILY meal notification: date=%s type=%s meal=%s %02d:%02d grams=%d eventId=%d\n",
+  Serial.printf("Logged DAILY meal notification: date=%s type=%s meal=%s %02d:%02d grams=%d eventId=%s\n",
                 dateISO,
                 type ? type : "",
                 mealName ? mealName : "",
                 hour, minute,
                 amountGrams,
-                (int)eventId);
+                key);
   return true;
 }
 
 // ---------------- Connectivity (Offline mode) ----------------
+// WiFi being up is not enough: the circuit breaker (fed by every request)
+// says whether Firebase actually answers. While it is open the caller
+// switches to the local schedule / queue without paying a timeout.
 bool firebaseIsDatabaseConnected() { //check if we are connected to firebase
   app.loop();
 
   if (WiFi.status() != WL_CONNECTED) {
     return false;
   }
-  return true; 
-  
-  static unsigned long lastProbeMs = 0;
-  bool lastResult = true;
-  const unsigned long PROBE_INTERVAL_MS = 5000;
 
-  if (lastProbeMs != 0 && (millis() - lastProbeMs) < PROBE_INTERVAL_MS) {
-    return lastResult;
+  return cloudHealthCanRequest();
+}
+
+// ---------------- Telemetry heartbeat ----------------
+// The heartbeat is a delta: the update merges the changed fields into the node.
+static const char* kTelemetryPath = "/status/telemetry";
+
+bool firebasePublishTelemetry(const char *json) {
+  app.loop();
+  if (!json || !app.ready()) return false;
+  if (!requestBegin()) return false;
+
+  bool ok = requestEnd(Database.update(aClient, kTelemetryPath, object_t(json)));
+  if (!ok) {
+    printLastFirebaseError("RTDB update /status/telemetry");
   }
-  lastProbeMs = millis();
+  return ok;
+}
 
-  bool infoConnected = Database.get<bool>(aClient, "/.info/connected");
-  int code = aClient.lastError().code();
-  lastResult = (code == 0);
-  if(!lastResult){
+bool firebasePublishDiagnostics(const char *json) {
+  app.loop();
+  if (!json || !app.ready()) return false;
+  if (!requestBegin()) return false;
+
+  bool ok = requestEnd(Database.set<object_t>(aClient, "/status/diagnostics", object_t(json)));
+  if (!ok) {
+    printLastFirebaseError("RTDB set /status/diagnostics");
+  }
+  return ok;
+}
+
+// Daily rollup summaries (StatsManager): /stats/<node>, json = nullptr -> remove
+bool firebasePublishStats(const char *node, const char *json) {
+  app.loop();
+  if (!node || !app.ready()) return false;
+  if (!requestBegin()) return false;
+
+  char path[40];
+  snprintf(path, sizeof(path), "/stats/%s", node);
+  bool ok = json ? requestEnd(Database.set<object_t>(aClient, path, object_t(json)))
+                 : requestEnd(Database.remove(aClient, path));
+  if (!ok) {
+    printLastFirebaseError(json ? "RTDB set /stats" : "RTDB remove /stats");
+  }
+  return ok;
+}
+
+// ---------------- Live feeding progress ----------------
+// Sent with the async API: the request is written/read from app.loop(), so
+// loop() (and the stepper) keeps running. One write in flight at a time.
+static const char* kFeedProgressPath = "/status/feeding";
+static const unsigned long PROGRESS_INFLIGHT_MAX_MS = 3000; // no result by then -> allow the next write
+static bool g_progressInFlight = false;
+static unsigned long g_progressSentMs = 0;
+
+static void onFeedProgressResult(AsyncResult &aResult) {
+  if (aResult.isError()) {
+    Serial.printf("[Progress] write failed: %s (code %d)\n",
+                  aResult.error().message().c_str(), aResult.error().code());
+  }
+  if (aResult.isError() || aResult.available()) {
+    cloudHealthRecord(!aResult.isError(), (uint32_t)(millis() - g_progressSentMs));
+    g_progressInFlight = false;
   }
-  return lastResult;
+}
+
+bool firebasePublishFeedProgress(const char *json) {
+  app.loop();
+  if (!json || !app.ready()) return false;
+  if (g_progressInFlight && (millis() - g_progressSentMs) < PROGRESS_INFLIGHT_MAX_MS) return false;
+  if (!cloudHealthAllowRequest()) return false;
+
+  g_progressInFlight = true;
+  g_progressSentMs = millis();
+  Database.update(aClient, kFeedProgressPath, object_t(json), onFeedProgressResult, "progress");
+  return true;
+}
+
+// ---------------- Remote commands (stream) ----------------
+// SSE events on /commands:
+//   put   "/"      -> whole node (stream start / reconnect)
+//   put   "/<id>"  -> one new command (null = our ack removed it)
+//   patch "/"      -> multi-location update from the app ({"<id>": {...}})
+// An ack moves the command out of /commands into /commandAcks/<id>, so the
+// node only holds commands not acked yet. A whole-node event is still parsed
+// one child at a time: its size never limits what can be parsed.
+static const char* kCommandsPath = "/commands";
+static const char* kCommandAcksPath = "/commandAcks";
+static const unsigned long COMMAND_MAX_AGE_MS    = 2UL * 60UL * 1000UL; // older commands are not executed
+static const unsigned long STREAM_SILENCE_MAX_MS = 90UL * 1000UL;       // RTDB sends keep-alive every 30 s
+#define COMMAND_QUEUE_SIZE 4
+#define COMMAND_DONE_IDS 8
+
+static RemoteCommand g_cmdQueue[COMMAND_QUEUE_SIZE];
+static uint8_t g_cmdHead = 0;
+static uint8_t g_cmdCount = 0;
+
+// IDs already queued this boot (the stream re-sends the whole node on reconnect)
+static char g_cmdSeen[COMMAND_DONE_IDS][24];
+static uint8_t g_cmdSeenNext = 0;
+
+static bool g_streamStarted = false;
+static unsigned long g_lastStreamEventMs = 0;
+
+static JsonStaticPool<1024> g_cmdPool;
+static JsonStaticPool<256>  g_cmdFilterPool;
+
+static bool commandSeen(const char* id) {
+  for (int i = 0; i < COMMAND_DONE_IDS; i++) {
+    if (strncmp(g_cmdSeen[i], id, sizeof(g_cmdSeen[i])) == 0) return true;
+  }
+  return false;
+}
+
+static void markCommandSeen(const char* id) {
+  strlcpy(g_cmdSeen[g_cmdSeenNext], id, sizeof(g_cmdSeen[0]));
+  g_cmdSeenNext = (g_cmdSeenNext + 1) % COMMAND_DONE_IDS;
+}
+
+static bool parseCommandType(const char* s, RemoteCommandType &out) {
+  if (!s) return false;
+  if (strcmp(s, "feed_now") == 0)    { out = CMD_FEED_NOW;    return true; }
+  if (strcmp(s, "cancel") == 0)      { out = CMD_CANCEL;      return true; }
+  if (strcmp(s, "tare") == 0)        { out = CMD_TARE;        return true; }
+  if (strcmp(s, "diagnostics") == 0) { out = CMD_DIAGNOSTICS; return true; }
+  return false;
+}
+
+// One command object -> queue (skips acked / unknown / duplicate ones)
+static void enqueueCommand(const char* id, JsonObject c) {
+  if (!id || !*id || c.isNull()) return;
+  if (!c["status"].isNull()) return;                 // already handled
+  if (commandSeen(id)) return;
+
+  RemoteCommandType type;
+  if (!parseCommandType(c["type"] | "", type)) return;
+
+  if (g_cmdCount >= COMMAND_QUEUE_SIZE) {
+    Serial.printf("[Cmd] queue full -> dropping %s (will be re-sent on reconnect)\n", id);
+    return;
+  }
+
+  RemoteCommand &p = g_cmdQueue[(g_cmdHead + g_cmdCount) % COMMAND_QUEUE_SIZE];
+  strlcpy(p.id, id, sizeof(p.id));
+  p.type = type;
+  p.grams = c["grams"] | 0;
+  p.receivedMs = millis();
+
+  // createdAt is server time (ms); only judged when our clock is valid
+  const uint64_t createdAt = c["createdAt"] | (uint64_t)0;
+  const time_t now = time(nullptr);
+  p.expired = (now >= 100000 && createdAt > 0 &&
+               (uint64_t)now * 1000ULL > createdAt + COMMAND_MAX_AGE_MS);
+
+  g_cmdCount++;
+  markCommandSeen(id);
+  Serial.printf("[Cmd] received %s type=%s%s\n", id, c["type"] | "", p.expired ? " (expired)" : "");
+}
+
+// One command's JSON (len bytes at json) -> queue
+static void parseCommand(const char* id, const char* json, size_t len) {
+  g_cmdFilterPool.reset();
+  JsonDocument filter(&g_cmdFilterPool);
+  filter["type"] = true;
+  filter["grams"] = true;
+  filter["createdAt"] = true;
+  filter["status"] = true;
+
+  g_cmdPool.reset();
+  JsonDocument doc(&g_cmdPool);
+  DeserializationError err = deserializeJson(doc, json, len, DeserializationOption::Filter(filter));
+  if (err) {
+    Serial.printf("[Cmd] bad command %s (%s)\n", id, err.c_str());
+    return;
+  }
+  enqueueCommand(id, doc.as<JsonObject>());
+}
+
+// End of the JSON value starting at p (object/array/string/scalar), nullptr if cut
+static const char* skipJsonValue(const char* p) {
+  int depth = 0;
+  bool inString = false;
+  for (; *p; p++) {
+    const char c = *p;
+    if (inString) {
+      if (c == '\\' && p[1]) p++;
+      else if (c == '"') {
+        inString = false;
+        if (depth == 0) return p + 1;
+      }
+    } else if (c == '"') {
+      inString = true;
+    } else if (c == '{' || c == '[') {
+      depth++;
+    } else if (c == '}' || c == ']') {
+      if (depth == 0) return p;          // end of the enclosing object (scalar value)
+      if (--depth == 0) return p + 1;
+    } else if (c == ',' && depth == 0) {
+      return p;
+    }
+  }
+  return depth == 0 && !inString ? p : nullptr;
+}
+
+// {"<id>": {...}, ...} -> one parseCommand() per child
+static void parseCommandNode(const char* p) {
+  while (*p && *p != '{') p++;
+  if (!*p) return;
+  p++;
+
+  while (true) {
+    while (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t' || *p == ',') p++;
+    if (*p != '"') return;               // '}' = end of the node
+
+    const char* key = ++p;
+    while (*p && *p != '"') p++;
+    if (!*p) return;
+    const size_t keyLen = (size_t)(p - key);
+    p++;
+    while (*p == ' ' || *p == ':') p++;
+
+    const char* value = p;
+    const char* end = skipJsonValue(value);
+    if (!end) {
+      Serial.println("[Cmd] truncated command node");
+      return;
+    }
+
+    char id[sizeof(((RemoteCommand*)nullptr)->id)];
+    if (keyLen < sizeof(id) && *value == '{') {
+      memcpy(id, key, keyLen);
+      id[keyLen] = '\0';
+      parseCommand(id, value, (size_t)(end - value));
+    }
+    p = end;
+  }
+}
+
+static void handleCommandEvent(const String &event, const String &path, const String &data) {
+  if (event != "put" && event != "patch") return;     // keep-alive, cancel, auth_revoked
+  if (data.length() == 0 || data == "null") return;
+
+  // depth: "/" = node, "/<id>" = one command, deeper = a single field
+  const char* p = path.c_str();
+  if (*p == '/') p++;
+  if (*p == '\0') {
+    parseCommandNode(data.c_str());
+    return;
+  }
+  if (strchr(p, '/')) return;
+  parseCommand(p, data.c_str(), data.length());
+}
+
+static void onCommandStream(AsyncResult &aResult) {
+  if (aResult.isError()) {
+    Serial.printf("[Cmd] stream error: %s (code %d)\n",
+                  aResult.error().message().c_str(), aResult.error().code());
+    return;
+  }
+  if (!aResult.available()) return;
+
+  RealtimeDatabaseResult &stream = aResult.to<RealtimeDatabaseResult>();
+  if (!stream.isStream()) return;
+
+  g_lastStreamEventMs = millis();
+  handleCommandEvent(stream.event(), stream.dataPath(), stream.to<String>());
+}
+
+void firebaseCommandsLoop() {
+  app.loop();
+  if (!app.ready()) return;
+  if (WiFi.status() != WL_CONNECTED) return;
+
+  // no event (not even keep-alive) for too long -> the stream is dead, reopen it
+  if (g_streamStarted && (millis() - g_lastStreamEventMs) > STREAM_SILENCE_MAX_MS) {
+    Serial.println("[Cmd] stream silent -> reopening");
+    streamClient.stopAsync();
+    g_streamStarted = false;
+  }
+
+  if (!g_streamStarted) {
+    g_streamStarted = true;
+    g_lastStreamEventMs = millis();
+    Database.get(streamClient, kCommandsPath, onCommandStream, true /* SSE */, "cmdStream");
+    Serial.println("[Cmd] stream opened on /commands");
+  }
+}
+
+bool firebasePollCommand(RemoteCommand &out) {
+  if (g_cmdCount == 0) return false;
+  out = g_cmdQueue[g_cmdHead];
+  g_cmdHead = (g_cmdHead + 1) % COMMAND_QUEUE_SIZE;
+  g_cmdCount--;
+  return true;
+}
+
+bool firebaseAckCommand(const RemoteCommand &cmd, const char *status, const char *reason,
+                        unsigned long executedMs) {
+  app.loop();
+  if (!app.ready()) return false;
+
+  // one multi-location update at the root (keys without the leading '/'):
+  // the ack appears and the command leaves /commands together
+  char ackKey[48];
+  char cmdKey[48];
+  snprintf(ackKey, sizeof(ackKey), "%s/%s", kCommandAcksPath + 1, cmd.id);
+  snprintf(cmdKey, sizeof(cmdKey), "%s/%s", kCommandsPath + 1, cmd.id);
+
+  JsonDocument doc;
+  JsonObject ack = doc[ackKey].to<JsonObject>();
+  ack["status"] = status ? status : "done";
+  if (reason && *reason) ack["reason"] = reason;
+  ack["latencyMs"] = (uint32_t)(executedMs - cmd.receivedMs);   // stream -> execution on the device
+
+  const time_t now = time(nullptr);
+  if (now >= 100000) {
+    // wall-clock time of the execution (ms), derived from the millis() stamp
+    ack["executedAt"] = (uint64_t)now * 1000ULL - (uint64_t)(millis() - executedMs);
+  }
+  doc[cmdKey] = nullptr;
+
+  String payload;
+  serializeJson(doc, payload);
+
+  if (!requestBegin()) return false;
+  bool ok = requestEnd(Database.update(aClient, "/", object_t(payload)));
+  if (!ok) {
+    printLastFirebaseError("RTDB ack command");
+    return false;
+  }
+
+  Serial.printf("[Cmd] %s -> %s (%lu ms after receive)\n", cmd.id, status,
+                (unsigned long)(executedMs - cmd.receivedMs));
+  return true;
 }
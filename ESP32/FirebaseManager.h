@@ -7,17 +7,20 @@
 void initFirebase();
 void firebaseLoop();
 
-// A single feeding schedule entry (max 6 per day)
-struct FeedingScheduleEntry {
-  bool enabled;
-  int hour;
-  int minute;
-  int amountGrams;
-  char mealName[30];
+// TLS handshake counters (one handshake per (re)connect of the secure client)
+struct FirebaseTlsStats {
+  uint32_t handshakes;
+  uint32_t failures;
+  uint32_t lastMs;
+  uint32_t maxMs;
+  uint32_t totalMs;
+  int32_t  lastHeapCost;   // free-heap drop across the last handshake (bytes)
 };
 
+void firebaseGetTlsStats(FirebaseTlsStats &out);
+
 // Returns true if a feeding is due right now; outputs the amount in grams
-// This will return true only once per entry per day (it auto "locks" after firing).
+// This will return true only once per timeline entry per day (ScheduleManager).
 bool firebaseGetDueFeeding(int &amountOut,
                            int &feed_hour,
                            int &feed_minute,
@@ -34,19 +37,73 @@ bool update_weight(int amount_grams,
                    const char *day,
                    const char *date,      // "YYYY-MM-DD"
                    float prev_current_weight,
-                   float new_current_weight);
+                   float new_current_weight,
+                   uint64_t eventId);      // feeding's event ID -> /weights/<eventKey>
+                                           // (EVENT_ID_NONE is rejected)
+
+// Batched, idempotent upload of queued meals (one multi-location write)
+struct WeightQueueRecord;
+bool update_weights_batch(const WeightQueueRecord *records, size_t count);
 
-bool firebasePublishContainerEmpty(bool emptyNow);
+// eventId identifies the empty/refill transition (reused on retries)
+bool firebasePublishContainerEmpty(bool emptyNow, uint64_t eventId);
 
 
 
 bool firebaseIsDatabaseConnected();
 
+// Merge one telemetry heartbeat (flat JSON object) into /status/telemetry
+bool firebasePublishTelemetry(const char *json);
+
+// Overwrite /status/diagnostics with a diagnostics dump (JSON object)
+bool firebasePublishDiagnostics(const char *json);
+
+// Write (or remove, json = nullptr) one rollup summary node /stats/<node>
+bool firebasePublishStats(const char *node, const char *json);
+
+// Merge live feeding progress into /status/feeding. Async (does not block
+// the motor); false while the previous write is still in flight.
+bool firebasePublishFeedProgress(const char *json);
+
+// ---------------- Remote commands ----------------
+// The app pushes commands to /commands/<pushId>:
+//   { "type": "feed_now" | "cancel" | "tare" | "diagnostics",
+//     "grams": 20,                       // feed_now only
+//     "createdAt": {".sv": "timestamp"} }
+// The device watches /commands over a stream (SSE), so a command arrives
+// within one loop() instead of the next schedule poll, and acks it with
+// { "status", "executedAt", "latencyMs" } on the same node.
+enum RemoteCommandType {
+  CMD_FEED_NOW,
+  CMD_CANCEL,
+  CMD_TARE,
+  CMD_DIAGNOSTICS
+};
+
+struct RemoteCommand {
+  char id[24];               // push ID (node key under /commands)
+  RemoteCommandType type;
+  int grams;                 // feed_now portion
+  unsigned long receivedMs;  // millis() when the stream delivered it
+  bool expired;              // too old to run -> only ack it as "expired"
+};
+
+// Keep the command stream open (call every loop while WiFi is up)
+void firebaseCommandsLoop();
+
+// Next pending command (expired ones too: the caller acks them, see expired)
+bool firebasePollCommand(RemoteCommand &out);
+
+// status: "done", "rejected", "failed", "cancelled", "expired"; reason is optional (e.g. "busy")
+// false = not written (the caller keeps the ack and retries)
+bool firebaseAckCommand(const RemoteCommand &cmd, const char *status, const char *reason,
+                        unsigned long executedMs);
+
 bool firebaseLogMealNotification(const char* type,
                                  const char* mealName,
                                  int hour,
                                  int minute,
                                  int amountGrams,
-                                 int32_t eventId);
+                                 uint64_t eventId);
 
 #endif
@@ -0,0 +1,89 @@
+#ifndef JSONPOOL_H
+#define JSONPOOL_H
+
+#include <ArduinoJson.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Fixed-size allocator for ArduinoJson 7 documents.
+// Memory comes from a static buffer instead of the heap, so parsing a schedule
+// or a queue record costs no heap at all and cannot fragment it.
+//
+// Usage (one document at a time per pool):
+//   static JsonStaticPool<1024> pool;
+//   pool.reset();
+//   JsonDocument doc(&pool);
+//   deserializeJson(doc, file, DeserializationOption::Filter(filter));
+//
+// When the pool is too small deserializeJson() returns NoMemory (never a
+// silently truncated document).
+template <size_t N>
+class JsonStaticPool : public ArduinoJson::Allocator {
+public:
+  void* allocate(size_t size) override {
+    const size_t need = HDR + align(size);
+    if (used_ + need > N) {
+      exhausted_ = true;
+      return nullptr;
+    }
+    uint8_t* block = buf_ + used_;
+    *(uint32_t*)block = (uint32_t)size;
+    used_ += need;
+    if (used_ > peak_) peak_ = used_;
+    last_ = block + HDR;
+    return last_;
+  }
+
+  void deallocate(void* ptr) override {
+    // bump allocator: only the most recent block can be given back
+    if (ptr && ptr == last_) {
+      used_ = (size_t)((uint8_t*)ptr - buf_) - HDR;
+      last_ = nullptr;
+    }
+  }
+
+  void* reallocate(void* ptr, size_t newSize) override {
+    if (!ptr) return allocate(newSize);
+
+    if (ptr == last_) { // grow/shrink in place
+      const size_t off = (size_t)((uint8_t*)ptr - buf_);
+      if (off + align(newSize) > N) {
+        exhausted_ = true;
+        return nullptr;
+      }
+      *(uint32_t*)((uint8_t*)ptr - HDR) = (uint32_t)newSize;
+      used_ = off + align(newSize);
+      if (used_ > peak_) peak_ = used_;
+      return ptr;
+    }
+
+    const size_t oldSize = *(uint32_t*)((uint8_t*)ptr - HDR);
+    void* fresh = allocate(newSize);
+    if (fresh) memcpy(fresh, ptr, oldSize < newSize ? oldSize : newSize);
+    return fresh;
+  }
+
+  // Forget everything (only once the previous document is gone)
+  void reset() {
+    used_ = 0;
+    last_ = nullptr;
+    exhausted_ = false;
+  }
+
+  size_t capacity() const { return N; }
+  size_t peak() const { return peak_; }
+  bool exhausted() const { return exhausted_; }
+
+private:
+  static const size_t HDR = 8; // block size, keeps payload 8-byte aligned
+  static size_t align(size_t n) { return (n + 7u) & ~(size_t)7u; }
+
+  alignas(8) uint8_t buf_[N];
+  size_t used_ = 0;
+  size_t peak_ = 0;
+  void* last_ = nullptr;
+  bool exhausted_ = false;
+};
+
+#endif
@@ -0,0 +1,185 @@
+#include "LatencyManager.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#if LATENCY_PROFILING
+
+#define LAT_SUB_BITS 1                                       // 2 linear sub-buckets per power of two
+#define LAT_SUB (1U << LAT_SUB_BITS)
+#define LAT_MAX_EXP 21                                       // resolved up to 2^22 us (~4 s)
+#define LAT_BUCKETS ((LAT_MAX_EXP - LAT_SUB_BITS + 2) * LAT_SUB)  // last one also takes anything slower
+
+static const char* const kProbeNames[LAT_PROBES] = {
+  "motor", "sensors", "wifi", "final", "container", "pixels", "ntp",
+  "noclock", "qcommit", "qflush", "telemetry", "stats", "schedule",
+  "commands", "feeding", "notify", "meal", "ack", "progress", "stepGap",
+};
+
+struct ProbeHist {
+  uint32_t buckets[LAT_BUCKETS];
+  uint32_t count;
+  uint32_t maxUs;
+};
+
+// Written by loop(); LAT_STEP_GAP also by the motion task (same core, it
+// only preempts loop() -> at worst a count is lost across a reset)
+static ProbeHist g_hist[LAT_PROBES];
+static int64_t g_lastStepUs = 0;        // motion task (or loop() without it)
+static bool g_stepping = false;
+
+static uint8_t bucketOf(uint32_t us) {
+  if (us < LAT_SUB) return (uint8_t)us;
+  const int exp = 31 - __builtin_clz(us);
+  if (exp > LAT_MAX_EXP) return LAT_BUCKETS - 1;
+  const uint32_t sub = (us >> (exp - LAT_SUB_BITS)) & (LAT_SUB - 1);
+  return (uint8_t)((exp - LAT_SUB_BITS + 1) * LAT_SUB + sub);
+}
+
+// Smallest value of the next bucket = upper bound of this one
+static uint32_t bucketUpperUs(uint8_t b) {
+  const uint8_t next = b + 1;
+  if (next >= LAT_BUCKETS) return UINT32_MAX;
+  if (next < LAT_SUB) return next;
+  const uint32_t exp = next / LAT_SUB + LAT_SUB_BITS - 1;
+  const uint32_t sub = next % LAT_SUB;
+  return (LAT_SUB + sub) << (exp - LAT_SUB_BITS);
+}
+
+static void recordUs(LatencyProbe probe, uint32_t us) {
+  ProbeHist& h = g_hist[probe];
+  uint32_t& bucket = h.buckets[bucketOf(us)];
+  if (bucket != UINT32_MAX) bucket++;
+  if (h.count != UINT32_MAX) h.count++;
+  if (us > h.maxUs) h.maxUs = us;
+}
+
+// Saturates instead of wrapping (lands in the last bucket)
+static uint32_t elapsedUs(int64_t startUs, int64_t nowUs) {
+  const int64_t us = nowUs - startUs;
+  if (us <= 0) return 0;
+  return us >= (int64_t)UINT32_MAX ? UINT32_MAX : (uint32_t)us;
+}
+
+void latencyRecord(LatencyProbe probe, int64_t startUs) {
+  if (probe >= LAT_PROBES) return;
+  recordUs(probe, elapsedUs(startUs, latencyNowUs()));
+}
+
+void latencyStep(bool moving) {
+  const int64_t now = latencyNowUs();
+  if (g_stepping && moving) recordUs(LAT_STEP_GAP, elapsedUs(g_lastStepUs, now));
+  g_stepping = moving;
+  g_lastStepUs = now;
+}
+
+static uint32_t percentileUs(const ProbeHist& h, uint32_t permille) {
+  const uint64_t rank = ((uint64_t)h.count * permille + 999ULL) / 1000ULL; // 1-based
+  uint64_t seen = 0;
+  for (uint8_t b = 0; b < LAT_BUCKETS; b++) {
+    seen += h.buckets[b];
+    if (seen >= rank) {
+      const uint32_t upper = bucketUpperUs(b);
+      return upper < h.maxUs ? upper : h.maxUs;
+    }
+  }
+  return h.maxUs;
+}
+
+bool latencyGetSummary(LatencyProbe probe, LatencySummary& out) {
+  memset(&out, 0, sizeof(out));
+  if (probe >= LAT_PROBES || g_hist[probe].count == 0) return false;
+  const ProbeHist& h = g_hist[probe];
+  out.count = h.count;
+  out.p50Us = percentileUs(h, 500);
+  out.p99Us = percentileUs(h, 990);
+  out.maxUs = h.maxUs;
+  return true;
+}
+
+static bool appendf(char* buf, size_t size, size_t& len, const char* fmt, ...) __attribute__((format(printf, 4, 5)));
+static bool appendf(char* buf, size_t size, size_t& len, const char* fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+  const int n = vsnprintf(buf + len, size - len, fmt, ap);
+  va_end(ap);
+  if (n < 0 || len + (size_t)n >= size) return false;
+  len += (size_t)n;
+  return true;
+}
+
+static bool appendProbe(char* buf, size_t size, size_t& len, LatencyProbe probe, bool first) {
+  LatencySummary s;
+  latencyGetSummary(probe, s);
+  return appendf(buf, size, len, first ? "\"%s\":[%lu,%lu,%lu]" : ",\"%s\":[%lu,%lu,%lu]",
+                 kProbeNames[probe], (unsigned long)s.p50Us, (unsigned long)s.p99Us, (unsigned long)s.maxUs);
+}
+
+bool latencyAppendJson(char* buf, size_t size, size_t& len, uint8_t maxProbes) {
+  if (!buf || len >= size) return false;
+  const size_t start = len;
+  bool ok = appendf(buf, size, len, "{");
+  uint8_t written = 0;
+  bool used[LAT_PROBES] = {false};
+
+  if (g_hist[LAT_STEP_GAP].count && written < maxProbes) {
+    ok = ok && appendProbe(buf, size, len, LAT_STEP_GAP, true);
+    used[LAT_STEP_GAP] = true;
+    written++;
+  }
+
+  // slowest remaining probes (selection, LAT_PROBES is small)
+  while (ok && written < maxProbes) {
+    int worst = -1;
+    for (int p = 0; p < LAT_PROBES; p++) {
+      if (used[p] || g_hist[p].count == 0) continue;
+      if (worst < 0 || g_hist[p].maxUs > g_hist[worst].maxUs) worst = p;
+    }
+    if (worst < 0) break;
+    ok = appendProbe(buf, size, len, (LatencyProbe)worst, written == 0);
+    used[worst] = true;
+    written++;
+  }
+
+  ok = ok && appendf(buf, size, len, "}");
+  if (!ok) {
+    len = start;
+    buf[len] = '\0';
+  }
+  return ok;
+}
+
+void latencyPrint() {
+  Serial.println("[Latency] probe        count     p50 us     p99 us     max us");
+  for (int p = 0; p < LAT_PROBES; p++) {
+    LatencySummary s;
+    if (!latencyGetSummary((LatencyProbe)p, s)) continue;
+    Serial.printf("[Latency] %-10s %8lu %10lu %10lu %10lu\n", kProbeNames[p], (unsigned long)s.count,
+                  (unsigned long)s.p50Us, (unsigned long)s.p99Us, (unsigned long)s.maxUs);
+  }
+}
+
+void latencyReset() {
+  memset(g_hist, 0, sizeof(g_hist));
+}
+
+#else  // LATENCY_PROFILING: no tables, every call is a no-op
+
+void latencyStep(bool moving) {}
+
+bool latencyGetSummary(LatencyProbe probe, LatencySummary& out) {
+  memset(&out, 0, sizeof(out));
+  return false;
+}
+
+bool latencyAppendJson(char* buf, size_t size, size_t& len, uint8_t maxProbes) {
+  return false;
+}
+
+void latencyPrint() {
+  Serial.println("[Latency] profiling compiled out (LATENCY_PROFILING=0)");
+}
+
+void latencyReset() {}
+
+#endif
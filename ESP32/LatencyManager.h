@@ -0,0 +1,103 @@
+#ifndef LATENCYMANAGER_H
+#define LATENCYMANAGER_H
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Per-subsystem latency of loop() (64-bit esp_timer microseconds, no heap):
+// - every probed call adds its duration to a fixed-bucket log-linear
+//   histogram (2 sub-buckets per power of two, 1 us .. ~4 s) + count + max
+// - LAT_STEP_GAP = time between two stepper.run() calls while the motor
+//   moves: the figure that makes the motor stutter (its max is tracked too)
+// - exposed by the "lat" serial command, the heartbeat (worst probes + step
+//   gap) and the diagnostics dump; histograms restart with every heartbeat
+// - the clock does not wrap and ignores CPU clock changes (naps); anything
+//   longer than ~71 min saturates into the last bucket
+// Build with -DLATENCY_PROFILING=0 to compile every probe out.
+
+#ifndef LATENCY_PROFILING
+#define LATENCY_PROFILING 1
+#endif
+
+enum LatencyProbe : uint8_t {
+  LAT_MOTOR,          // updateMotor()
+  LAT_SENSORS,        // updateDistance() + updateWeight()
+  LAT_WIFI,           // wifiAutoReconnectTick()
+  LAT_FINAL_WEIGHT,   // final-weight capture (+ no-clock log write)
+  LAT_CONTAINER,      // container status publish (Firebase)
+  LAT_PIXELS,         // updateNeoPixel()
+  LAT_NTP,            // ntpTick() / late Firebase init
+  LAT_NOCLOCK,        // localNoClockTick() (LittleFS)
+  LAT_QUEUE_COMMIT,   // localQueueTick() (LittleFS)
+  LAT_QUEUE_FLUSH,    // offline queue upload (LittleFS + Firebase)
+  LAT_TELEMETRY,      // telemetryTick() (Firebase)
+  LAT_STATS,          // statsTick() (Firebase)
+  LAT_SCHEDULE,       // firebaseLoop() + due check / local due check
+  LAT_COMMANDS,       // command stream + handler
+  LAT_FEEDING,        // updateMotorAndFeeding()
+  LAT_NOTIFY,         // firebaseLogMealNotification()
+  LAT_MEAL_RECORD,    // meal record upload / queue write
+  LAT_ACK,            // flushCommandAck() (Firebase)
+  LAT_PROGRESS,       // feedProgressTick() (Firebase)
+  LAT_STEP_GAP,       // between two stepper.run() calls while moving
+  LAT_PROBES
+};
+
+struct LatencySummary {
+  uint32_t count;
+  uint32_t p50Us;     // bucket upper bounds (<= maxUs)
+  uint32_t p99Us;
+  uint32_t maxUs;
+};
+
+#if LATENCY_PROFILING
+
+inline int64_t latencyNowUs() {
+  return esp_timer_get_time();
+}
+
+void latencyRecord(LatencyProbe probe, int64_t startUs);
+
+class LatencyScope {
+ public:
+  explicit LatencyScope(LatencyProbe probe) : probe_(probe), start_(latencyNowUs()) {}
+  ~LatencyScope() { latencyRecord(probe_, start_); }
+
+ private:
+  LatencyProbe probe_;
+  int64_t start_;
+};
+
+#define LATENCY_CONCAT2(a, b) a##b
+#define LATENCY_CONCAT(a, b) LATENCY_CONCAT2(a, b)
+// Times the rest of the enclosing block
+#define LATENCY_SCOPE(probe) LatencyScope LATENCY_CONCAT(latencyScope_, __LINE__)(probe)
+// Times one statement
+#define LATENCY_CALL(probe, stmt) do { LATENCY_SCOPE(probe); stmt; } while (0)
+// Every stepper.run(); moving = a move is in progress
+#define LATENCY_STEP(moving) latencyStep(moving)
+
+#else
+
+#define LATENCY_SCOPE(probe) do {} while (0)
+#define LATENCY_CALL(probe, stmt) do { stmt; } while (0)
+#define LATENCY_STEP(moving) do {} while (0)
+
+#endif
+
+void latencyStep(bool moving);
+
+bool latencyGetSummary(LatencyProbe probe, LatencySummary &out);
+
+// Appends {"name":[p50,p99,max],...} (us) at buf + len: the step gap, then
+// the slowest probes (by max), at most maxProbes in all. false = did not fit.
+bool latencyAppendJson(char *buf, size_t size, size_t &len, uint8_t maxProbes);
+
+// Serial "lat" command: every probe with samples
+void latencyPrint();
+
+void latencyReset();
+
+#endif
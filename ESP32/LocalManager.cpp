@@ -1,30 +1,166 @@
 #include "LocalManager.h"
+#include "EventIdManager.h"
+#include "JsonPool.h"
+#include "ScheduleManager.h"
 #include <LittleFS.h>
 #include <Arduino.h>  
 #include <FS.h>
 #include <ArduinoJson.h>
+#include <Preferences.h>
 #include <time.h>
 #include <cstring>
+#include <cstddef>
+
+// NVS namespace for the schedule cache and the queue read cursor
+static const char* LOCAL_NVS_NAMESPACE = "local";
+static Preferences g_localPrefs;
+static bool g_localPrefsReady = false;
+
+// -------------------- Schedule cache (NVS, binary) --------------------
+// One blob = header + the compiled rules, replaced in a single NVS write
+// (NVS keeps the old entry until the new one is complete -> atomic).
+static const char* CACHE_NVS_KEY = "sched";
+static const uint32_t SCHEDULE_CACHE_MAGIC = 0x53434831; // "SCH1"
+static const uint8_t SCHEDULE_CACHE_VERSION = 1;         // bump when ScheduleRule changes
+
+struct ScheduleCacheRecord {
+  uint32_t magic;
+  uint8_t version;
+  uint8_t ruleSize;      // sizeof(ScheduleRule) when written
+  uint16_t count;
+  uint32_t crc;          // CRC32 of rules[0..count)
+  ScheduleRule rules[SCHEDULE_MAX_RULES];
+};
+
+static ScheduleCacheRecord g_cacheRec;
+static bool g_haveStoredCrc = false;     // CRC of the record in NVS is known
+static uint32_t g_storedCrc = 0;
 
-static const char* SCHEDULE_FILE = "/schedule_cache.json";
-static const char* SCHEDULE_CRC_FILE = "/schedule_cache.crc";
+// Old JSON cache (migrated once, then removed)
+static const char* OLD_SCHEDULE_FILE = "/schedule_cache.json";
+static const char* OLD_SCHEDULE_CRC_FILE = "/schedule_cache.crc";
 
 // -------------------- Offline stats queue (weights) --------------------
-static const char* WEIGHTS_QUEUE_FILE = "/weights_queue.jsonl";
-static const char* WEIGHTS_PRUNE_META = "/weights_prune_meta.json";
+// Append-only binary log of fixed-schema records, one segment file per day
+// (/wq/<YYYYMMDD>.bin, day of the record's timestamp). Frame:
+//   A5 5A | type | len | payload[len] | CRC32(type, len, payload)
+// - a torn append (power loss) or a corrupt frame fails its CRC and the
+//   reader skips ahead to the next sync pattern, so later records are kept
+// - uploads only advance a read cursor persisted in NVS; a segment file is
+//   deleted once all of it is uploaded
+// - retention (7 days) and the flash quota drop whole segments, oldest
+//   first: a file delete, never a rewrite
+static const char* QUEUE_DIR = "/wq";
+static const char* OLD_WEIGHTS_LOG_FILE = "/weights_queue.bin";     // single-file log, moved into a segment once
+static const char* OLD_WEIGHTS_QUEUE_FILE = "/weights_queue.jsonl"; // JSON lines, migrated once
+static const char* OLD_PRUNE_META = "/weights_prune_meta.json";     // not needed any more, removed
+
+static const uint32_t KEEP_WINDOW_SEC   = 7UL * 24UL * 60UL * 60UL; // 7 days
+static const uint32_t QUEUE_QUOTA_BYTES = 64UL * 1024UL;            // whole queue; oldest segments evicted beyond it
+#define QUEUE_SEGMENTS_MAX 12
+
+#define LOG_SYNC0 0xA5
+#define LOG_SYNC1 0x5A
+#define LOG_HEADER_SIZE 4      // sync, sync, type, len
+#define LOG_CRC_SIZE 4
+#define LOG_PAYLOAD_MAX 96
+#define LOG_GEN_FRAME_SIZE (LOG_HEADER_SIZE + 4 + LOG_CRC_SIZE)
+
+enum LogRecordType : uint8_t {
+  LOG_REC_WEIGHT = 1,          // WeightLogFixed + meal name + day name
+  LOG_REC_FILE_GEN = 2,        // first frame of a segment: uint32 generation
+  LOG_REC_NO_CLOCK_FEED = 3,   // no-clock log: NoClockFeedFixed + meal name
+  LOG_REC_BOOT_END = 4,        // no-clock log: NoClockBootEnd
+  LOG_REC_NO_CLOCK_READING = 5 // no-clock log: NoClockReading
+};
+
+// Manifest (NVS "local"/"qman"): segment days, oldest first. Written only
+// when a segment is created or deleted, never per record.
+static const uint32_t QUEUE_MANIFEST_MAGIC = 0x514D4E31; // "QMN1"
+
+struct QueueManifest {
+  uint32_t magic;
+  uint32_t nextGen;            // generation of the next segment file
+  uint32_t count;
+  uint32_t days[QUEUE_SEGMENTS_MAX];  // YYYYMMDD, 0 = records without a clock
+};
+
+static QueueManifest g_manifest;
+static uint32_t g_segBytes[QUEUE_SEGMENTS_MAX];   // segment file sizes (RAM)
+static bool g_manifestLoaded = false;
+
+// Read cursor (NVS "local"/"qcur"): position in the oldest segment. Valid
+// only for the segment generation it names, so a crash between deleting a
+// segment and moving the cursor just re-reads a file from the top (re-sent
+// records land on the same keys).
+static const uint32_t QUEUE_CURSOR_MAGIC = 0x51435232; // "QCR2"
+
+struct QueueCursor {
+  uint32_t magic;
+  uint32_t day;                // segment the offset belongs to
+  uint32_t gen;                // its generation (0 = none)
+  uint32_t offset;             // first byte not uploaded yet
+  uint32_t seq;                // records consumed from that segment
+};
+
+static QueueCursor g_cursor;
+static bool g_cursorLoaded = false;
+
+// Group commit: new frames are staged in RTC slow memory and appended to
+// flash together (one open/write/close), once they fill the segment's tail
+// flash page, after STAGE_MAX_AGE_MS, or on localQueueCommit() (upload,
+// before OTA / deep sleep / restart). RTC memory survives soft resets
+// (panic, watchdog, ESP.restart) but not a power cut: at most
+// STAGE_MAX_AGE_MS of offline records is at risk there.
+#define STAGE_BYTES 512
+#define FLASH_PAGE_BYTES 256
+static const uint32_t STAGE_MAGIC = 0x53544731;          // "STG1"
+static const uint32_t STAGE_MAX_AGE_MS = 10UL * 60UL * 1000UL;
+
+struct StagedFrames {
+  uint32_t magic;
+  uint32_t day;                // segment of the staged frames
+  uint32_t len;
+  uint32_t crc;                // CRC32 of day, len, buf[0..len)
+  uint8_t buf[STAGE_BYTES];
+};
+
+static RTC_NOINIT_ATTR StagedFrames g_stage;
+static unsigned long g_stageSinceMs = 0;   // first staged frame (this boot)
+static bool g_stageChecked = false;
+
+static LocalQueueStats g_qstats;
+
+// Fixed part of a weight record (little endian, as on the ESP32)
+struct __attribute__((packed)) WeightLogFixed {
+  uint32_t ts;                 // epoch when queued, 0 = unknown
+  uint64_t eventId;            // EVENT_ID_NONE -> key derived from the fields
+  int16_t amountGrams;
+  uint8_t feedHour;
+  uint8_t feedMinute;
+  float prevWeight;
+  float currentWeight;
+  uint32_t date;               // YYYYMMDD, 0 = none
+};
 
-static const uint32_t PRUNE_INTERVAL_SEC = 24UL * 60UL * 60UL;        // 24 hours
-static const uint32_t KEEP_WINDOW_SEC    = 7UL  * 24UL * 60UL * 60UL; // 7 days
+static uint8_t g_frameBuf[LOG_HEADER_SIZE + LOG_PAYLOAD_MAX + LOG_CRC_SIZE];
 
-// Simple CRC32 (good enough for change-detection)
-static uint32_t crc32(const uint8_t* data, size_t len) { 
+// Static JSON pool + line buffer: only used to migrate an old JSON lines queue
+static JsonStaticPool<512>  g_recordPool;
+static char g_lineBuf[384];   // one queue line (records are ~250 bytes)
+
+// CRC32 (IEEE), 4 bits per step from a 16-entry table (64 B of flash)
+static const uint32_t kCrcNibble[16] = {
+  0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+  0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+};
+
+static uint32_t crc32(const uint8_t* data, size_t len) {
   uint32_t crc = 0xFFFFFFFF;
   while (len--) {
     crc ^= *data++;
-    for (int i = 0; i < 8; i++) {
-      uint32_t mask = -(crc & 1);
-      crc = (crc >> 1) ^ (0xEDB88320 & mask);
-    }
+    crc = (crc >> 4) ^ kCrcNibble[crc & 0x0F];
+    crc = (crc >> 4) ^ kCrcNibble[crc & 0x0F];
   }
   return ~crc;
 }
@@ -39,106 +175,235 @@ bool initLocalStorage() {
   return true;
 }
 
-//helper function for reading local schedule file
-static bool readStoredCrc(uint32_t &out) {
-  if (!LittleFS.exists(SCHEDULE_CRC_FILE)) return false;
-  File f = LittleFS.open(SCHEDULE_CRC_FILE, "r");
-  if (!f) return false;
-  String s = f.readString();
-  f.close();
-  out = (uint32_t)strtoul(s.c_str(), nullptr, 10);
-  return true;
+static bool localPrefsOpen() {
+  if (!g_localPrefsReady) g_localPrefsReady = g_localPrefs.begin(LOCAL_NVS_NAMESPACE, false);
+  return g_localPrefsReady;
 }
-//helper function for reading local schedule file
-static bool writeStoredCrc(uint32_t crc) {
-  File f = LittleFS.open(SCHEDULE_CRC_FILE, "w");
-  if (!f) return false;
-  f.print(crc);
-  f.close();
-  return true;
+
+static size_t cacheRecordBytes(size_t count) {
+  return offsetof(ScheduleCacheRecord, rules) + count * sizeof(ScheduleRule);
 }
 
-// check if we need to update the local storage
-bool localStoreScheduleIfChanged(const char* json) {
-  if (!json) return false;
+// Reads + checks the NVS record into g_cacheRec
+static bool readCacheRecord() {
+  if (!localPrefsOpen() || !g_localPrefs.isKey(CACHE_NVS_KEY)) return false;
+
+  const size_t len = g_localPrefs.getBytes(CACHE_NVS_KEY, &g_cacheRec, sizeof(g_cacheRec));
+  if (len < offsetof(ScheduleCacheRecord, rules) ||
+      g_cacheRec.magic != SCHEDULE_CACHE_MAGIC ||
+      g_cacheRec.version != SCHEDULE_CACHE_VERSION ||
+      g_cacheRec.ruleSize != sizeof(ScheduleRule) ||
+      g_cacheRec.count > SCHEDULE_MAX_RULES ||
+      len != cacheRecordBytes(g_cacheRec.count)) {
+    Serial.println("[Local] Schedule cache: old version or bad size -> ignored");
+    return false;
+  }
 
-  uint32_t newCrc = crc32((const uint8_t*)json, strlen(json));
+  const uint32_t crc = crc32((const uint8_t*)g_cacheRec.rules, g_cacheRec.count * sizeof(ScheduleRule));
+  if (crc != g_cacheRec.crc) {
+    Serial.println("[Local] Schedule cache: CRC mismatch -> ignored");
+    return false;
+  }
+  g_storedCrc = crc;
+  g_haveStoredCrc = true;
+  return true;
+}
 
-  uint32_t oldCrc = 0;
-  bool hasOld = readStoredCrc(oldCrc);
+// Stores the compiled schedule; flash is written only if the rules changed
+bool localStoreScheduleIfChanged() {
+  const size_t count = scheduleRuleCount();
+  if (count > SCHEDULE_MAX_RULES) return false;
 
-  if (hasOld && oldCrc == newCrc) {
+  const uint32_t newCrc = crc32((const uint8_t*)scheduleRules(), count * sizeof(ScheduleRule));
+
+  if (!g_haveStoredCrc) (void)readCacheRecord(); // first call since boot: learn the stored CRC
+  if (g_haveStoredCrc && g_storedCrc == newCrc) {
     // No change -> no flash write
     return true;
   }
 
-  File f = LittleFS.open(SCHEDULE_FILE, "w");
-  if (!f) {
-    Serial.println("[Local] Failed to open schedule file for write");
+  if (!localPrefsOpen()) {
+    Serial.println("[Local] Schedule cache: NVS not available");
     return false;
   }
-  f.print(json);
-  f.close();
 
-  if (!writeStoredCrc(newCrc)) {
-    Serial.println("[Local] Failed to write schedule CRC");
-    // schedule still saved, CRC missing is not fatal
+  g_cacheRec.magic = SCHEDULE_CACHE_MAGIC;
+  g_cacheRec.version = SCHEDULE_CACHE_VERSION;
+  g_cacheRec.ruleSize = (uint8_t)sizeof(ScheduleRule);
+  g_cacheRec.count = (uint16_t)count;
+  g_cacheRec.crc = newCrc;
+  memcpy(g_cacheRec.rules, scheduleRules(), count * sizeof(ScheduleRule));
+
+  const size_t len = cacheRecordBytes(count);
+  if (g_localPrefs.putBytes(CACHE_NVS_KEY, &g_cacheRec, len) != len) {
+    Serial.println("[Local] Failed to write schedule cache");
+    g_haveStoredCrc = false; // unknown state -> re-read next time
+    return false;
   }
 
-  Serial.println("[Local] Schedule saved/updated");
+  g_storedCrc = newCrc;
+  g_haveStoredCrc = true;
+  Serial.printf("[Local] Schedule cache saved (%u rules, %u B)\n", (unsigned)count, (unsigned)len);
   return true;
 }
 
-//load the saved locally schedule
-bool localLoadSchedule(String &outJson) {
-  outJson = "";
-  if (!LittleFS.exists(SCHEDULE_FILE)) return false;
+// -------------------- Stats queue helpers --------------------
 
-  File f = LittleFS.open(SCHEDULE_FILE, "r");
-  if (!f) return false;
+// Old queue formats -> segments (once, on first use after the update)
+static void migrateOldQueueOnce();
+static void checkStage();
+
+static void loadCursor() {
+  if (g_cursorLoaded) return;
+  g_cursorLoaded = true;
+  if (!localPrefsOpen() ||
+      g_localPrefs.getBytes("qcur", &g_cursor, sizeof(g_cursor)) != sizeof(g_cursor) ||
+      g_cursor.magic != QUEUE_CURSOR_MAGIC) {
+    memset(&g_cursor, 0, sizeof(g_cursor)); // no cursor yet: oldest segment read from the top
+    g_cursor.magic = QUEUE_CURSOR_MAGIC;
+  }
+}
 
-  outJson = f.readString();
-  f.close();
+// One small NVS write per uploaded batch (instead of rewriting the file)
+static void saveCursor() {
+  g_qstats.nvsWrites++;
+  if (!localPrefsOpen() ||
+      g_localPrefs.putBytes("qcur", &g_cursor, sizeof(g_cursor)) != sizeof(g_cursor)) {
+    Serial.println("[Local] Failed to save queue cursor (records may be re-sent)");
+  }
+}
 
-  return outJson.length() > 0;
+static void setCursor(uint32_t day, uint32_t gen) {
+  g_cursor.day = day;
+  g_cursor.gen = gen;
+  g_cursor.offset = 0;
+  g_cursor.seq = 0;
 }
 
-// -------------------- Stats queue helpers --------------------
+static void segPath(uint32_t day, char* out, size_t outSize) {
+  snprintf(out, outSize, "%s/%08lu.bin", QUEUE_DIR, (unsigned long)day);
+}
 
-//deprecated function
-bool localWeightsQueueExists() {
-  return LittleFS.exists(WEIGHTS_QUEUE_FILE);
+static void saveManifest() {
+  g_qstats.nvsWrites++;
+  if (!localPrefsOpen() ||
+      g_localPrefs.putBytes("qman", &g_manifest, sizeof(g_manifest)) != sizeof(g_manifest)) {
+    Serial.println("[Local] Failed to save queue manifest");
+  }
 }
 
-// helper function for checking time
-static bool loadLastPruneTs(uint32_t &outTs) {
-  outTs = 0;
-  if (!LittleFS.exists(WEIGHTS_PRUNE_META)) return false;
+static void loadManifest() {
+  if (g_manifestLoaded) return;
+  g_manifestLoaded = true;
+  loadCursor();
+
+  if (!localPrefsOpen() ||
+      g_localPrefs.getBytes("qman", &g_manifest, sizeof(g_manifest)) != sizeof(g_manifest) ||
+      g_manifest.magic != QUEUE_MANIFEST_MAGIC || g_manifest.count > QUEUE_SEGMENTS_MAX) {
+    memset(&g_manifest, 0, sizeof(g_manifest));
+    g_manifest.magic = QUEUE_MANIFEST_MAGIC;
+    g_manifest.nextGen = 1;
+  }
+  if (!LittleFS.exists(QUEUE_DIR)) LittleFS.mkdir(QUEUE_DIR);
+
+  // sizes from the files; entries whose file is gone are dropped
+  bool changed = false;
+  uint32_t kept = 0;
+  char path[32];
+  for (uint32_t i = 0; i < g_manifest.count; i++) {
+    segPath(g_manifest.days[i], path, sizeof(path));
+    File f = LittleFS.open(path, "r");
+    if (!f) {
+      changed = true;
+      continue;
+    }
+    g_manifest.days[kept] = g_manifest.days[i];
+    g_segBytes[kept] = (uint32_t)f.size();
+    f.close();
+    kept++;
+  }
+  g_manifest.count = kept;
+  if (changed) saveManifest();
+}
 
-  File f = LittleFS.open(WEIGHTS_PRUNE_META, "r");
-  if (!f) return false;
+static int findSegment(uint32_t day) {
+  for (uint32_t i = 0; i < g_manifest.count; i++) {
+    if (g_manifest.days[i] == day) return (int)i;
+  }
+  return -1;
+}
 
-  String s = f.readString();
-  f.close();
+// Deletes segment i (file + manifest entry)
+static void dropSegment(uint32_t i, const char* why) {
+  if (i >= g_manifest.count) return;
+  const uint32_t day = g_manifest.days[i];
+  const uint32_t bytes = g_segBytes[i];
 
-  DynamicJsonDocument doc(256);
-  if (deserializeJson(doc, s)) return false;
+  for (uint32_t k = i + 1; k < g_manifest.count; k++) {
+    g_manifest.days[k - 1] = g_manifest.days[k];
+    g_segBytes[k - 1] = g_segBytes[k];
+  }
+  g_manifest.count--;
+  saveManifest();
 
-  outTs = doc["last_prune_ts"] | 0;
-  return true;
+  char path[32];
+  segPath(day, path, sizeof(path));
+  LittleFS.remove(path);
+
+  if (g_cursor.day == day) {
+    setCursor(0, 0);
+    saveCursor();
+  }
+  if (why) Serial.printf("[Local] Queue segment %08lu dropped (%s, %lu B)\n",
+                         (unsigned long)day, why, (unsigned long)bytes);
 }
 
-// helper function for checking time
-static bool saveLastPruneTs(uint32_t ts) {
-  DynamicJsonDocument doc(256);
-  doc["last_prune_ts"] = ts;
+static uint32_t segmentDay(uint32_t ts) {
+  if (ts == 0) return 0;
+  time_t t = (time_t)ts;
+  struct tm tmv;
+  localtime_r(&t, &tmv);
+  return (uint32_t)((tmv.tm_year + 1900) * 10000 + (tmv.tm_mon + 1) * 100 + tmv.tm_mday);
+}
 
-  File f = LittleFS.open(WEIGHTS_PRUNE_META, "w");
-  if (!f) return false;
+static uint32_t queueTotalBytes() {
+  uint32_t total = 0;
+  for (uint32_t i = 0; i < g_manifest.count; i++) total += g_segBytes[i];
+  return total;
+}
 
-  serializeJson(doc, f);
-  f.close();
-  return true;
+// Retention + quota: whole segments, oldest first (O(segments), no file reads)
+static void enforceQueueLimits(uint32_t nowTs) {
+  if (nowTs != 0) {
+    const uint32_t cutoffDay = segmentDay(nowTs - KEEP_WINDOW_SEC);
+    uint32_t i = 0;
+    while (i < g_manifest.count) {
+      const uint32_t day = g_manifest.days[i];
+      if (day != 0 && day < cutoffDay) dropSegment(i, "older than 7 days");
+      else i++;
+    }
+  }
+
+  while (g_manifest.count > 1 && queueTotalBytes() > QUEUE_QUOTA_BYTES) {
+    dropSegment(0, "flash quota");
+  }
+}
+
+//deprecated function
+bool localWeightsQueueExists() {
+  migrateOldQueueOnce();
+  return localWeightsQueueBytes() > 0;
+}
+
+// Bytes not uploaded yet (all segments minus the consumed head)
+size_t localWeightsQueueBytes() {
+  loadManifest();
+  checkStage();
+  uint32_t total = queueTotalBytes() + g_stage.len;
+  if (g_manifest.count > 0 && g_cursor.gen != 0 && g_cursor.day == g_manifest.days[0]) {
+    total -= (g_cursor.offset < g_segBytes[0]) ? g_cursor.offset : g_segBytes[0];
+  }
+  return total;
 }
 
 // helper function for checking time
@@ -148,438 +413,893 @@ static uint32_t getValidEpochOrZero() {
   return 0; // 0 means "unknown time"
 }
 
-// we dont want to store meals in local storage forever, so we delete the older than a week ones
-static bool pruneWeightsQueueIfDue() {
-  uint32_t now = getValidEpochOrZero();
-  if (now == 0) return true; // no valid time -> skip age-based pruning safely
+// 64-bit FNV-1a, used for the record idempotency keys
+static uint64_t fnv1a64(const void* data, size_t len, uint64_t h = 1469598103934665603ULL) {
+  const uint8_t* p = (const uint8_t*)data;
+  while (len--) {
+    h ^= *p++;
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
 
-  uint32_t lastPrune = 0;
-  loadLastPruneTs(lastPrune);
+static uint64_t fnv1a64Str(const char* s, uint64_t h) {
+  if (!s) s = "";
+  return fnv1a64(s, strlen(s) + 1, h); // include '\0' as field separator
+}
 
-  if (lastPrune != 0 && (now - lastPrune) < PRUNE_INTERVAL_SEC) {
-    return true; // not time yet
-  }
+// Deterministic key for a queued meal record without an event ID (lines queued
+// before event IDs existed): the same meal always maps to the same node.
+static void makeWeightRecordKey(uint32_t ts,
+                                int amount,
+                                int hh,
+                                int mm,
+                                const char* meal,
+                                const char* dateISO,
+                                char* out,
+                                size_t outSize) {
+  uint64_t h = 1469598103934665603ULL;
+  h = fnv1a64(&ts, sizeof(ts), h);
+  h = fnv1a64(&amount, sizeof(amount), h);
+  h = fnv1a64(&hh, sizeof(hh), h);
+  h = fnv1a64(&mm, sizeof(mm), h);
+  h = fnv1a64Str(meal, h);
+  h = fnv1a64Str(dateISO, h);
+
+  snprintf(out, outSize, "q%08lx%08lx",
+           (unsigned long)(h >> 32), (unsigned long)(h & 0xFFFFFFFFUL));
+}
 
-  if (!LittleFS.exists(WEIGHTS_QUEUE_FILE)) {
-    (void)saveLastPruneTs(now);
-    return true;
-  }
+// -------------------- Binary log frames --------------------
+static uint8_t* putStr(uint8_t* p, const char* s, size_t maxLen) {
+  size_t n = s ? strlen(s) : 0;
+  if (n > maxLen) n = maxLen;
+  *p++ = (uint8_t)n;
+  if (n) memcpy(p, s, n);
+  return p + n;
+}
 
-  File in = LittleFS.open(WEIGHTS_QUEUE_FILE, "r");
-  if (!in) return false;
+static bool getStr(const uint8_t*& p, const uint8_t* end, char* out, size_t outSize) {
+  if (p >= end) return false;
+  const size_t n = *p++;
+  if (n >= outSize || p + n > end) return false;
+  memcpy(out, p, n);
+  out[n] = '\0';
+  p += n;
+  return true;
+}
 
-  File out = LittleFS.open("/weights_queue.tmp", "w");
-  if (!out) {
-    in.close();
-    return false;
-  }
+static uint32_t packDate(const char* dateISO) {
+  unsigned y = 0, m = 0, d = 0;
+  if (!dateISO || sscanf(dateISO, "%4u-%2u-%2u", &y, &m, &d) != 3) return 0;
+  return (uint32_t)(y * 10000U + m * 100U + d);
+}
 
-  const uint32_t cutoff = now - KEEP_WINDOW_SEC;
+// Header + CRC around the payload already in g_frameBuf; returns the frame size
+static size_t sealFrame(uint8_t type, size_t len) {
+  g_frameBuf[0] = LOG_SYNC0;
+  g_frameBuf[1] = LOG_SYNC1;
+  g_frameBuf[2] = type;
+  g_frameBuf[3] = (uint8_t)len;
 
-  while (in.available()) {
-    String line = in.readStringUntil('\n');
-    line.trim();
-    if (line.length() == 0) continue;
+  const uint32_t crc = crc32(g_frameBuf + 2, len + 2);
+  memcpy(g_frameBuf + LOG_HEADER_SIZE + len, &crc, sizeof(crc));
+  return LOG_HEADER_SIZE + len + LOG_CRC_SIZE;
+}
 
-    DynamicJsonDocument doc(512);
-    DeserializationError err = deserializeJson(doc, line);
-    if (err) {
-      // corrupted / partial line -> drop it
-      continue;
-    }
+// Builds one weight frame in g_frameBuf; returns its size
+static size_t encodeWeightFrame(const WeightLogFixed& fx, const char* mealName, const char* day) {
+  uint8_t* payload = g_frameBuf + LOG_HEADER_SIZE;
+  memcpy(payload, &fx, sizeof(fx));
+  uint8_t* p = payload + sizeof(fx);
+  p = putStr(p, mealName, sizeof(((WeightQueueRecord*)0)->mealName) - 1);
+  p = putStr(p, day, sizeof(((WeightQueueRecord*)0)->day) - 1);
 
-    uint32_t ts = doc["ts"] | 0;
+  return sealFrame(LOG_REC_WEIGHT, (size_t)(p - payload));
+}
+
+// Payload of a weight frame -> upload record (reads straight from the frame buffer)
+static bool decodeWeightPayload(const uint8_t* payload, size_t len, WeightQueueRecord& rec) {
+  if (len < sizeof(WeightLogFixed)) return false;
+
+  WeightLogFixed fx;
+  memcpy(&fx, payload, sizeof(fx));
+  const uint8_t* p = payload + sizeof(fx);
+  const uint8_t* end = payload + len;
+  if (!getStr(p, end, rec.mealName, sizeof(rec.mealName))) return false;
+  if (!getStr(p, end, rec.day, sizeof(rec.day))) return false;
+
+  rec.amountGrams   = fx.amountGrams;
+  rec.feedHour      = fx.feedHour;
+  rec.feedMinute    = fx.feedMinute;
+  rec.prevWeight    = fx.prevWeight;
+  rec.currentWeight = fx.currentWeight;
+  if (fx.date) {
+    snprintf(rec.dateISO, sizeof(rec.dateISO), "%04lu-%02lu-%02lu",
+             (unsigned long)(fx.date / 10000UL) % 10000UL,
+             (unsigned long)(fx.date / 100UL) % 100UL,
+             (unsigned long)fx.date % 100UL);
+  } else {
+    rec.dateISO[0] = '\0';
+  }
+
+  if (fx.eventId != EVENT_ID_NONE) {
+    eventIdToKey(fx.eventId, rec.key, sizeof(rec.key)); // same node the live path would write
+  } else {
+    makeWeightRecordKey(fx.ts, rec.amountGrams, rec.feedHour, rec.feedMinute,
+                        rec.mealName, rec.dateISO, rec.key, sizeof(rec.key));
+  }
+  return true;
+}
 
-    // keep if:
-    // - ts is 0 (unknown time) OR
-    // - ts is within last 7 days
-    if (ts == 0 || ts >= cutoff) {
-      out.print(line);
-      out.print("\n");
+// Next valid frame into g_frameBuf (frameStart = its offset). Torn / corrupt
+// bytes are skipped by resyncing on the next sync pattern. false = end of file.
+static bool readFrame(File& in, size_t& frameStart, size_t& skippedBytes) {
+  while (true) {
+    const size_t pos = in.position();
+    if (in.read(g_frameBuf, LOG_HEADER_SIZE) != LOG_HEADER_SIZE) return false;
+
+    if (g_frameBuf[0] == LOG_SYNC0 && g_frameBuf[1] == LOG_SYNC1) {
+      const size_t len = g_frameBuf[3];
+      if (len <= LOG_PAYLOAD_MAX &&
+          in.read(g_frameBuf + LOG_HEADER_SIZE, len + LOG_CRC_SIZE) == len + LOG_CRC_SIZE) {
+        uint32_t stored;
+        memcpy(&stored, g_frameBuf + LOG_HEADER_SIZE + len, sizeof(stored));
+        if (crc32(g_frameBuf + 2, len + 2) == stored) {
+          frameStart = pos;
+          return true;
+        }
+      }
     }
+
+    in.seek(pos + 1, SeekSet);
+    skippedBytes++;
   }
+}
 
-  in.close();
-  out.close();
+static size_t frameSize() {
+  return LOG_HEADER_SIZE + g_frameBuf[3] + LOG_CRC_SIZE;
+}
 
-  LittleFS.remove(WEIGHTS_QUEUE_FILE);
-  LittleFS.rename("/weights_queue.tmp", WEIGHTS_QUEUE_FILE);
+// Generation frame that starts every log file
+static size_t encodeGenFrame(uint32_t gen, uint8_t* out) {
+  out[0] = LOG_SYNC0;
+  out[1] = LOG_SYNC1;
+  out[2] = LOG_REC_FILE_GEN;
+  out[3] = sizeof(gen);
+  memcpy(out + LOG_HEADER_SIZE, &gen, sizeof(gen));
+  const uint32_t crc = crc32(out + 2, sizeof(gen) + 2);
+  memcpy(out + LOG_HEADER_SIZE + sizeof(gen), &crc, sizeof(crc));
+  return LOG_HEADER_SIZE + sizeof(gen) + LOG_CRC_SIZE;
+}
 
-  (void)saveLastPruneTs(now);
-  Serial.println("[Local] Weights queue pruned (kept last 7 days, checked every 24h)");
-  return true;
+// Generation of an open log file (0 = file without one); leaves `in` at 0
+static uint32_t readFileGen(File& in) {
+  uint32_t gen = 0;
+  size_t frameStart = 0, skipped = 0;
+  in.seek(0, SeekSet);
+  if (readFrame(in, frameStart, skipped) && frameStart == 0 &&
+      g_frameBuf[2] == LOG_REC_FILE_GEN && g_frameBuf[3] == sizeof(gen)) {
+    memcpy(&gen, g_frameBuf + LOG_HEADER_SIZE, sizeof(gen));
+  }
+  in.seek(0, SeekSet);
+  return gen;
 }
 
-// add offline mode records here
-bool localQueueWeightUpdate(int dueAmount,
-                            int feed_hour,
-                            int feed_minute,
-                            const char* mealName,
-                            const char* day,
-                            const char* dateISO,
-                            float prevWeight,
-                            float currentWeight) {
-  // prune (at most once every 24h, only if time is valid)
-  (void)pruneWeightsQueueIfDue();
+// Appends whole frames to the day's segment (created with a generation frame)
+static bool writeSegment(uint32_t day, const uint8_t* data, size_t len) {
+  loadManifest();
+
+  int idx = findSegment(day);
+  uint32_t gen = 0;
+  if (idx < 0) {
+    if (g_manifest.count >= QUEUE_SEGMENTS_MAX) dropSegment(0, "too many segments");
+
+    // manifest first: a crash before the file exists only leaves an entry
+    // that the next load drops
+    uint32_t pos = g_manifest.count;
+    while (pos > 0 && g_manifest.days[pos - 1] > day) {
+      g_manifest.days[pos] = g_manifest.days[pos - 1];
+      g_segBytes[pos] = g_segBytes[pos - 1];
+      pos--;
+    }
+    g_manifest.days[pos] = day;
+    g_segBytes[pos] = 0;
+    g_manifest.count++;
+    gen = g_manifest.nextGen++;
+    saveManifest();
+    idx = (int)pos;
+  }
 
-  File f = LittleFS.open(WEIGHTS_QUEUE_FILE, "a");
+  char path[32];
+  segPath(day, path, sizeof(path));
+  File f = LittleFS.open(path, "a");
   if (!f) {
-    Serial.println("[Local] Failed to open weights queue for append");
+    Serial.println("[Local] Failed to open queue segment for append");
     return false;
   }
 
-  DynamicJsonDocument doc(512);
-  doc["type"] = "weight_update";
-  doc["ts"]   = getValidEpochOrZero(); // 0 if time invalid (safe)
+  const uint32_t start = g_segBytes[idx];
+  if (gen != 0) {
+    uint8_t genFrame[LOG_GEN_FRAME_SIZE];
+    g_segBytes[idx] += (uint32_t)f.write(genFrame, encodeGenFrame(gen, genFrame));
+  }
 
-  doc["dueAmount"]   = dueAmount;
-  doc["feed_hour"]   = feed_hour;
-  doc["feed_minute"] = feed_minute;
+  const size_t written = f.write(data, len);
+  f.close();
+  g_segBytes[idx] += (uint32_t)written;
 
-  doc["mealName"] = mealName ? mealName : "";
-  doc["day"]      = day ? day : "";
-  doc["dateISO"]  = dateISO ? dateISO : "";
+  // data pages programmed + one metadata commit per append (estimate)
+  const uint32_t end = g_segBytes[idx];
+  g_qstats.flashBytes += end - start;
+  if (end > start) g_qstats.flashPages += (end - 1) / FLASH_PAGE_BYTES - start / FLASH_PAGE_BYTES + 1;
+  g_qstats.flashPages++;
+  g_qstats.commits++;
 
-  doc["prevWeight"]    = prevWeight;
-  doc["currentWeight"] = currentWeight;
+  enforceQueueLimits(getValidEpochOrZero());
+  return written == len; // short write = torn frame, skipped by readers
+}
 
-  serializeJson(doc, f);
-  f.print("\n");
-  f.close();
+static uint32_t stageCrc() {
+  // header fields, then the staged bytes
+  return crc32((const uint8_t*)&g_stage.day, 2 * sizeof(uint32_t)) ^ crc32(g_stage.buf, g_stage.len);
+}
+
+static void clearStage() {
+  g_stage.magic = STAGE_MAGIC;
+  g_stage.day = 0;
+  g_stage.len = 0;
+  g_stage.crc = stageCrc();
+}
 
-  Serial.println("[Local] Queued weight update locally");
+// Once per boot: keep frames staged before a soft reset, drop power-on garbage
+static void checkStage() {
+  if (g_stageChecked) return;
+  g_stageChecked = true;
+  if (g_stage.magic == STAGE_MAGIC && g_stage.len <= STAGE_BYTES && g_stage.crc == stageCrc()) {
+    if (g_stage.len > 0) {
+      Serial.printf("[Local] %u staged queue bytes kept across reset\n", (unsigned)g_stage.len);
+      g_stageSinceMs = millis();
+    }
+    return;
+  }
+  clearStage();
+}
+
+// Staged frames -> flash in one append
+static bool commitStage() {
+  checkStage();
+  if (g_stage.len == 0) return true;
+  if (!writeSegment(g_stage.day, g_stage.buf, g_stage.len)) return false;
+  clearStage();
   return true;
 }
 
-// Flush queue to Firebase with safety:
-// - If upload fails on some line, keep that line + the remaining lines (so no duplicates)
-bool localFlushWeightsQueue(WeightUploadFn uploadFn) {
-  if (!uploadFn) return false;
+// Stages the frame in g_frameBuf; commits when a flash page is filled
+static bool stageFrame(uint32_t day, size_t frameLen) {
+  loadManifest();
+  checkStage();
+  g_qstats.records++;
+  g_qstats.recordBytes += (uint32_t)frameLen;
+
+  if (g_stage.len > 0 && (g_stage.day != day || g_stage.len + frameLen > STAGE_BYTES)) {
+    if (!commitStage()) return false;
+  }
 
-  if (!LittleFS.exists(WEIGHTS_QUEUE_FILE)) {
-    return true; // nothing to do
+  if (g_stage.len == 0) {
+    g_stage.day = day;
+    g_stageSinceMs = millis();
   }
+  memcpy(g_stage.buf + g_stage.len, g_frameBuf, frameLen);
+  g_stage.len += (uint32_t)frameLen;
+  g_stage.crc = stageCrc();
+
+  // segment tail (a new segment starts with its generation frame)
+  const int idx = findSegment(day);
+  const uint32_t tail = (idx >= 0) ? g_segBytes[idx] : LOG_GEN_FRAME_SIZE;
+  if ((tail % FLASH_PAGE_BYTES) + g_stage.len >= FLASH_PAGE_BYTES) return commitStage();
+  return true;
+}
 
-  // optional prune before flush (still respects 24h rule)
-  (void)pruneWeightsQueueIfDue();
+bool localQueueCommit() {
+  loadManifest();
+  return commitStage();
+}
 
-  File in = LittleFS.open(WEIGHTS_QUEUE_FILE, "r");
-  if (!in) return false;
+void localQueueTick() {
+  checkStage();
+  if (g_stage.len == 0) return;
+  if ((millis() - g_stageSinceMs) < STAGE_MAX_AGE_MS) return;
+  if (!localQueueCommit()) g_stageSinceMs = millis(); // retry after another interval
+}
 
-  File out = LittleFS.open("/weights_queue.rem", "w"); // remaining lines if fail
-  if (!out) {
-    in.close();
-    return false;
+void localGetQueueStats(LocalQueueStats &out) {
+  out = g_qstats;
+  checkStage();
+  out.stagedBytes = g_stage.len;
+}
+
+
+
+// Opens segment i at the read cursor (cursor moved to it if it pointed elsewhere)
+static File openSegmentAtCursor(uint32_t i) {
+  char path[32];
+  segPath(g_manifest.days[i], path, sizeof(path));
+  File in = LittleFS.open(path, "r");
+  if (!in) return in;
+
+  const uint32_t gen = readFileGen(in);
+  if (g_cursor.day != g_manifest.days[i] || g_cursor.gen != gen || gen == 0 ||
+      g_cursor.offset > in.size()) {
+    setCursor(g_manifest.days[i], gen);
   }
+  in.seek(g_cursor.offset, SeekSet);
+  return in;
+}
 
-  bool failed = false;
+// Single-file binary log -> segment 0 (a rename; its read cursor is kept)
+static void adoptOldLogFile() {
+  if (LittleFS.exists(OLD_PRUNE_META)) LittleFS.remove(OLD_PRUNE_META);
+  if (!LittleFS.exists(OLD_WEIGHTS_LOG_FILE)) return;
+  loadManifest();
 
-  while (in.available()) {
-    String line = in.readStringUntil('\n');
-    line.trim();
-    if (line.length() == 0) continue;
+  char path[32];
+  segPath(0, path, sizeof(path));
+  if (findSegment(0) >= 0 || !LittleFS.rename(OLD_WEIGHTS_LOG_FILE, path)) {
+    Serial.println("[Local] Could not move the old weights log into a segment");
+    return;
+  }
 
-    DynamicJsonDocument doc(512);
-    DeserializationError err = deserializeJson(doc, line);
-    if (err) {
-      // drop corrupted line
-      continue;
-    }
+  File f = LittleFS.open(path, "r");
+  const uint32_t bytes = f ? (uint32_t)f.size() : 0;
+  const uint32_t gen = f ? readFileGen(f) : 0;
+  if (f) f.close();
 
-    // Parse fields (match what we stored)
-    int dueAmount = doc["dueAmount"] | 0;
-    int hh        = doc["feed_hour"] | 0;
-    int mm        = doc["feed_minute"] | 0;
-
-    const char* meal = doc["mealName"] | "";
-    const char* day  = doc["day"]      | "";
-    const char* date = doc["dateISO"]  | "";
-
-    float prevW = doc["prevWeight"]    | 0.0f;
-    float currW = doc["currentWeight"] | 0.0f;
-
-    bool ok = uploadFn(dueAmount, hh, mm, meal, day, date, prevW, currW);
-    if (!ok) {
-      // Keep this line + everything after it
-      failed = true;
-      out.print(line);
-      out.print("\n");
-
-      while (in.available()) {
-        String rest = in.readStringUntil('\n');
-        rest.trim();
-        if (rest.length() == 0) continue;
-        out.print(rest);
-        out.print("\n");
-      }
-      break;
-    }
+  for (uint32_t i = g_manifest.count; i > 0; i--) {
+    g_manifest.days[i] = g_manifest.days[i - 1];
+    g_segBytes[i] = g_segBytes[i - 1];
+  }
+  g_manifest.days[0] = 0;
+  g_segBytes[0] = bytes;
+  g_manifest.count++;
+  if (g_manifest.nextGen <= gen) g_manifest.nextGen = gen + 1;
+  saveManifest();
+
+  // old cursor ("QCR1": magic, gen, offset, seq) -> same position in segment 0
+  uint32_t old[4];
+  if (localPrefsOpen() && g_localPrefs.getBytesLength("qcur") == sizeof(old) &&
+      g_localPrefs.getBytes("qcur", old, sizeof(old)) == sizeof(old) &&
+      old[0] == 0x51435231 && old[1] == gen && gen != 0) {
+    g_cursor.magic = QUEUE_CURSOR_MAGIC;
+    g_cursor.day = 0;
+    g_cursor.gen = gen;
+    g_cursor.offset = old[2];
+    g_cursor.seq = old[3];
+    saveCursor();
   }
+  Serial.printf("[Local] Old weights log (%lu B) moved to a queue segment\n", (unsigned long)bytes);
+}
 
+static void migrateOldQueueOnce() {
+  static bool checked = false;
+  if (checked) return;
+  checked = true;
+  adoptOldLogFile();
+  if (!LittleFS.exists(OLD_WEIGHTS_QUEUE_FILE)) return;
+
+  File in = LittleFS.open(OLD_WEIGHTS_QUEUE_FILE, "r");
+  if (!in) return;
+  in.setTimeout(0); // a torn last line must not block on the Stream timeout
+
+  size_t moved = 0;
+  bool ok = true;
+  while (in.available() && ok) {
+    size_t n = in.readBytesUntil('\n', g_lineBuf, sizeof(g_lineBuf) - 1);
+    while (n > 0 && (g_lineBuf[n - 1] == '\r' || g_lineBuf[n - 1] == ' ')) n--;
+    g_lineBuf[n] = '\0';
+    if (n == 0) continue;
+
+    g_recordPool.reset();
+    JsonDocument doc(&g_recordPool);
+    if (deserializeJson(doc, g_lineBuf, n)) continue; // corrupted line -> dropped
+
+    WeightLogFixed fx;
+    fx.ts            = doc["ts"] | 0;
+    fx.amountGrams   = (int16_t)(doc["dueAmount"] | 0);
+    fx.feedHour      = (uint8_t)(doc["feed_hour"] | 0);
+    fx.feedMinute    = (uint8_t)(doc["feed_minute"] | 0);
+    fx.prevWeight    = doc["prevWeight"] | 0.0f;
+    fx.currentWeight = doc["currentWeight"] | 0.0f;
+    fx.date          = packDate(doc["dateISO"] | "");
+
+    // "e<16 hex>" = event key; derived "q..." keys are re-derived from the same fields
+    const char* key = doc["key"] | "";
+    fx.eventId = (key[0] == 'e' && strlen(key) == 17) ? strtoull(key + 1, nullptr, 16) : EVENT_ID_NONE;
+
+    ok = stageFrame(segmentDay(fx.ts), encodeWeightFrame(fx, doc["mealName"] | "", doc["day"] | ""));
+    if (ok) moved++;
+  }
   in.close();
-  out.close();
+  if (ok) ok = commitStage(); // on flash before the old file goes
 
-  if (!failed) {
-    // All uploaded -> delete queue + cleanup remainder file
-    LittleFS.remove(WEIGHTS_QUEUE_FILE);
-    LittleFS.remove("/weights_queue.rem");
-    Serial.println("[Local]  Queue fully uploaded -> deleted local queue file");
-    return true;
+  if (!ok) {
+    Serial.println("[Local] Queue migration failed -> will retry next boot");
+    return;
   }
+  LittleFS.remove(OLD_WEIGHTS_QUEUE_FILE);
+  Serial.printf("[Local] Migrated %u queued records to the binary log\n", (unsigned)moved);
+}
 
-  // Failure -> replace queue with remaining lines only
-  LittleFS.remove(WEIGHTS_QUEUE_FILE);
-  LittleFS.rename("/weights_queue.rem", WEIGHTS_QUEUE_FILE);
-  Serial.println("[Local]  Queue upload partial -> kept remaining lines for retry");
-  return false;
+// add offline mode records here (one small frame appended, O(1))
+bool localQueueWeightUpdate(int dueAmount,
+                            int feed_hour,
+                            int feed_minute,
+                            const char* mealName,
+                            const char* day,
+                            const char* dateISO,
+                            float prevWeight,
+                            float currentWeight,
+                            uint64_t eventId) {
+  migrateOldQueueOnce();
+
+  WeightLogFixed fx;
+  fx.ts            = getValidEpochOrZero(); // 0 if time invalid (safe)
+  fx.eventId       = eventId;
+  fx.amountGrams   = (int16_t)dueAmount;
+  fx.feedHour      = (uint8_t)feed_hour;
+  fx.feedMinute    = (uint8_t)feed_minute;
+  fx.prevWeight    = prevWeight;
+  fx.currentWeight = currentWeight;
+  fx.date          = packDate(dateISO);
+
+  const size_t frameLen = encodeWeightFrame(fx, mealName, day);
+  if (!stageFrame(segmentDay(fx.ts), frameLen)) return false;
+
+  Serial.printf("[Local] Queued weight update locally (%u B)\n", (unsigned)frameLen);
+  return true;
 }
 
-// -------------------- Phase 3: Offline schedule execution --------------------
+// Flush queue to Firebase in batches (one multi-location write per batch),
+// oldest segment first. Keys are deterministic, so a batch that failed
+// half-way is simply re-sent.
+bool localFlushWeightsQueueBatched(WeightBatchUploadFn uploadFn) {
+  if (!uploadFn) return false;
 
-// Local schedule state (mirrors FirebaseManager behavior)
-struct LocalScheduleEntry {
-  bool enabled;
-  int hour;
-  int minute;
-  int amountGrams;
-  char mealName[24];
-};
+  migrateOldQueueOnce();
+  loadManifest();
+  if (!commitStage()) return false;
+  enforceQueueLimits(getValidEpochOrZero());
 
-static LocalScheduleEntry g_localSchedule[6];
-static bool g_localFiredToday[6] = {false,false,false,false,false,false};
-static int g_localLastYDay = -1;
+  static WeightQueueRecord batch[WEIGHTS_BATCH_MAX];
+  size_t uploaded = 0;
+  size_t skipped = 0;
 
-// For detecting per-slot changes (so we can reset fired flag only for changed slots)
-static uint32_t g_localSlotSig[6] = {0,0,0,0,0,0};
+  while (g_manifest.count > 0) {
+    File in = openSegmentAtCursor(0);
+    if (!in) {
+      dropSegment(0, "unreadable");
+      continue;
+    }
 
-// Cache parsed JSON in RAM (so we don’t parse on every loop)
-static uint32_t g_lastScheduleCrcRam = 0;
-static bool g_haveCrcRam = false;
-static unsigned long g_lastParseMs = 0;
-static const unsigned long LOCAL_PARSE_THROTTLE_MS = 5000; // don’t parse more than every 5s
+    bool failed = false;
+    while (true) {
+      size_t frameStart = 0;
+      size_t n = 0;
 
-static uint32_t fnv1a32_local(const char* s) {//helper function for parsing the schedule
-  uint32_t h = 2166136261u;
-  if (!s) return h;
-  while (*s) {
-    h ^= (uint8_t)(*s++);
-    h *= 16777619u;
-  }
-  return h;
-}
+      while (n < WEIGHTS_BATCH_MAX && readFrame(in, frameStart, skipped)) {
+        if (g_frameBuf[2] != LOG_REC_WEIGHT) continue;
+        if (!decodeWeightPayload(g_frameBuf + LOG_HEADER_SIZE, g_frameBuf[3], batch[n])) continue;
+        n++;
+      }
 
-static uint32_t computeLocalSlotSig(const LocalScheduleEntry& e) {//helper function for parsing the schedule
-  if (!e.enabled) return 0;
-  uint32_t h = 2166136261u;
-  h ^= (uint32_t)e.hour;        h *= 16777619u;
-  h ^= (uint32_t)e.minute;      h *= 16777619u;
-  h ^= (uint32_t)e.amountGrams; h *= 16777619u;
-  h ^= fnv1a32_local(e.mealName); h *= 16777619u;
-  return h;
-}
+      if (n == 0) break;
 
-// Parse "HH:MM" (or ISO string with 'T')
-static bool parseHourMinuteLocal(const char* s, int &hourOut, int &minuteOut) { // feeding parser for offline
-  if (!s || !*s) return false;
-  const char* t = strchr(s, 'T');
-  const char* p = (t) ? (t + 1) : s;
+      if (!uploadFn(batch, n)) {
+        failed = true;
+        break;
+      }
 
-  if (!(p[0] && p[1] && p[2] == ':' && p[3] && p[4])) return false;
+      // only the cursor moves; the file is not touched
+      g_cursor.offset = (uint32_t)in.position();
+      g_cursor.seq += (uint32_t)n;
+      saveCursor();
+      uploaded += n;
+    }
+    in.close();
+
+    if (failed) {
+      Serial.printf("[Local]  Batch upload failed after %u records -> cursor kept at %08lu:%lu for retry\n",
+                    (unsigned)uploaded, (unsigned long)g_cursor.day, (unsigned long)g_cursor.offset);
+      return false;
+    }
 
-  hourOut = (p[0]-'0')*10 + (p[1]-'0');
-  minuteOut = (p[3]-'0')*10 + (p[4]-'0');
+    dropSegment(0, nullptr); // fully uploaded
+  }
 
-  if (hourOut < 0 || hourOut > 23 || minuteOut < 0 || minuteOut > 59) return false;
+  if (skipped) Serial.printf("[Local] Skipped %u torn/corrupt bytes in the weights log\n", (unsigned)skipped);
+  if (uploaded) {
+    Serial.printf("[Local]  Queue fully uploaded (%u records, batched) -> segments deleted\n",
+                  (unsigned)uploaded);
+  }
   return true;
 }
 
-static void resetLocalDailyFiredIfNeeded() { // helper function to make sure we deploy each feeding only once
-  time_t now = time(nullptr);
-  if (now < 100000) return; // NTP not ready
+// -------------------- No-clock feed log --------------------
+// Feeds done while the clock was never set (no NTP since boot) are logged one
+// by one in /noclock.bin (same frames as the queue) with their boot ID and
+// millis() offset. Once the clock is valid the offsets are anchored to wall
+// time and the feeds move to the weights queue as normal records:
+// - this boot: boot start = now - millis() -> exact (to the NTP error)
+// - earlier boots: walked back from the start of the following boot with
+//   each boot's uptime at reset. That uptime is checkpointed in RTC memory
+//   (kept across soft resets) and logged at the next boot; after a power cut
+//   the boot's last logged feed stands in for it -> estimate.
+static const char* NO_CLOCK_LOG_FILE = "/noclock.bin";
+static const uint32_t NO_CLOCK_LOG_MAX_BYTES = 4096;     // ~100 feeds (fewer with readings)
+#define NO_CLOCK_BOOTS_MAX 16
+
+struct __attribute__((packed)) NoClockFeedFixed {
+  uint32_t bootId;
+  uint32_t offsetMs;           // millis() at feed start
+  uint64_t eventId;
+  int16_t amountGrams;
+  float startWeight;
+  float endWeight;
+};
 
-  struct tm tmNow;
-  localtime_r(&now, &tmNow);
+struct __attribute__((packed)) NoClockReading {
+  uint64_t eventId;            // feed the reading belongs to
+  float weight;                // bowl weight after the feed (eating session, next feed)
+};
 
-  if (g_localLastYDay == -1) {
-    g_localLastYDay = tmNow.tm_yday;
-    return;
-  }
+struct __attribute__((packed)) NoClockBootEnd {
+  uint32_t bootId;
+  uint32_t uptimeMs;           // millis() at the last checkpoint of that boot
+};
+
+static const uint32_t UPTIME_MAGIC = 0x55505431; // "UPT1"
 
-  if (tmNow.tm_yday != g_localLastYDay) {
-    g_localLastYDay = tmNow.tm_yday;
-    for (int i = 0; i < 6; i++) g_localFiredToday[i] = false;
+struct UptimeCheckpoint {
+  uint32_t magic;
+  uint32_t bootId;
+  uint32_t uptimeMs;
+  uint32_t check;              // ~(bootId ^ uptimeMs): power-on garbage is ignored
+};
+
+static RTC_NOINIT_ATTR UptimeCheckpoint g_uptime;
+static uint32_t g_noClockBoot = 0;
+static bool g_noClockPending = false;    // log file has feeds to anchor
+static int64_t g_noClockBootStartMs = 0; // this boot's start as the last anchoring set it
+
+struct NoClockBoot {
+  uint32_t bootId;
+  uint32_t uptimeMs;
+  bool uptimeKnown;            // from a checkpoint (else last feed offset)
+  int64_t startEpochMs;
+};
+
+static NoClockBoot g_noClockBoots[NO_CLOCK_BOOTS_MAX];
+
+static bool appendNoClockFrame(size_t frameLen) {
+  File f = LittleFS.open(NO_CLOCK_LOG_FILE, "a");
+  if (!f) {
+    Serial.println("[Local] Failed to open no-clock log");
+    return false;
   }
+  if (f.size() + frameLen > NO_CLOCK_LOG_MAX_BYTES) {
+    f.close();
+    Serial.println("[Local] No-clock log full -> not logged");
+    return false;
+  }
+  const size_t written = f.write(g_frameBuf, frameLen);
+  f.close();
+  return written == frameLen;
 }
 
-static void clearLocalSchedule() {
-  for (int i = 0; i < 6; i++) {
-    g_localSchedule[i].enabled = false;
-    g_localSchedule[i].hour = 0;
-    g_localSchedule[i].minute = 0;
-    g_localSchedule[i].amountGrams = 0;
-    g_localSchedule[i].mealName[0] = '\0';
+void localNoClockBegin(uint32_t bootCounter) {
+  g_noClockBoot = bootCounter;
+  g_noClockPending = LittleFS.exists(NO_CLOCK_LOG_FILE);
+
+  // uptime of the previous boot (soft reset only) -> chains its feeds to this boot
+  if (g_noClockPending && g_uptime.magic == UPTIME_MAGIC &&
+      g_uptime.check == ~(g_uptime.bootId ^ g_uptime.uptimeMs) && g_uptime.bootId != bootCounter) {
+    NoClockBootEnd be = {g_uptime.bootId, g_uptime.uptimeMs};
+    memcpy(g_frameBuf + LOG_HEADER_SIZE, &be, sizeof(be));
+    (void)appendNoClockFrame(sealFrame(LOG_REC_BOOT_END, sizeof(be)));
   }
+
+  g_uptime.magic = UPTIME_MAGIC;
+  g_uptime.bootId = bootCounter;
+  g_uptime.uptimeMs = millis();
+  g_uptime.check = ~(g_uptime.bootId ^ g_uptime.uptimeMs);
 }
 
-// Parse cached schedule JSON into g_localSchedule[] (V2 schema)
-static bool parseLocalScheduleJson(const String &json) {
-  if (json.length() == 0) return false;
+bool localLogNoClockFeed(uint64_t eventId,
+                         uint32_t startMs,
+                         int amountGrams,
+                         float startWeight,
+                         float endWeight,
+                         const char* mealName) {
+  NoClockFeedFixed fx;
+  fx.bootId      = g_noClockBoot;
+  fx.offsetMs    = startMs;
+  fx.eventId     = eventId;
+  fx.amountGrams = (int16_t)amountGrams;
+  fx.startWeight = startWeight;
+  fx.endWeight   = endWeight;
+
+  uint8_t* payload = g_frameBuf + LOG_HEADER_SIZE;
+  memcpy(payload, &fx, sizeof(fx));
+  uint8_t* p = putStr(payload + sizeof(fx), mealName, sizeof(((WeightQueueRecord*)0)->mealName) - 1);
+  if (!appendNoClockFrame(sealFrame(LOG_REC_NO_CLOCK_FEED, (size_t)(p - payload)))) return false;
+
+  g_noClockPending = true;
+  Serial.printf("[Local] No-clock feed logged (boot %lu, +%lu s, %d g)\n",
+                (unsigned long)fx.bootId, (unsigned long)(startMs / 1000UL), amountGrams);
+  return true;
+}
 
-  DynamicJsonDocument doc(4096);
-  DeserializationError err = deserializeJson(doc, json);
-  if (err) {
-    Serial.print("[Local] deserializeJson failed: ");
-    Serial.println(err.c_str());
-    return false;
-  }
+bool localLogNoClockReading(uint64_t eventId, float bowlWeight) {
+  if (!g_noClockPending) return false;   // feed already queued (or never logged)
 
-  clearLocalSchedule();
+  NoClockReading r = {eventId, bowlWeight};
+  memcpy(g_frameBuf + LOG_HEADER_SIZE, &r, sizeof(r));
+  return appendNoClockFrame(sealFrame(LOG_REC_NO_CLOCK_READING, sizeof(r)));
+}
 
-  auto loadOne = [&](JsonObject feeding, int slot) {
-    const char* hourStr = feeding["hour"] | "";
-    int grams           = feeding["amount_grams"] | 0;
-    const char* mealStr = feeding["meal_name"] | "";
+static NoClockBoot* noClockBoot(uint32_t bootId) {
+  for (int i = 0; i < NO_CLOCK_BOOTS_MAX; i++) {
+    if (g_noClockBoots[i].bootId == bootId) return &g_noClockBoots[i];
+  }
+  for (int i = 0; i < NO_CLOCK_BOOTS_MAX; i++) {
+    if (g_noClockBoots[i].bootId == 0) {
+      g_noClockBoots[i].bootId = bootId;
+      return &g_noClockBoots[i];
+    }
+  }
+  return nullptr;
+}
 
-    int hh = 0, mm = 0;
-    if (!parseHourMinuteLocal(hourStr, hh, mm)) return;
-    if (grams <= 0) return;
+// Every boot in the log gets a start time: this boot from the clock, older
+// ones back-to-back before the next newer one
+static void anchorNoClockBoots(uint32_t nowTs) {
+  int64_t nextStart = (int64_t)nowTs * 1000LL - (int64_t)millis();
+  g_noClockBootStartMs = nextStart;
+  uint32_t nextBoot = 0xFFFFFFFFUL;
+
+  while (true) {
+    NoClockBoot* newest = nullptr;
+    for (int i = 0; i < NO_CLOCK_BOOTS_MAX; i++) {
+      NoClockBoot& b = g_noClockBoots[i];
+      if (b.bootId == 0 || b.bootId >= nextBoot) continue;
+      if (!newest || b.bootId > newest->bootId) newest = &b;
+    }
+    if (!newest) return;
 
-    g_localSchedule[slot].enabled = true;
-    g_localSchedule[slot].hour = hh;
-    g_localSchedule[slot].minute = mm;
-    g_localSchedule[slot].amountGrams = grams;
+    if (newest->bootId == g_noClockBoot) newest->startEpochMs = nextStart;
+    else newest->startEpochMs = nextStart - (int64_t)newest->uptimeMs;
+    nextStart = newest->startEpochMs;
+    nextBoot = newest->bootId;
+  }
+}
 
-    strncpy(g_localSchedule[slot].mealName, mealStr,
-            sizeof(g_localSchedule[slot].mealName) - 1);
-    g_localSchedule[slot].mealName[sizeof(g_localSchedule[slot].mealName) - 1] = '\0';
+static const char* weekdayName(int wday) {
+  static const char* names[] = {
+    "sunday", "monday", "tuesday", "wednesday",
+    "thursday", "friday", "saturday"
   };
+  return (wday >= 0 && wday < 7) ? names[wday] : "unknown";
+}
 
-  if (doc.is<JsonObject>()) {
-    JsonObject root = doc.as<JsonObject>();
-    for (int i = 0; i < 6; i++) {
-      String key = String(i);
-      if (!root.containsKey(key)) continue;
-
-      JsonObject feeding = root[key].as<JsonObject>();
-      if (feeding.isNull()) continue;
+// Reconstructed feed time -> record ts/hour/minute/date (left 0 if not
+// before now); returns the day name
+static const char* noClockFeedTime(int64_t epochMs, uint32_t nowTs, WeightLogFixed& fx) {
+  if (epochMs <= 0 || epochMs / 1000LL > (int64_t)nowTs) return "unknown";
+  const time_t t = (time_t)(epochMs / 1000LL);
+  struct tm tmv;
+  localtime_r(&t, &tmv);
+  fx.ts         = (uint32_t)t;
+  fx.feedHour   = (uint8_t)tmv.tm_hour;
+  fx.feedMinute = (uint8_t)tmv.tm_min;
+  fx.date       = (uint32_t)((tmv.tm_year + 1900) * 10000 + (tmv.tm_mon + 1) * 100 + tmv.tm_mday);
+  return weekdayName(tmv.tm_wday);
+}
 
-      loadOne(feeding, i);
-    }
-  } else if (doc.is<JsonArray>()) {
-    JsonArray arr = doc.as<JsonArray>();
-    for (int i = 0; i < (int)arr.size() && i < 6; i++) {
-      JsonObject feeding = arr[i].as<JsonObject>();
-      if (feeding.isNull()) continue;
+// Logged feeds -> weights queue with reconstructed timestamps
+static bool anchorNoClockLog(uint32_t nowTs) {
+  File in = LittleFS.open(NO_CLOCK_LOG_FILE, "r");
+  if (!in) {
+    g_noClockPending = false;
+    return true;
+  }
 
-      loadOne(feeding, i);
+  // pass 1: boots and their uptimes
+  memset(g_noClockBoots, 0, sizeof(g_noClockBoots));
+  size_t frameStart = 0, skipped = 0;
+  while (readFrame(in, frameStart, skipped)) {
+    const uint8_t* payload = g_frameBuf + LOG_HEADER_SIZE;
+    if (g_frameBuf[2] == LOG_REC_BOOT_END && g_frameBuf[3] == sizeof(NoClockBootEnd)) {
+      NoClockBootEnd be;
+      memcpy(&be, payload, sizeof(be));
+      NoClockBoot* b = noClockBoot(be.bootId);
+      if (b) {
+        b->uptimeMs = be.uptimeMs;
+        b->uptimeKnown = true;
+      }
+    } else if (g_frameBuf[2] == LOG_REC_NO_CLOCK_FEED && g_frameBuf[3] >= sizeof(NoClockFeedFixed)) {
+      NoClockFeedFixed fx;
+      memcpy(&fx, payload, sizeof(fx));
+      NoClockBoot* b = noClockBoot(fx.bootId);
+      if (b && !b->uptimeKnown && fx.offsetMs > b->uptimeMs) b->uptimeMs = fx.offsetMs;
     }
-  } else {
-    Serial.println("[Local] schedule format error: expected JSON object or array");
-    return false;
   }
-
-  // Reset only changed slots’ fired flag (match Firebase behavior)
-  for (int i = 0; i < 6; i++) {
-    uint32_t newSig = computeLocalSlotSig(g_localSchedule[i]);
-    if (newSig != g_localSlotSig[i]) {
-      g_localFiredToday[i] = false;
-      g_localSlotSig[i] = newSig;
-      Serial.printf("[Local] slot %d changed -> reset firedToday\n", i);
+  anchorNoClockBoots(nowTs);
+
+  // pass 2: one queue record per feed. A feed is held until the next one:
+  // its readings (logged after it, same event key) fill in the later weight.
+  in.seek(0, SeekSet);
+  static uint8_t feedPayload[LOG_PAYLOAD_MAX];
+  WeightLogFixed held;
+  char heldMeal[sizeof(((WeightQueueRecord*)0)->mealName)];
+  const char* heldDay = "unknown";
+  bool holding = false;
+  size_t moved = 0, estimated = 0;
+  bool ok = true;
+  while (ok && readFrame(in, frameStart, skipped)) {
+    if (g_frameBuf[2] == LOG_REC_NO_CLOCK_READING && g_frameBuf[3] == sizeof(NoClockReading)) {
+      NoClockReading r;
+      memcpy(&r, g_frameBuf + LOG_HEADER_SIZE, sizeof(r));
+      if (holding && r.eventId == held.eventId) held.currentWeight = r.weight;
+      continue;
     }
-    if (!g_localSchedule[i].enabled) {
-      g_localFiredToday[i] = false;
-      g_localSlotSig[i] = 0;
+    if (g_frameBuf[2] != LOG_REC_NO_CLOCK_FEED || g_frameBuf[3] < sizeof(NoClockFeedFixed)) continue;
+
+    const size_t len = g_frameBuf[3];
+    memcpy(feedPayload, g_frameBuf + LOG_HEADER_SIZE, len); // g_frameBuf is reused for the queue frame
+    NoClockFeedFixed nc;
+    memcpy(&nc, feedPayload, sizeof(nc));
+    const uint8_t* p = feedPayload + sizeof(nc);
+    char meal[sizeof(heldMeal)];
+    if (!getStr(p, feedPayload + len, meal, sizeof(meal))) continue;
+
+    const NoClockBoot* b = noClockBoot(nc.bootId);
+    if (!b) continue; // more boots than NO_CLOCK_BOOTS_MAX (oldest) -> dropped
+    if (nc.bootId != g_noClockBoot) estimated++;
+
+    if (holding) {
+      ok = stageFrame(segmentDay(held.ts), encodeWeightFrame(held, heldMeal, heldDay));
+      if (ok) moved++;
     }
+
+    // same fields as a live record: bowl after the feed, then the later
+    // reading (none yet -> the same weight, nothing eaten)
+    memset(&held, 0, sizeof(held));
+    held.eventId       = nc.eventId;
+    held.amountGrams   = nc.amountGrams;
+    held.prevWeight    = nc.endWeight;
+    held.currentWeight = nc.endWeight;
+    heldDay = noClockFeedTime(b->startEpochMs + (int64_t)nc.offsetMs, nowTs, held);
+    memcpy(heldMeal, meal, sizeof(heldMeal));
+    holding = true;
+  }
+  if (ok && holding) {
+    ok = stageFrame(segmentDay(held.ts), encodeWeightFrame(held, heldMeal, heldDay));
+    if (ok) moved++;
   }
+  in.close();
 
-  Serial.println("[Local]  Schedule loaded from cache:");
-  for (int i = 0; i < 6; i++) {
-    if (!g_localSchedule[i].enabled) {
-      Serial.printf("[Local] #%d: (disabled)\n", i);
-    } else {
-      Serial.printf("[Local] #%d: %02d:%02d grams=%d meal=%s\n",
-                    i,
-                    g_localSchedule[i].hour,
-                    g_localSchedule[i].minute,
-                    g_localSchedule[i].amountGrams,
-                    g_localSchedule[i].mealName);
-    }
+  // on flash before the log goes; a crash in between re-queues the same event keys
+  if (ok) ok = commitStage();
+  if (!ok) {
+    Serial.println("[Local] No-clock log -> queue failed, will retry");
+    return false;
   }
 
+  LittleFS.remove(NO_CLOCK_LOG_FILE);
+  g_noClockPending = false;
+  Serial.printf("[Local] %u no-clock feeds timestamped and queued (%u from earlier boots, estimated)\n",
+                (unsigned)moved, (unsigned)estimated);
   return true;
 }
 
-// Ensure local schedule is parsed (only re-parse if file content changed)
-static bool ensureLocalScheduleUpToDate() { // make sure offline schedule is the same as the online schedule
-  if (g_lastParseMs != 0 && (millis() - g_lastParseMs) < LOCAL_PARSE_THROTTLE_MS) {
-    return true;
-  }
-  g_lastParseMs = millis();
+void localNoClockTick(bool clockValid) {
+  g_uptime.uptimeMs = millis();
+  g_uptime.check = ~(g_uptime.bootId ^ g_uptime.uptimeMs);
 
-  String json;
-  if (!localLoadSchedule(json)) {
-    Serial.println("[Local] No schedule cache file found");
-    return false;
-  }
+  if (!clockValid || !g_noClockPending) return;
+  const uint32_t nowTs = getValidEpochOrZero();
+  if (nowTs == 0) return;
 
-  uint32_t crc = crc32((const uint8_t*)json.c_str(), json.length());
-  if (g_haveCrcRam && crc == g_lastScheduleCrcRam) {
-    return true;
-  }
+  static unsigned long lastTryMs = 0;
+  if (lastTryMs != 0 && (millis() - lastTryMs) < 60000UL) return; // failed before -> retry once a minute
+  lastTryMs = millis();
+  if (anchorNoClockLog(nowTs)) lastTryMs = 0;
+}
 
-  bool ok = parseLocalScheduleJson(json);
-  if (ok) {
-    g_lastScheduleCrcRam = crc;
-    g_haveCrcRam = true;
-  }
-  return ok;
+bool localNoClockFeedTime(uint32_t startMs,
+                          int &feedHour,
+                          int &feedMinute,
+                          char* dayOut, size_t dayOutSize,
+                          char* dateOut, size_t dateOutSize) {
+  if (g_noClockPending) return false;   // the log still owns the record
+  const uint32_t nowTs = getValidEpochOrZero();
+  if (nowTs == 0) return false;
+
+  // same boot start as the anchoring, so the record keeps its time fields
+  const int64_t bootStartMs = g_noClockBootStartMs ? g_noClockBootStartMs
+                                                   : (int64_t)nowTs * 1000LL - (int64_t)millis();
+  WeightLogFixed fx;
+  memset(&fx, 0, sizeof(fx));
+  const char* dayName = noClockFeedTime(bootStartMs + (int64_t)startMs, nowTs, fx);
+  if (fx.date == 0) return false;
+
+  feedHour = fx.feedHour;
+  feedMinute = fx.feedMinute;
+  snprintf(dayOut, dayOutSize, "%s", dayName);
+  snprintf(dateOut, dateOutSize, "%04lu-%02lu-%02lu",
+           (unsigned long)(fx.date / 10000UL) % 10000UL,
+           (unsigned long)(fx.date / 100UL) % 100UL,
+           (unsigned long)fx.date % 100UL);
+  return true;
 }
 
-bool localGetDueFeeding(int &amountOut,
-                        int &feed_hour,
-                        int &feed_minute,
-                        char *mealNameOut,
-                        size_t mealNameOutSize) { // check if now is the time to feed, offline version
-  amountOut = 0;
-  feed_hour = 0;
-  feed_minute = 0;
-  if (mealNameOut && mealNameOutSize > 0) mealNameOut[0] = '\0';
+// -------------------- Phase 3: Offline schedule execution --------------------
+// Offline mode uses the same ScheduleManager timeline as online mode. The NVS
+// cache is compiled at boot (localLoadScheduleCache) and replaced by the cloud
+// fetch; offline it is retried here only if nothing was loaded since boot.
+static unsigned long g_lastCacheLoadTryMs = 0;
+static const unsigned long CACHE_LOAD_RETRY_MS = 60UL * 1000UL; // missing/bad cache: retry rarely
 
-  resetLocalDailyFiredIfNeeded();
+// One-time migration from the old JSON file cache
+static bool loadOldJsonCache() {
+  if (!LittleFS.exists(OLD_SCHEDULE_FILE)) return false;
 
-  time_t now = time(nullptr);
-  if (now < 100000) {
-    return false;
+  File f = LittleFS.open(OLD_SCHEDULE_FILE, "r");
+  if (!f) return false;
+  bool ok = scheduleLoadStream(f, "old cache file");
+  f.close();
+
+  if (ok && localStoreScheduleIfChanged()) {
+    LittleFS.remove(OLD_SCHEDULE_FILE);
+    LittleFS.remove(OLD_SCHEDULE_CRC_FILE);
+    Serial.println("[Local] Old JSON schedule cache migrated to NVS");
   }
+  return ok;
+}
 
-  if (!ensureLocalScheduleUpToDate()) {
+static bool ensureScheduleLoaded() {
+  if (scheduleIsLoaded()) return true;
+  if (g_lastCacheLoadTryMs != 0 && (millis() - g_lastCacheLoadTryMs) < CACHE_LOAD_RETRY_MS) {
     return false;
   }
+  g_lastCacheLoadTryMs = millis();
 
-  struct tm tmNow;
-  localtime_r(&now, &tmNow);
-
-  for (int i = 0; i < 6; i++) {
-    if (!g_localSchedule[i].enabled) continue;
-    if (g_localFiredToday[i]) continue;
-
-    if (tmNow.tm_hour == g_localSchedule[i].hour &&
-        tmNow.tm_min  == g_localSchedule[i].minute) {
+  // compiled rules straight from NVS: a copy, no JSON
+  if (readCacheRecord()) {
+    return scheduleLoadRules(g_cacheRec.rules, g_cacheRec.count, "cache");
+  }
 
-      g_localFiredToday[i] = true;
+  if (loadOldJsonCache()) return true;
 
-      amountOut = g_localSchedule[i].amountGrams;
-      feed_hour = g_localSchedule[i].hour;
-      feed_minute = g_localSchedule[i].minute;
+  Serial.println("[Local] No schedule cache found");
+  return false;
+}
 
-      if (mealNameOut && mealNameOutSize > 0) {
-        strncpy(mealNameOut, g_localSchedule[i].mealName, mealNameOutSize - 1);
-        mealNameOut[mealNameOutSize - 1] = '\0';
-      }
+bool localLoadScheduleCache() {
+  return ensureScheduleLoaded();
+}
 
-      return true;
-    }
+bool localGetDueFeeding(int &amountOut,
+                        int &feed_hour,
+                        int &feed_minute,
+                        char *mealNameOut,
+                        size_t mealNameOutSize) { // check if now is the time to feed, offline version
+  if (!ensureScheduleLoaded()) {
+    amountOut = 0;
+    feed_hour = 0;
+    feed_minute = 0;
+    if (mealNameOut && mealNameOutSize > 0) mealNameOut[0] = '\0';
+    return false;
   }
-
-  return false;
+  return scheduleGetDue(time(nullptr), amountOut, feed_hour, feed_minute, mealNameOut, mealNameOutSize);
 }
@@ -5,10 +5,16 @@
 bool initLocalStorage();
 
 // ---------- Schedule cache ----------
-bool localStoreScheduleIfChanged(const char* json);
-bool localLoadSchedule(String &outJson);
+// Stores the currently compiled schedule (ScheduleManager) as one binary
+// NVS record; no flash write if the rules did not change.
+bool localStoreScheduleIfChanged();
 
 // ---------- Offline schedule execution ----------
+// Same ScheduleManager timeline/fired state as online; the binary cache is only
+// loaded if nothing was compiled since boot.
+// Once in setup() (after scheduleInit): compiles the cached rules, so meals
+// that fell due during a reset are caught up online too (before the first fetch)
+bool localLoadScheduleCache();
 bool localGetDueFeeding(int &amountOut,
                         int &feed_hour,
                         int &feed_minute,
@@ -23,23 +29,88 @@ bool localQueueWeightUpdate(int dueAmount,
                             const char* day,
                             const char* dateISO,
                             float prevWeight,
-                            float currentWeight);
-
-// Upload-callback signature (we will pass update_weight here)
-typedef bool (*WeightUploadFn)(int amount_grams,
-                              int feed_hour,
-                              int feed_minute,
-                              const char *meal_name,
-                              const char *day,
-                              const char *date,
-                              float prev_current_weight,
-                              float new_current_weight);
-
-// Flush local queue to Firebase:
-// - uploads line-by-line
-// - if a line fails: keeps that line + remaining lines (no duplicates)
-// - if all succeed: deletes the queue file
-bool localFlushWeightsQueue(WeightUploadFn uploadFn);
+                            float currentWeight,
+                            uint64_t eventId);   // feeding's event ID (record key)
+
+// Records are staged in RTC memory and written to flash in groups (one
+// append per flash page of records). Call localQueueTick() from loop()
+// (commits after a few minutes) and localQueueCommit() before anything that
+// loses RAM on purpose (OTA update, deep sleep, restart).
+bool localQueueCommit();
+void localQueueTick();
+
+// Flash wear of the queue since boot; write amplification =
+// flashPages * 256 / recordBytes
+struct LocalQueueStats {
+  uint32_t records;       // records queued
+  uint32_t recordBytes;   // their frame bytes
+  uint32_t flashBytes;    // bytes appended to segment files (frames + segment headers)
+  uint32_t flashPages;    // flash pages programmed, incl. one metadata commit per append (estimate)
+  uint32_t commits;       // file appends (open/write/close)
+  uint32_t nvsWrites;     // manifest + read cursor writes
+  uint32_t stagedBytes;   // waiting in RTC memory
+};
+
+void localGetQueueStats(LocalQueueStats &out);
+
+// ---------- No-clock feed log ----------
+// Feeds done before the clock was ever valid: logged one by one with the boot
+// ID and millis() offset (survives reboots). Once the clock is valid they are
+// moved to the queue above with reconstructed timestamps (exact for this
+// boot, estimated for earlier ones).
+void localNoClockBegin(uint32_t bootCounter);   // once in setup(), after LittleFS
+bool localLogNoClockFeed(uint64_t eventId,
+                         uint32_t startMs,      // millis() when the feed started
+                         int amountGrams,
+                         float startWeight,
+                         float endWeight,
+                         const char* mealName);
+// Later bowl reading of a logged feed (eating session, next feed): fills in
+// its record's current weight. false = the feed is no longer in the log.
+bool localLogNoClockReading(uint64_t eventId, float bowlWeight);
+void localNoClockTick(bool clockValid);         // every loop() (cheap)
+// Time fields the queued record of a no-clock feed of this boot got
+// (false = not moved to the queue yet)
+bool localNoClockFeedTime(uint32_t startMs,
+                          int &feedHour,
+                          int &feedMinute,
+                          char* dayOut, size_t dayOutSize,
+                          char* dateOut, size_t dateOutSize);
+
+// ---------- Batched flush ----------
+// Max records coalesced into one multi-location write
+#define WEIGHTS_BATCH_MAX 16
+
+// One queued meal record, as read back from a queue segment
+struct WeightQueueRecord {
+  char key[20];          // idempotency key (event key) -> uploaded to /weights/<key>
+  int amountGrams;
+  int feedHour;
+  int feedMinute;
+  char mealName[30];
+  char day[10];
+  char dateISO[11];      // "YYYY-MM-DD"
+  float prevWeight;
+  float currentWeight;
+};
+
+// Batch upload-callback (we will pass update_weights_batch here).
+// Must write all records or none (one multi-location update).
+typedef bool (*WeightBatchUploadFn)(const WeightQueueRecord *records, size_t count);
+
+// Flush local queue to Firebase in batches of up to WEIGHTS_BATCH_MAX records:
+// - staged records (RTC memory) are committed to their day segment first
+// - segments are read oldest first from the NVS read cursor; after every
+//   uploaded batch only the cursor advances (segment files are not rewritten)
+// - a fully uploaded segment is deleted and dropped from the manifest
+// - every record carries its feeding's event key, so re-sending a batch after a
+//   failure overwrites the same nodes instead of creating duplicates
+// - if a batch fails: returns false with the cursor on that batch (retried
+//   from there next time)
+bool localFlushWeightsQueueBatched(WeightBatchUploadFn uploadFn);
 
 // Optional: quick check
 bool localWeightsQueueExists();
+
+// Bytes not uploaded yet, staged ones included (0 = empty), for telemetry
+size_t localWeightsQueueBytes();
@@ -1,5 +1,9 @@
 #include "MotorManager.h"
+#include "LatencyManager.h"
+#include "SpscQueue.h"
+#include <Arduino.h>
 #include <AccelStepper.h>
+#include <atomic>
 #include <math.h>   // fabs()
 
 // ---------- Stepper motor configuration ----------
@@ -15,6 +19,26 @@ const long  CONTINUOUS_TARGET        = -2000000000L;
 volatile bool stop_motor = false;
 bool is_motor_running = false;
 
+// Motion task (motorAttachTask): loop() only posts commands, the task owns
+// the stepper and reports back whether the last command has finished
+enum MotorCmdType : uint8_t {
+  MOTOR_CMD_FORWARD,
+  MOTOR_CMD_BACKWARD,
+  MOTOR_CMD_RELATIVE,
+  MOTOR_CMD_STOP
+};
+
+struct MotorCmd {
+  MotorCmdType type;
+  long steps;         // MOTOR_CMD_RELATIVE only
+};
+
+static SpscQueue<MotorCmd, 8> g_motorCmds;        // loop() -> motion task
+static TaskHandle_t g_motionTask = nullptr;
+static uint32_t g_cmdsPosted = 0;                 // loop() only
+static uint32_t g_cmdsApplied = 0;                // motion task only
+static std::atomic<uint32_t> g_motionState{1};    // (commands applied << 1) | move done
+
 void initMotor() {
   // Conservative settings to reduce stalls
   stepper.setMaxSpeed(450);      
@@ -37,7 +61,7 @@ static void startMotorToTarget(long target) {
 }
 
 // Normal feeding direction (exactly as you had it)
-void startMotor() {
+static void runForward() {
   const long normalTarget =
       (MOTOR_SPEED_STEPS_PER_SEC < 0) ? CONTINUOUS_TARGET : -CONTINUOUS_TARGET;
 
@@ -45,7 +69,7 @@ void startMotor() {
 }
 
 // Reverse direction (opposite of startMotor)
-void startMotorBackward() {
+static void runBackward() {
   const long normalTarget =
       (MOTOR_SPEED_STEPS_PER_SEC < 0) ? CONTINUOUS_TARGET : -CONTINUOUS_TARGET;
 
@@ -53,14 +77,14 @@ void startMotorBackward() {
   startMotorToTarget(reverseTarget);
 }
 
-void stopMotor() { //stops the motor
+static void runStop() {
   stop_motor = true;
   stepper.stop(); // smooth deceleration using acceleration
 }
 
-void updateMotor() { //change motor speed
-  // MUST be called very frequently for smooth stepping
+static void stepOnce() {
   stepper.run();
+  LATENCY_STEP(stepper.distanceToGo() != 0);
 
   if (stop_motor && stepper.distanceToGo() == 0) {
     is_motor_running = false;
@@ -71,7 +95,7 @@ void updateMotor() { //change motor speed
 
 static const long STEPS_PER_REV_EFFECTIVE = 3200;
 
-void startMotorRelativeSteps(long deltaSteps) { //helper for revesing the motor
+static void runRelative(long deltaSteps) {
   stop_motor = false;
   is_motor_running = true;
 
@@ -82,6 +106,69 @@ void startMotorRelativeSteps(long deltaSteps) { //helper for revesing the motor
   stepper.moveTo(deltaSteps);
 }
 
+static void postCmd(MotorCmdType type, long steps) {
+  if (!g_motorCmds.push(MotorCmd{type, steps})) {
+    Serial.println("[Motor] command queue full -> command dropped");
+    return;
+  }
+  g_cmdsPosted++;
+  xTaskNotifyGive(g_motionTask);
+}
+
+void startMotor() {
+  if (g_motionTask) postCmd(MOTOR_CMD_FORWARD, 0);
+  else runForward();
+}
+
+void startMotorBackward() {
+  if (g_motionTask) postCmd(MOTOR_CMD_BACKWARD, 0);
+  else runBackward();
+}
+
+void stopMotor() { //stops the motor
+  if (g_motionTask) postCmd(MOTOR_CMD_STOP, 0);
+  else runStop();
+}
+
+void startMotorRelativeSteps(long deltaSteps) { //helper for revesing the motor
+  if (g_motionTask) postCmd(MOTOR_CMD_RELATIVE, deltaSteps);
+  else runRelative(deltaSteps);
+}
+
+void updateMotor() { //change motor speed
+  // MUST be called very frequently for smooth stepping (the motion task
+  // does it once attached)
+  if (!g_motionTask) stepOnce();
+}
+
 bool motorMoveDone() { //make sure the motor has stopped
-  return stepper.distanceToGo() == 0;
+  if (!g_motionTask) return stepper.distanceToGo() == 0;
+
+  // done = every posted command has been applied and the last move finished
+  const uint32_t state = g_motionState.load(std::memory_order_acquire);
+  return (state & 1U) && (state >> 1) == (g_cmdsPosted & 0x7FFFFFFFUL);
+}
+
+void motorAttachTask(TaskHandle_t motionTask) {
+  g_motionTask = motionTask;
+}
+
+bool motorTaskTick() {
+  MotorCmd cmd;
+  while (g_motorCmds.pop(cmd)) {
+    switch (cmd.type) {
+      case MOTOR_CMD_FORWARD:  runForward(); break;
+      case MOTOR_CMD_BACKWARD: runBackward(); break;
+      case MOTOR_CMD_RELATIVE: runRelative(cmd.steps); break;
+      case MOTOR_CMD_STOP:     runStop(); break;
+    }
+    g_cmdsApplied++;
+  }
+
+  stepOnce();
+
+  const bool done = (stepper.distanceToGo() == 0);
+  g_motionState.store(((g_cmdsApplied & 0x7FFFFFFFUL) << 1) | (done ? 1U : 0U),
+                      std::memory_order_release);
+  return !done;
 }
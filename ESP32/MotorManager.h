@@ -1,6 +1,9 @@
 #ifndef MOTOR_MANAGER_H
 #define MOTOR_MANAGER_H
 
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
 void initMotor();
 void startMotor();
 void stopMotor();
@@ -9,6 +12,15 @@ void startMotorBackward();
 void startMotorRelativeSteps(long deltaSteps);
 bool motorMoveDone();
 
+// Motion task (TaskManager): after motorAttachTask() the start/stop calls
+// above only queue a command for that task and updateMotor() does nothing;
+// motorMoveDone() reports the task's state.
+void motorAttachTask(TaskHandle_t motionTask);
+
+// Motion task only: applies queued commands + one stepper.run().
+// false = motor idle (the task can block until the next command)
+bool motorTaskTick();
+
 
 extern bool is_motor_running;
 
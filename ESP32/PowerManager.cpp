@@ -0,0 +1,187 @@
+#include "PowerManager.h"
+#include <Arduino.h>
+#include <esp_pm.h>
+#include <esp_sleep.h>
+#include <driver/gpio.h>
+#include <hal/gpio_ll.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+static const uint32_t NAP_CONNECTED_MS = 250;   // idle + online: command stream / cloud loop polled this often
+static const uint32_t NAP_OFFLINE_MS   = 1000;  // idle + offline: WiFi retry / NTP tick
+static const uint32_t IDLE_SETTLE_MS   = 2000;  // keep the fast loop this long after the last busy loop
+static const uint32_t STATS_WINDOW_MS  = 24UL * 60UL * 60UL * 1000UL;
+
+// Estimated board current per state (mA) -> measure your unit and adjust
+static const uint32_t POWER_MA_AWAKE       = 100;  // 240 MHz, WiFi on, sensors polled
+static const uint32_t POWER_MA_MOTOR       = 450;  // awake + stepper driver
+static const uint32_t POWER_MA_NAP         = 30;   // 80 MHz idle, WiFi modem sleep
+static const uint32_t POWER_MA_LIGHT_SLEEP = 5;    // auto light sleep between WiFi beacons
+
+static TaskHandle_t g_loopTask = nullptr;
+static gpio_num_t g_buttonPin = GPIO_NUM_NC;
+static volatile bool g_buttonWakeArmed = false;  // pin is a low-level wake source (nap only)
+static volatile uint32_t g_buttonWakes = 0;
+static bool g_lightSleep = false;        // auto light sleep enabled
+#if CONFIG_PM_ENABLE
+static esp_pm_lock_handle_t g_fastLock = nullptr;
+#endif
+static bool g_fast = false;              // holding the full-speed lock
+
+static unsigned long g_lastBusyMs = 0;
+static unsigned long g_awakeSinceMs = 0; // end of the last nap
+
+// Current 24 h window
+static uint64_t g_chargeMaMs = 0;
+static uint32_t g_windowMs = 0;
+static uint32_t g_napMs = 0;
+static uint32_t g_windowButtonWakes = 0;
+
+// Last full window
+static bool g_haveDay = false;
+static uint32_t g_dayAvgMa10 = 0;
+static uint8_t g_daySleepPct = 0;
+
+static void IRAM_ATTR onButtonEdge() {
+  if (g_buttonWakeArmed) {
+    // level interrupt (light-sleep wake) -> back to the falling edge at once,
+    // or it fires again for as long as the button is held
+    g_buttonWakeArmed = false;
+    gpio_ll_wakeup_disable(&GPIO, g_buttonPin);
+    gpio_ll_set_intr_type(&GPIO, g_buttonPin, GPIO_INTR_NEGEDGE);
+  }
+  if (!g_loopTask) return;
+  BaseType_t woken = pdFALSE;
+  vTaskNotifyGiveFromISR(g_loopTask, &woken);
+  if (woken) portYIELD_FROM_ISR();
+}
+
+// Light sleep only wakes on a GPIO level, and the pin has a single interrupt
+// type: it is switched to low level for the nap and back to the edge after
+static void armButtonWake() {
+  if (!g_lightSleep || g_buttonPin == GPIO_NUM_NC) return;
+  if (digitalRead(g_buttonPin) == LOW) return;   // held: the nap just ends on time
+  g_buttonWakeArmed = true;
+  gpio_wakeup_enable(g_buttonPin, GPIO_INTR_LOW_LEVEL);
+}
+
+static void disarmButtonWake() {
+  if (!g_buttonWakeArmed) return;                // never armed, or the ISR already did it
+  g_buttonWakeArmed = false;
+  gpio_wakeup_disable(g_buttonPin);
+  gpio_set_intr_type(g_buttonPin, GPIO_INTR_NEGEDGE);
+}
+
+// Full CPU speed and no light sleep while held (feeding, cloud calls, sensors)
+static void setFast(bool fast) {
+  if (fast == g_fast) return;
+#if CONFIG_PM_ENABLE
+  if (g_fastLock) {
+    if (fast) esp_pm_lock_acquire(g_fastLock);
+    else esp_pm_lock_release(g_fastLock);
+  }
+#endif
+  g_fast = fast;
+}
+
+static void account(uint32_t ms, uint32_t ma) {
+  g_chargeMaMs += (uint64_t)ms * ma;
+  g_windowMs += ms;
+  if (g_windowMs < STATS_WINDOW_MS) return;
+
+  g_dayAvgMa10 = (uint32_t)(g_chargeMaMs * 10ULL / g_windowMs);
+  g_daySleepPct = (uint8_t)((uint64_t)g_napMs * 100ULL / g_windowMs);
+  g_haveDay = true;
+
+  const uint32_t wakes = g_buttonWakes;
+  Serial.printf("[Power] last 24 h: avg %lu.%lu mA, napping %u%%, %lu button wakes\n",
+                (unsigned long)(g_dayAvgMa10 / 10), (unsigned long)(g_dayAvgMa10 % 10),
+                (unsigned)g_daySleepPct, (unsigned long)(wakes - g_windowButtonWakes));
+
+  g_chargeMaMs = 0;
+  g_windowMs = 0;
+  g_napMs = 0;
+  g_windowButtonWakes = wakes;
+}
+
+void powerInit(uint8_t buttonPin) {
+  g_loopTask = xTaskGetCurrentTaskHandle();
+
+  // button wakes a nap (falling edge) and the chip from light sleep (low
+  // level, armed only around naps: see armButtonWake())
+  g_buttonPin = (gpio_num_t)buttonPin;
+  attachInterrupt(digitalPinToInterrupt(buttonPin), onButtonEdge, FALLING);
+  esp_sleep_enable_gpio_wakeup();
+
+#if CONFIG_PM_ENABLE
+  esp_pm_config_esp32_t cfg = {};
+  cfg.max_freq_mhz = 240;
+  cfg.min_freq_mhz = 80;   // lowest speed WiFi keeps working at
+  cfg.light_sleep_enable = true;
+
+  esp_err_t err = esp_pm_configure(&cfg);
+  if (err == ESP_ERR_NOT_SUPPORTED) {
+    // core built without tickless idle -> frequency scaling only
+    cfg.light_sleep_enable = false;
+    err = esp_pm_configure(&cfg);
+  } else {
+    g_lightSleep = (err == ESP_OK);
+  }
+
+  if (err == ESP_OK && esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "feeder", &g_fastLock) == ESP_OK) {
+    Serial.printf("[Power] naps at 80 MHz%s\n", g_lightSleep ? " + auto light sleep" : "");
+  } else {
+    g_fastLock = nullptr;
+    g_lightSleep = false;
+    Serial.printf("[Power] power management unavailable (%s) -> plain naps\n", esp_err_to_name(err));
+  }
+#else
+  Serial.println("[Power] power management not in this core -> plain naps");
+#endif
+
+  setFast(true);
+  g_lastBusyMs = millis();
+  g_awakeSinceMs = millis();
+}
+
+void powerIdle(bool busy, bool motorRunning, bool wifiConnected, uint32_t msToDeadline) {
+  const unsigned long now = millis();
+  account((uint32_t)(now - g_awakeSinceMs), motorRunning ? POWER_MA_MOTOR : POWER_MA_AWAKE);
+  g_awakeSinceMs = now;
+
+  if (busy) g_lastBusyMs = now;
+
+  uint32_t napMs = wifiConnected ? NAP_CONNECTED_MS : NAP_OFFLINE_MS;
+  if (msToDeadline < napMs) napMs = msToDeadline;
+
+  if (busy || (now - g_lastBusyMs) < IDLE_SETTLE_MS || napMs <= 1) {
+    delay(1);
+    return;
+  }
+
+  armButtonWake();
+  setFast(false);
+  const unsigned long napStart = millis();
+  if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(napMs)) > 0) g_buttonWakes++;
+  setFast(true);
+  disarmButtonWake();
+
+  const uint32_t slept = (uint32_t)(millis() - napStart);
+  g_napMs += slept;
+  account(slept, g_lightSleep ? POWER_MA_LIGHT_SLEEP : POWER_MA_NAP);
+  g_awakeSinceMs = millis();
+}
+
+void powerGetStats(PowerStats &out) {
+  out.lightSleep = g_lightSleep;
+  if (g_haveDay) {
+    out.avgCurrentMa10 = g_dayAvgMa10;
+    out.sleepPercent = g_daySleepPct;
+  } else if (g_windowMs > 0) {
+    out.avgCurrentMa10 = (uint32_t)(g_chargeMaMs * 10ULL / g_windowMs);
+    out.sleepPercent = (uint8_t)((uint64_t)g_napMs * 100ULL / g_windowMs);
+  } else {
+    out.avgCurrentMa10 = 0;
+    out.sleepPercent = 0;
+  }
+}
@@ -0,0 +1,37 @@
+#ifndef POWERMANAGER_H
+#define POWERMANAGER_H
+
+#include <stdint.h>
+
+// Power manager: replaces the fixed delay(1) at the end of loop().
+// - busy (feeding, motor, pending writes/acks, portal): 1 ms tick at full
+//   CPU speed, like before
+// - idle: the loop naps until the next wake deadline = min(next schedule
+//   event, command-stream poll, WiFi retry); the feed button wakes it at once
+//   (interrupt). While napping the CPU drops to 80 MHz and, when the core
+//   supports it, auto light sleep runs between WiFi beacons (the connection
+//   and the command stream stay up). Sensor polling follows the loop, so
+//   the distance / weight reads slow down with it.
+// - average current per day is estimated from the time spent in each state
+//   (see the POWER_MA_* figures in PowerManager.cpp) and sent with the
+//   telemetry heartbeat.
+
+#define POWER_NO_DEADLINE 0xFFFFFFFFUL
+
+struct PowerStats {
+  uint32_t avgCurrentMa10;  // last full 24 h (or today so far), 0.1 mA
+  uint8_t sleepPercent;     // share of that time spent napping
+  bool lightSleep;          // auto light sleep available on this core
+};
+
+// Once in setup() (buttonPin = feed button, active LOW)
+void powerInit(uint8_t buttonPin);
+
+// End of every loop(). busy = something needs a fast loop right now;
+// msToDeadline = ms until the next thing that must run on time
+// (POWER_NO_DEADLINE = none).
+void powerIdle(bool busy, bool motorRunning, bool wifiConnected, uint32_t msToDeadline);
+
+void powerGetStats(PowerStats &out);
+
+#endif
@@ -8,5 +8,7 @@ constexpr const char* AP_PASS = "";
 #define DATABASE_URL    "" 
 #define USER_EMAIL      ""
 #define USER_PASS       ""
+// Root CA (PEM) of the Firebase servers, used to pin TLS. Empty = not verified.
+#define FIREBASE_ROOT_CA ""
 // the password to passwords file is the same as the  wifi password in the lab
 #endif
@@ -1,6 +1,8 @@
 #include <HX711.h>
 #include <algorithm>
+#include <atomic>
 #include "ScaleManager.h"
+#include "SpscQueue.h"
 
 
 // ---------- HX711 load cell configuration ----------
@@ -22,6 +24,28 @@ unsigned long lastWeightReadMillis = 0;
 unsigned long now = 0;
 const unsigned long WEIGHT_READ_INTERVAL_MS = 100;  // How often to refresh weight (ms)
 
+// Sensor task (scaleAttachTask): the HX711 is read there and the filtered
+// weight handed to loop() through a queue; tare requests go the other way
+static const uint32_t HX711_CONVERSION_MAX_MS = 200;   // no conversion this long -> reading skipped
+static const uint32_t TARE_WAIT_MAX_MS        = 5000;  // scaleTarePoll() reports the tare failed
+#define TARE_SAMPLES 20                                 // conversions averaged into the new offset
+
+struct WeightSample {
+  float grams;
+  uint16_t tareGen;   // tare the reading was taken after
+};
+
+static SpscQueue<WeightSample, 16> g_weightSamples;   // sensor task -> loop()
+static TaskHandle_t g_sensorTask = nullptr;
+static std::atomic<uint16_t> g_tareGen{0};            // bumped by loop() per tare request
+static std::atomic<uint16_t> g_tareDoneGen{0};        // set by the sensor task once tared
+static bool g_tareSampleSeen = false;                 // loop(): a reading taken after the last tare arrived
+static bool g_tareWaiting = false;                    // loop(): tare requested, no post-tare reading yet
+static bool g_tareFailed = false;                     // loop(): gave up waiting (until the next request)
+static unsigned long g_tareRequestMs = 0;
+static bool g_filterSeeded = false;                   // sensor task: first reading after a tare taken as is
+static float g_taskWeightGrams = 0.0f;                // filter state (sensor task only)
+
 
 // ---------- Initialize load cell (HX711) ----------
 void initScale() {
@@ -49,6 +73,18 @@ void updateWeight() {// measure weight on the plate
     return;
   }
 
+  if (g_sensorTask) {
+    // newest reading from the sensor task (taken before the last tare -> dropped)
+    const uint16_t gen = g_tareGen.load(std::memory_order_relaxed);
+    WeightSample sample;
+    while (g_weightSamples.pop(sample)) {
+      if (sample.tareGen != gen) continue;
+      currentWeightGrams = sample.grams;
+      g_tareSampleSeen = true;
+    }
+    return;
+  }
+
   now = millis();
   if (now - lastWeightReadMillis < WEIGHT_READ_INTERVAL_MS) return;
   lastWeightReadMillis = now;
@@ -84,8 +120,106 @@ float getWeight2() { //depracated function
 
 void reZeroScale() { //reset the scales to minimize weight error
   if (!scaleReady) return;
+
+  if (g_sensorTask) {
+    // the sensor task owns the HX711 -> ask it; loop() polls scaleTarePoll()
+    const uint16_t gen = (uint16_t)(g_tareGen.load(std::memory_order_relaxed) + 1);
+    g_tareGen.store(gen, std::memory_order_release);
+    xTaskNotifyGive(g_sensorTask);
+    g_tareWaiting = true;
+    g_tareFailed = false;
+    g_tareSampleSeen = false;
+    g_tareRequestMs = millis();
+    currentWeightGrams = 0.0f;  // readings from before the tare are dropped
+    return;
+  }
+
   if (!scale.is_ready()) return;
 
   scale.tare(20);          // set new offset at current load
   currentWeightGrams = 0.0f;    
 }
+
+ScaleTareState scaleTarePoll() {
+  if (g_tareFailed) return SCALE_TARE_FAILED;
+  if (!g_tareWaiting) return SCALE_TARE_DONE;
+
+  // done = the task tared and sent its first reading after it (the weight
+  // to start from, not the zeroed filter)
+  updateWeight();
+  if (g_tareSampleSeen) {
+    g_tareWaiting = false;
+    return SCALE_TARE_DONE;
+  }
+  if (millis() - g_tareRequestMs > TARE_WAIT_MAX_MS) {
+    // the request stays with the task: readings come back once it has tared
+    Serial.println("[Scale] tare not confirmed by the sensor task");
+    g_tareWaiting = false;
+    g_tareFailed = true;
+    return SCALE_TARE_FAILED;
+  }
+  return SCALE_TARE_PENDING;
+}
+
+void scaleTareCancel() {
+  g_tareWaiting = false;
+  g_tareFailed = false;
+}
+
+void scaleAttachTask(TaskHandle_t sensorTask) {
+  g_sensorTask = sensorTask;
+}
+
+// Next HX711 conversion; sleeps instead of spinning in the library's wait
+// (the sensor task shares core 0 with WiFi). false = none in time.
+static bool waitConversion() {
+  const unsigned long startMs = millis();
+  while (!scale.is_ready()) {
+    if (millis() - startMs > HX711_CONVERSION_MAX_MS) return false;
+    vTaskDelay(1);
+  }
+  return true;
+}
+
+// Average of 5 conversions
+static bool readAverage(float &out) {
+  float sum = 0.0f;
+  for (int i = 0; i < 5; i++) {
+    if (!waitConversion()) return false;
+    sum += scale.get_units(1);
+  }
+  out = sum / 5.0f;
+  return true;
+}
+
+// scale.tare() with the same bounded waits; false = offset left unchanged
+static bool tareAverage() {
+  int64_t sum = 0;
+  for (int i = 0; i < TARE_SAMPLES; i++) {
+    if (!waitConversion()) return false;
+    sum += scale.read();
+  }
+  scale.set_offset((long)(sum / TARE_SAMPLES));
+  return true;
+}
+
+void scaleTaskTick() {
+  if (!scaleReady) return;
+
+  const uint16_t gen = g_tareGen.load(std::memory_order_acquire);
+  if (gen != g_tareDoneGen.load(std::memory_order_relaxed)) {
+    // confirmed only after a real tare; HX711 not answering -> retried next tick
+    if (!tareAverage()) return;
+    g_filterSeeded = false;
+    g_tareDoneGen.store(gen, std::memory_order_release);
+  }
+
+  float raw;
+  if (!readAverage(raw)) return;
+  g_taskWeightGrams = g_filterSeeded ? 0.7f * g_taskWeightGrams + 0.3f * raw : raw;
+  g_filterSeeded = true;
+
+  // full = loop() stalled for 16 readings -> this one is dropped, the next
+  // updateWeight() empties the queue
+  (void)g_weightSamples.push(WeightSample{g_taskWeightGrams, gen});
+}
@@ -1,8 +1,32 @@
 #ifndef SCALEMANAGER_H
 #define SCALEMANAGER_H
 
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
 void initScale();
 float getWeight();
 void updateWeight();
 void reZeroScale();
+
+enum ScaleTareState {
+  SCALE_TARE_DONE,      // tared and getWeight() holds a reading taken after it (or none asked)
+  SCALE_TARE_PENDING,
+  SCALE_TARE_FAILED     // not confirmed within TARE_WAIT_MAX_MS (until the next reZeroScale())
+};
+
+// Tare asked of the sensor task (poll from loop()); DONE at once without the task
+ScaleTareState scaleTarePoll();
+
+// loop() stops waiting for the tare (the task still does it; a tare just
+// zeroes the scale at the current load)
+void scaleTareCancel();
+
+// Sensor task (TaskManager): after scaleAttachTask() the HX711 is only read
+// by that task; updateWeight() takes its newest reading and reZeroScale()
+// only asks the task to tare (the weight reads 0 until the next reading).
+void scaleAttachTask(TaskHandle_t sensorTask);
+
+// Sensor task only: pending tare + one filtered reading for loop()
+void scaleTaskTick();
 #endif
\ No newline at end of file
@@ -0,0 +1,451 @@
+#include "ScheduleManager.h"
+#include "JsonPool.h"
+#include <Arduino.h>
+#include <Preferences.h>
+#include <ctype.h>
+#include <string.h>
+
+// ---------------- Rules ----------------
+static ScheduleRule g_rules[SCHEDULE_MAX_RULES];
+static size_t g_ruleCount = 0;
+static bool g_loaded = false;            // compiled from some source since boot
+static time_t g_ruleSince[SCHEDULE_MAX_RULES]; // rule added/edited at runtime: no catch-up before this
+
+// ---------------- Timeline (yesterday's tail + today) ----------------
+// Entries are deadlines (epoch of the local feeding time). An entry fires on
+// the first tick at/after its deadline, as long as that is within the
+// catch-up window, so a loop stall (portal, NTP, slow cloud call) or a reset
+// delays a meal instead of skipping it.
+static const uint32_t SCHEDULE_CATCHUP_SEC = 15UL * 60UL;
+
+struct TimelineEntry {
+  time_t due;
+  uint8_t rule;
+  bool done;     // fired (now or before a reset/rebuild) or missed
+};
+
+static TimelineEntry g_timeline[SCHEDULE_TIMELINE_MAX];
+static size_t g_timelineCount = 0;
+static size_t g_cursor = 0;              // first entry that may still fire
+static int g_timelineYDay = -1;          // day the timeline was built for
+static bool g_timelineDirty = true;      // rules changed -> rebuild on the next tick
+static time_t g_nextMidnight = 0;
+
+// Fast path: nothing can be due before this epoch (next deadline / midnight)
+static time_t g_nextCheck = 0;
+static time_t g_lastNow = 0;
+
+// ---------------- Fired state (NVS) ----------------
+// Ring of the last fired (rule sig, deadline) keys. Written to NVS on every
+// fire (a few writes a day), so after a reset a meal is neither repeated
+// nor lost, and a schedule edit only re-arms the meals that changed.
+#define SCHEDULE_FIRED_RING 32
+static const uint32_t FIRED_STORE_MAGIC = 0x53464931; // "SFI1"
+
+struct FiredStore {
+  uint32_t magic;
+  uint32_t next;
+  uint32_t keys[SCHEDULE_FIRED_RING];
+};
+
+static FiredStore g_fired;
+static Preferences g_schedPrefs;
+
+// Static JSON pools (no heap, no silent truncation)
+static JsonStaticPool<3072> g_schedulePool;
+static JsonStaticPool<384>  g_scheduleFilterPool;
+
+static uint32_t fnv1a32Mix(uint32_t h, uint32_t v) {
+  h ^= v;
+  h *= 16777619u;
+  return h;
+}
+
+static uint32_t computeRuleSig(const ScheduleRule &r) {
+  uint32_t h = 2166136261u;
+  h = fnv1a32Mix(h, r.hour);
+  h = fnv1a32Mix(h, r.minute);
+  h = fnv1a32Mix(h, r.weekdays);
+  h = fnv1a32Mix(h, r.everyHours);
+  h = fnv1a32Mix(h, (uint32_t)r.amountGrams);
+  for (const char *s = r.mealName; *s; s++) h = fnv1a32Mix(h, (uint8_t)*s);
+  return h;
+}
+
+static uint32_t firedKey(const ScheduleRule &r, time_t due) {
+  return fnv1a32Mix(r.sig, (uint32_t)(due / 60));
+}
+
+static bool isFired(uint32_t key) {
+  for (int i = 0; i < SCHEDULE_FIRED_RING; i++) {
+    if (g_fired.keys[i] == key) return true;
+  }
+  return false;
+}
+
+static void markFired(uint32_t key) {
+  if (isFired(key)) return;
+  g_fired.keys[g_fired.next % SCHEDULE_FIRED_RING] = key;
+  g_fired.next = (g_fired.next + 1) % SCHEDULE_FIRED_RING;
+
+  if (g_schedPrefs.putBytes("fired", &g_fired, sizeof(g_fired)) != sizeof(g_fired)) {
+    Serial.println("[Schedule] could not persist fired state");
+  }
+}
+
+// Parse time string (ISO or HH:MM[:SS])
+static bool parseHourMinute(const char *s, int &hourOut, int &minuteOut) {
+  if (!s || !*s) return false;
+
+  const char *t = strchr(s, 'T');
+  const char *p = (t) ? (t + 1) : s;
+
+  if (!(p[0] && p[1] && p[2] == ':' && p[3] && p[4])) return false;
+
+  hourOut = (p[0] - '0') * 10 + (p[1] - '0');
+  minuteOut = (p[3] - '0') * 10 + (p[4] - '0');
+
+  if (hourOut < 0 || hourOut > 23 || minuteOut < 0 || minuteOut > 59) return false;
+  return true;
+}
+
+// "days": mask (int) or array of weekday numbers; missing = every day
+static uint8_t parseWeekdays(JsonVariant v) {
+  if (v.isNull()) return SCHEDULE_ALL_DAYS;
+  if (v.is<JsonArray>()) {
+    uint8_t mask = 0;
+    for (JsonVariant d : v.as<JsonArray>()) {
+      int day = d | -1;
+      if (day >= 0 && day <= 6) mask |= (uint8_t)(1u << day);
+    }
+    return mask;
+  }
+  int mask = v | SCHEDULE_ALL_DAYS;
+  return (uint8_t)(mask & SCHEDULE_ALL_DAYS);
+}
+
+// Keep only the fields we use from every feeding (object or array root)
+static void buildScheduleFilter(JsonDocument &filter, bool arrayRoot) {
+  JsonObject f = arrayRoot ? filter[0].to<JsonObject>() : filter["*"].to<JsonObject>();
+  f["hour"] = true;
+  f["amount_grams"] = true;
+  f["meal_name"] = true;
+  f["days"] = true;
+  f["every_hours"] = true;
+}
+
+static bool jsonLooksLikeArray(const char *s) {
+  while (s && (*s == ' ' || *s == '\n' || *s == '\r' || *s == '\t')) s++;
+  return s && *s == '[';
+}
+
+static bool parseRule(JsonObject feeding, ScheduleRule &out) {
+  const char *hourStr = feeding["hour"] | "";
+  int grams           = feeding["amount_grams"] | 0;
+  const char *mealStr = feeding["meal_name"] | "";
+  int every           = feeding["every_hours"] | 0;
+
+  int hh = 0, mm = 0;
+  if (!parseHourMinute(hourStr, hh, mm)) return false;
+  if (grams <= 0) return false;
+  if (every < 0 || every > 23) every = 0;
+
+  memset(&out, 0, sizeof(out)); // padding too: rules are stored/CRC'd as raw bytes
+  out.hour = (uint8_t)hh;
+  out.minute = (uint8_t)mm;
+  out.weekdays = parseWeekdays(feeding["days"]);
+  out.everyHours = (uint8_t)every;
+  out.amountGrams = grams;
+  strncpy(out.mealName, mealStr, sizeof(out.mealName) - 1);
+  out.mealName[sizeof(out.mealName) - 1] = '\0';
+  out.sig = computeRuleSig(out);
+  return out.weekdays != 0;
+}
+
+// ---------------- Timeline ----------------
+// Local wall time (day of dayTm, hh:mm) as epoch; mktime handles DST
+static time_t localEpoch(const struct tm &dayTm, int minuteOfDay) {
+  struct tm t = dayTm;
+  t.tm_hour = minuteOfDay / 60;
+  t.tm_min = minuteOfDay % 60;
+  t.tm_sec = 0;
+  t.tm_isdst = -1;
+  return mktime(&t);
+}
+
+// Adds the day's feedings with a deadline >= minDue, keeping the table sorted
+// (deadlines already past the window, or before a runtime schedule edit, are
+// closed silently: a changed meal must not re-fire for a time already gone)
+static void addDayToTimeline(const struct tm &dayTm, time_t minDue, time_t now) {
+  const uint8_t dayBit = (uint8_t)(1u << dayTm.tm_wday);
+  for (size_t r = 0; r < g_ruleCount; r++) {
+    const ScheduleRule &rule = g_rules[r];
+    if (!(rule.weekdays & dayBit)) continue;
+
+    const int step = rule.everyHours ? rule.everyHours * 60 : 24 * 60;
+    for (int m = rule.hour * 60 + rule.minute; m < 24 * 60; m += step) {
+      const time_t due = localEpoch(dayTm, m);
+      if (due < minDue) continue;
+
+      if (g_timelineCount >= SCHEDULE_TIMELINE_MAX) {
+        Serial.println("[Schedule] timeline full -> later events dropped");
+        return;
+      }
+
+      // insertion sort (small table, rebuilt rarely)
+      size_t i = g_timelineCount++;
+      while (i > 0 && g_timeline[i - 1].due > due) {
+        g_timeline[i] = g_timeline[i - 1];
+        i--;
+      }
+      g_timeline[i].due = due;
+      g_timeline[i].rule = (uint8_t)r;
+      g_timeline[i].done = isFired(firedKey(rule, due)) ||
+                           due + (time_t)SCHEDULE_CATCHUP_SEC < now ||
+                           due < g_ruleSince[r];
+    }
+  }
+}
+
+static void rebuildTimeline(time_t now, const struct tm &tmNow) {
+  g_timelineYDay = tmNow.tm_yday;
+  g_timelineDirty = false;
+  g_timelineCount = 0;
+  g_cursor = 0;
+
+  const time_t midnight = localEpoch(tmNow, 0);
+
+  // yesterday's last feedings can still be inside the catch-up window
+  struct tm yesterday = tmNow;
+  yesterday.tm_mday -= 1;
+  yesterday.tm_hour = 12;
+  yesterday.tm_isdst = -1;
+  mktime(&yesterday); // normalizes date + weekday
+  addDayToTimeline(yesterday, midnight - (time_t)SCHEDULE_CATCHUP_SEC, now);
+
+  addDayToTimeline(tmNow, midnight, now);
+
+  struct tm tomorrow = tmNow;
+  tomorrow.tm_mday += 1;
+  g_nextMidnight = localEpoch(tomorrow, 0);
+}
+
+// Rebuilds the timeline when the day or the rules changed; false = no valid clock
+static bool syncTimeline(time_t now) {
+  if (now < 100000) return false;
+
+  struct tm tmNow;
+  localtime_r(&now, &tmNow);
+  if (g_timelineDirty || tmNow.tm_yday != g_timelineYDay) rebuildTimeline(now, tmNow);
+  return true;
+}
+
+// ---------------- Public API ----------------
+void scheduleClear() {
+  g_ruleCount = 0;
+  g_loaded = false;
+  g_timelineCount = 0;
+  g_cursor = 0;
+  g_timelineDirty = true;
+  g_nextCheck = 0;
+}
+
+size_t scheduleRuleCount() {
+  return g_ruleCount;
+}
+
+// The first rule set since boot (cache or cloud) keeps its catch-up; after
+// that only the rules that are new or changed start at the time of the edit.
+static void installRules(const ScheduleRule *rules, size_t count, const char *source) {
+  time_t since[SCHEDULE_MAX_RULES];
+  const time_t now = time(nullptr);
+  for (size_t i = 0; i < count; i++) {
+    since[i] = g_loaded ? now : 0;
+    for (size_t j = 0; g_loaded && j < g_ruleCount; j++) {
+      if (g_rules[j].sig == rules[i].sig) { since[i] = g_ruleSince[j]; break; }
+    }
+  }
+
+  memcpy(g_rules, rules, count * sizeof(ScheduleRule));
+  memcpy(g_ruleSince, since, count * sizeof(time_t));
+  g_ruleCount = count;
+  g_loaded = true;
+  g_timelineDirty = true; // rebuilt on the next tick; fired keys are kept
+  g_nextCheck = 0;
+
+  Serial.printf(" Schedule compiled from %s:\n", source);
+  schedulePrint();
+}
+
+// Rules from a parsed /feedings document; false = wrong shape (schedule kept)
+static bool applyScheduleDoc(JsonDocument &doc, const char *source) {
+  static ScheduleRule parsed[SCHEDULE_MAX_RULES];
+  size_t count = 0;
+
+  auto addOne = [&](JsonObject feeding) {
+    if (feeding.isNull()) return;
+    if (count >= SCHEDULE_MAX_RULES) {
+      Serial.println("[Schedule] too many meals -> extra ones ignored");
+      return;
+    }
+    if (parseRule(feeding, parsed[count])) count++;
+  };
+
+  if (doc.is<JsonObject>()) {
+    for (JsonPair kv : doc.as<JsonObject>()) addOne(kv.value().as<JsonObject>());
+  } else if (doc.is<JsonArray>()) {
+    for (JsonVariant v : doc.as<JsonArray>()) addOne(v.as<JsonObject>());
+  } else {
+    Serial.printf("[Schedule] format error (%s): expected JSON object or array\n", source);
+    return false;
+  }
+
+  installRules(parsed, count, source);
+  return true;
+}
+
+static bool reportParseError(DeserializationError err, const char *source) {
+  // NoMemory = schedule bigger than the pool -> keep the previous schedule
+  Serial.printf("[Schedule] deserializeJson failed (%s): %s\n", source, err.c_str());
+  return false;
+}
+
+bool scheduleLoadJson(const char *json, const char *source) {
+  if (!json) return false;
+
+  g_scheduleFilterPool.reset();
+  JsonDocument filter(&g_scheduleFilterPool);
+  buildScheduleFilter(filter, jsonLooksLikeArray(json));
+
+  g_schedulePool.reset();
+  JsonDocument doc(&g_schedulePool);
+  DeserializationError err = deserializeJson(doc, json, DeserializationOption::Filter(filter));
+  if (err) return reportParseError(err, source);
+  return applyScheduleDoc(doc, source);
+}
+
+bool scheduleLoadStream(Stream &in, const char *source) {
+  // peek the root type (object or array) to pick the filter
+  while (in.available() && isspace(in.peek())) in.read();
+  const bool arrayRoot = (in.peek() == '[');
+
+  g_scheduleFilterPool.reset();
+  JsonDocument filter(&g_scheduleFilterPool);
+  buildScheduleFilter(filter, arrayRoot);
+
+  g_schedulePool.reset();
+  JsonDocument doc(&g_schedulePool);
+  DeserializationError err = deserializeJson(doc, in, DeserializationOption::Filter(filter));
+  if (err) return reportParseError(err, source);
+  return applyScheduleDoc(doc, source);
+}
+
+bool scheduleLoadRules(const ScheduleRule *rules, size_t count, const char *source) {
+  if (!rules || count > SCHEDULE_MAX_RULES) return false;
+  installRules(rules, count, source);
+  return true;
+}
+
+const ScheduleRule *scheduleRules() {
+  return g_rules;
+}
+
+bool scheduleIsLoaded() {
+  return g_loaded;
+}
+
+void scheduleInit() {
+  g_schedPrefs.begin("sched", false);
+  memset(&g_fired, 0, sizeof(g_fired));
+  if (g_schedPrefs.getBytes("fired", &g_fired, sizeof(g_fired)) != sizeof(g_fired) ||
+      g_fired.magic != FIRED_STORE_MAGIC) {
+    memset(&g_fired, 0, sizeof(g_fired)); // first boot / old layout
+    g_fired.magic = FIRED_STORE_MAGIC;
+  }
+  g_timelineDirty = true;
+}
+
+bool scheduleGetDue(time_t now, int &amountOut, int &hourOut, int &minuteOut,
+                    char *mealNameOut, size_t mealNameOutSize) {
+  amountOut = 0;
+  hourOut = 0;
+  minuteOut = 0;
+  if (mealNameOut && mealNameOutSize > 0) mealNameOut[0] = '\0';
+
+  // one comparison per tick until the next deadline (clock stepping back -> full check)
+  if (!g_timelineDirty && now >= g_lastNow && now < g_nextCheck) {
+    g_lastNow = now;
+    return false;
+  }
+  if (now < g_lastNow) g_cursor = 0; // clock stepped back (NTP): done flags still hold
+  g_lastNow = now;
+
+  if (!syncTimeline(now)) return false;
+
+  while (g_cursor < g_timelineCount) {
+    TimelineEntry &e = g_timeline[g_cursor];
+    if (e.done) { g_cursor++; continue; }
+    if (e.due > now) break;
+
+    const ScheduleRule &rule = g_rules[e.rule];
+    const uint32_t key = firedKey(rule, e.due);
+    e.done = true;
+    g_cursor++;
+
+    if (isFired(key)) continue; // fired before a reset / rebuild
+
+    struct tm tmDue;
+    localtime_r(&e.due, &tmDue);
+
+    const uint32_t lateSec = (uint32_t)(now - e.due);
+    if (lateSec > SCHEDULE_CATCHUP_SEC) {
+      Serial.printf("[Schedule] missed %s %02d:%02d (%lu s late, window %lu s)\n",
+                    rule.mealName, tmDue.tm_hour, tmDue.tm_min,
+                    (unsigned long)lateSec, (unsigned long)SCHEDULE_CATCHUP_SEC);
+      continue;
+    }
+    if (lateSec >= 60) {
+      Serial.printf("[Schedule] catching up %s %02d:%02d (%lu s late)\n",
+                    rule.mealName, tmDue.tm_hour, tmDue.tm_min, (unsigned long)lateSec);
+    }
+
+    markFired(key);
+    g_nextCheck = now; // another meal may share this deadline
+
+    amountOut = rule.amountGrams;
+    hourOut = tmDue.tm_hour;
+    minuteOut = tmDue.tm_min;
+    if (mealNameOut && mealNameOutSize > 0) {
+      strncpy(mealNameOut, rule.mealName, mealNameOutSize - 1);
+      mealNameOut[mealNameOutSize - 1] = '\0';
+    }
+    return true;
+  }
+
+  g_nextCheck = (g_cursor < g_timelineCount) ? g_timeline[g_cursor].due : g_nextMidnight;
+  return false;
+}
+
+time_t scheduleNextEventTime(time_t now) {
+  if (!syncTimeline(now)) return 0;
+
+  for (size_t i = g_cursor; i < g_timelineCount; i++) {
+    const TimelineEntry &e = g_timeline[i];
+    if (e.done) continue;
+    if (e.due > now) return e.due;
+    if ((uint32_t)(now - e.due) <= SCHEDULE_CATCHUP_SEC) return now; // overdue, still catchable
+  }
+  return g_nextMidnight;
+}
+
+void schedulePrint() {
+  Serial.printf(" Schedule: %u meal(s)\n", (unsigned)g_ruleCount);
+  for (size_t i = 0; i < g_ruleCount; i++) {
+    const ScheduleRule &r = g_rules[i];
+    Serial.printf("#%u: %02d:%02d grams=%d days=0x%02x", (unsigned)i, r.hour, r.minute,
+                  r.amountGrams, r.weekdays);
+    if (r.everyHours) Serial.printf(" every=%dh", r.everyHours);
+    if (r.mealName[0]) Serial.printf(" meal=%s", r.mealName);
+    Serial.println();
+  }
+}
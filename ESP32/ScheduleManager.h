@@ -0,0 +1,76 @@
+#ifndef SCHEDULEMANAGER_H
+#define SCHEDULEMANAGER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+class Stream;
+
+// Schedule engine (shared by online and offline mode): the /feedings rules
+// are compiled into a sorted timeline of feeding deadlines (today, plus the
+// end of yesterday) with a cursor on the next one, so the loop compares one
+// value per tick instead of scanning every meal.
+// - any number of meals (up to SCHEDULE_MAX_RULES)
+// - weekday masks: "days" = bitmask (bit 0 = Sunday) or array of 0..6
+// - recurrences: "every_hours" = N -> hour, hour+N, ... until midnight
+// A deadline fires on the first tick at/after it, up to 15 min late (loop
+// stall, reset, reconnect); later than that it is logged as missed.
+// Fired deadlines are kept in NVS, so a reset or a rebuild (midnight, rules
+// changed) never fires the same meal twice.
+// Rules are compiled once from whichever source has them (cloud fetch or the
+// binary NVS cache at boot); going offline keeps using the same table and the
+// same fired state, so it costs no re-parse and cannot double-fire a meal.
+
+#define SCHEDULE_MAX_RULES 24
+#define SCHEDULE_TIMELINE_MAX 96     // feeding events per day (all rules)
+#define SCHEDULE_ALL_DAYS 0x7F
+
+struct ScheduleRule {
+  uint8_t hour;
+  uint8_t minute;
+  uint8_t weekdays;      // bit 0 = Sunday ... bit 6 = Saturday
+  uint8_t everyHours;    // 0 = once a day
+  int amountGrams;
+  char mealName[30];
+  uint32_t sig;          // hash of all fields (fired state survives unchanged rules)
+};
+
+// Once at boot, before the first scheduleGetDue() (loads the fired state)
+void scheduleInit();
+
+// Replace the rules with a /feedings JSON body (object or array root).
+// false = could not be parsed -> the previous schedule stays active.
+// source = short label for the log ("RTDB", "cache").
+bool scheduleLoadJson(const char *json, const char *source);
+bool scheduleLoadStream(Stream &in, const char *source);
+
+// Already-compiled rules (binary cache): a copy, no parsing
+bool scheduleLoadRules(const ScheduleRule *rules, size_t count, const char *source);
+
+// Current rules (scheduleRuleCount() of them), e.g. to store them
+const ScheduleRule *scheduleRules();
+
+// Rules were compiled from some source since boot
+bool scheduleIsLoaded();
+
+void scheduleClear();
+size_t scheduleRuleCount();
+
+// Feeding due at `now` (epoch, local time)? Fires each deadline once;
+// hourOut/minuteOut = the scheduled time (not `now`) when catching up.
+bool scheduleGetDue(time_t now,
+                    int &amountOut,
+                    int &hourOut,
+                    int &minuteOut,
+                    char *mealNameOut,
+                    size_t mealNameOutSize);
+
+// Epoch of the next feeding event today (`now` if one is overdue but still
+// inside the catch-up window), else the next local midnight (when the
+// timeline is rebuilt). 0 = no valid clock.
+time_t scheduleNextEventTime(time_t now);
+
+void schedulePrint();
+
+#endif
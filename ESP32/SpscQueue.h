@@ -0,0 +1,45 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+// Fixed-size lock-free queue between exactly one producer task and one
+// consumer task (no mutex, no allocation, usable with the scheduler running
+// on both cores). N must be a power of two; N - 1 slots are usable.
+// - push(): producer only; false when full (the value is dropped)
+// - pop():  consumer only; false when empty
+template <typename T, size_t N>
+class SpscQueue {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscQueue size must be a power of two");
+
+ public:
+  bool push(const T &value) {
+    const uint32_t head = head_.load(std::memory_order_relaxed);
+    const uint32_t next = (head + 1) & (N - 1);
+    if (next == tail_.load(std::memory_order_acquire)) return false;
+    buf_[head] = value;
+    head_.store(next, std::memory_order_release);   // publishes the slot
+    return true;
+  }
+
+  bool pop(T &out) {
+    const uint32_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_.load(std::memory_order_acquire)) return false;
+    out = buf_[tail];
+    tail_.store((tail + 1) & (N - 1), std::memory_order_release); // frees the slot
+    return true;
+  }
+
+  bool empty() const {
+    return tail_.load(std::memory_order_acquire) == head_.load(std::memory_order_acquire);
+  }
+
+ private:
+  T buf_[N];
+  std::atomic<uint32_t> head_{0};   // next slot to write (producer)
+  std::atomic<uint32_t> tail_{0};   // next slot to read (consumer)
+};
+
+#endif
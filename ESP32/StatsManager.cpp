@@ -0,0 +1,292 @@
+#include "StatsManager.h"
+#include <Arduino.h>
+#include <Preferences.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char* STATS_NVS_NAMESPACE = "stats";
+static const uint32_t STATS_MAGIC = 0x53544432;                // "STD2" (30-char meal keys)
+static const uint32_t PUBLISH_MIN_INTERVAL_MS = 30UL * 1000UL; // between two summary writes
+
+#define STATS_PAYLOAD_MAX 768
+#define STATS_MEAL_NAME_MAX 30   // = mealName[30] everywhere: keys are never truncated
+
+struct MealRollup {
+  char name[STATS_MEAL_NAME_MAX];   // RTDB-safe key
+  int32_t dispensed10;              // 0.1 g
+  int32_t eaten10;                  // 0.1 g
+  uint16_t feeds;
+  uint16_t failures;
+};
+
+// One ring slot = one NVS blob ("d0".."d7"), rewritten only when its day changes
+struct DayRollup {
+  uint32_t magic;
+  uint32_t date;                    // YYYYMMDD, 0 = free slot
+  int32_t dispensed10;
+  int32_t eaten10;
+  uint16_t feeds;
+  uint16_t failures;
+  uint32_t ttSumMs;                 // time-to-target of the successful feeds
+  uint16_t ttCount;
+  uint8_t mealCount;
+  uint8_t reserved;
+  MealRollup meals[STATS_MEALS_MAX];
+};
+
+static DayRollup g_days[STATS_DAYS];
+static bool g_dayDirty[STATS_DAYS];    // /stats/daily/<date> not written yet (RAM: all re-sent after a boot)
+static bool g_weekDirty = false;
+static uint32_t g_evicted[STATS_DAYS]; // days that left the ring -> removed from /stats/daily
+static bool g_ready = false;
+
+static Preferences g_statsPrefs;
+static unsigned long g_lastPublishMs = 0;
+static bool g_publishedOnce = false;
+static char g_payload[STATS_PAYLOAD_MAX];
+
+static void slotKey(int i, char* out, size_t outSize) {
+  snprintf(out, outSize, "d%d", i);
+}
+
+static void saveSlot(int i) {
+  if (!g_ready) return;
+  char key[4];
+  slotKey(i, key, sizeof(key));
+  if (g_statsPrefs.putBytes(key, &g_days[i], sizeof(DayRollup)) != sizeof(DayRollup)) {
+    Serial.println("[Stats] Failed to save rollup");
+  }
+}
+
+void statsInit() {
+  memset(g_days, 0, sizeof(g_days));
+  memset(g_evicted, 0, sizeof(g_evicted));
+  g_ready = g_statsPrefs.begin(STATS_NVS_NAMESPACE, false);
+  if (!g_ready) {
+    Serial.println("[Stats] NVS open failed -> rollups kept in RAM only");
+    return;
+  }
+
+  int loaded = 0;
+  for (int i = 0; i < STATS_DAYS; i++) {
+    char key[4];
+    slotKey(i, key, sizeof(key));
+    if (g_statsPrefs.getBytes(key, &g_days[i], sizeof(DayRollup)) != sizeof(DayRollup) ||
+        g_days[i].magic != STATS_MAGIC || g_days[i].mealCount > STATS_MEALS_MAX) {
+      memset(&g_days[i], 0, sizeof(DayRollup)); // missing / other layout -> free slot
+      continue;
+    }
+    g_dayDirty[i] = (g_days[i].date != 0);
+    if (g_days[i].date) loaded++;
+  }
+  g_weekDirty = (loaded > 0);
+  Serial.printf("[Stats] %d day rollups loaded\n", loaded);
+}
+
+static uint32_t parseDate(const char* dateISO) {
+  unsigned y = 0, m = 0, d = 0;
+  if (!dateISO || sscanf(dateISO, "%4u-%2u-%2u", &y, &m, &d) != 3) return 0;
+  if (y < 2000 || m < 1 || m > 12 || d < 1 || d > 31) return 0;
+  return (uint32_t)(y * 10000U + m * 100U + d);
+}
+
+// Slot of that day; a new day takes a free slot or the oldest one
+static int daySlot(uint32_t date) {
+  int oldest = 0;
+  for (int i = 0; i < STATS_DAYS; i++) {
+    if (g_days[i].date == date) return i;
+    if (g_days[i].date < g_days[oldest].date) oldest = i;
+  }
+  if (g_days[oldest].date != 0 && date < g_days[oldest].date) return -1; // older than the whole ring
+
+  if (g_days[oldest].date != 0) {
+    for (int k = 0; k < STATS_DAYS; k++) {
+      if (g_evicted[k] == 0) {
+        g_evicted[k] = g_days[oldest].date;
+        break;
+      }
+    }
+  }
+
+  memset(&g_days[oldest], 0, sizeof(DayRollup));
+  g_days[oldest].magic = STATS_MAGIC;
+  g_days[oldest].date = date;
+  return oldest;
+}
+
+// RTDB keys cannot contain . $ # [ ] / (quotes / backslash would break the JSON)
+static void mealKey(const char* mealName, char* out, size_t outSize) {
+  size_t n = 0;
+  for (const char* p = mealName ? mealName : ""; *p && n + 1 < outSize; p++) {
+    const char c = *p;
+    // unsigned: UTF-8 bytes (>= 0x80) are kept, only control characters go
+    out[n++] = ((unsigned char)c < 0x20 || strchr(".$#[]/\"\\", c)) ? '_' : c;
+  }
+  if (n == 0) {
+    strncpy(out, "meal", outSize - 1);
+    n = strlen(out);
+  }
+  out[n] = '\0';
+}
+
+static MealRollup* mealSlot(DayRollup& day, const char* mealName) {
+  char key[STATS_MEAL_NAME_MAX];
+  mealKey(mealName, key, sizeof(key));
+  for (int i = 0; i < day.mealCount; i++) {
+    if (strcmp(day.meals[i].name, key) == 0) return &day.meals[i];
+  }
+  if (day.mealCount >= STATS_MEALS_MAX) return nullptr;
+  MealRollup& m = day.meals[day.mealCount++];
+  strncpy(m.name, key, sizeof(m.name) - 1);
+  return &m;
+}
+
+static void changed(int i) {
+  saveSlot(i);
+  g_dayDirty[i] = true;
+  g_weekDirty = true;
+}
+
+static int32_t tenths(float grams) {
+  return grams > 0.0f ? (int32_t)(grams * 10.0f + 0.5f) : 0;
+}
+
+void statsRecordFeed(const char* dateISO, const char* mealName, float dispensedGrams,
+                     bool failed, uint32_t msToTarget) {
+  const uint32_t date = parseDate(dateISO);
+  if (date == 0) return;
+  const int i = daySlot(date);
+  if (i < 0) return;
+
+  DayRollup& day = g_days[i];
+  const int32_t d10 = tenths(dispensedGrams);
+  day.dispensed10 += d10;
+  day.feeds++;
+  if (failed) day.failures++;
+  if (msToTarget) {
+    day.ttSumMs += msToTarget;
+    day.ttCount++;
+  }
+
+  MealRollup* m = mealSlot(day, mealName);
+  if (m) {
+    m->dispensed10 += d10;
+    m->feeds++;
+    if (failed) m->failures++;
+  }
+  changed(i);
+}
+
+void statsRecordEaten(const char* dateISO, const char* mealName, float eatenGrams) {
+  const uint32_t date = parseDate(dateISO);
+  if (date == 0) return;
+  const int i = daySlot(date);
+  if (i < 0) return;
+
+  const int32_t e10 = tenths(eatenGrams); // bowl heavier than before (refill, noise) -> 0
+  g_days[i].eaten10 += e10;
+  MealRollup* m = mealSlot(g_days[i], mealName);
+  if (m) m->eaten10 += e10;
+  changed(i);
+}
+
+// Appends to g_payload; false if it would not fit
+static bool appendf(size_t& len, const char* fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+  const int n = vsnprintf(g_payload + len, sizeof(g_payload) - len, fmt, ap);
+  va_end(ap);
+  if (n < 0 || len + (size_t)n >= sizeof(g_payload)) return false;
+  len += (size_t)n;
+  return true;
+}
+
+static bool appendTotals(size_t& len, int32_t d10, int32_t e10, unsigned feeds, unsigned failures) {
+  return appendf(len, "\"d\":%ld.%ld,\"e\":%ld.%ld,\"n\":%u,\"f\":%u",
+                 (long)(d10 / 10), (long)(d10 % 10), (long)(e10 / 10), (long)(e10 % 10), feeds, failures);
+}
+
+static bool buildDay(const DayRollup& day) {
+  size_t len = 0;
+  const uint32_t tt10 = day.ttCount ? day.ttSumMs / day.ttCount / 100UL : 0;
+  bool ok = appendf(len, "{") &&
+            appendTotals(len, day.dispensed10, day.eaten10, day.feeds, day.failures) &&
+            appendf(len, ",\"tt\":%lu.%lu,\"m\":{", (unsigned long)(tt10 / 10), (unsigned long)(tt10 % 10));
+  for (int k = 0; k < day.mealCount && ok; k++) {
+    const MealRollup& m = day.meals[k];
+    ok = appendf(len, k ? ",\"%s\":{" : "\"%s\":{", m.name) &&
+         appendTotals(len, m.dispensed10, m.eaten10, m.feeds, m.failures) &&
+         appendf(len, "}");
+  }
+  return ok && appendf(len, "}}");
+}
+
+static bool buildWeek() {
+  size_t len = 0;
+  bool ok = appendf(len, "{");
+  bool first = true;
+  for (int i = 0; i < STATS_DAYS && ok; i++) {
+    const DayRollup& day = g_days[i];
+    if (day.date == 0) continue;
+    ok = appendf(len, first ? "\"%04lu-%02lu-%02lu\":{" : ",\"%04lu-%02lu-%02lu\":{",
+                 (unsigned long)(day.date / 10000UL), (unsigned long)(day.date / 100UL % 100UL),
+                 (unsigned long)(day.date % 100UL)) &&
+         appendTotals(len, day.dispensed10, day.eaten10, day.feeds, day.failures) &&
+         appendf(len, "}");
+    first = false;
+  }
+  return ok && appendf(len, "}");
+}
+
+bool statsTick(StatsUploadFn uploadFn) {
+  if (!uploadFn) return false;
+  if (g_publishedOnce && (millis() - g_lastPublishMs) < PUBLISH_MIN_INTERVAL_MS) return false;
+
+  char node[24];
+  bool ok = false;
+
+  int evicted = -1;
+  for (int k = 0; k < STATS_DAYS && evicted < 0; k++) {
+    if (g_evicted[k]) evicted = k;
+  }
+
+  int dirty = -1;
+  for (int i = 0; i < STATS_DAYS; i++) {
+    if (g_dayDirty[i] && (dirty < 0 || g_days[i].date < g_days[dirty].date)) dirty = i;
+  }
+
+  if (evicted >= 0) {
+    const uint32_t date = g_evicted[evicted];
+    snprintf(node, sizeof(node), "daily/%04lu-%02lu-%02lu", (unsigned long)(date / 10000UL),
+             (unsigned long)(date / 100UL % 100UL), (unsigned long)(date % 100UL));
+    ok = uploadFn(node, nullptr);
+    if (ok) g_evicted[evicted] = 0;
+  } else if (dirty >= 0) {
+    const DayRollup& day = g_days[dirty];
+    snprintf(node, sizeof(node), "daily/%04lu-%02lu-%02lu", (unsigned long)(day.date / 10000UL),
+             (unsigned long)(day.date / 100UL % 100UL), (unsigned long)(day.date % 100UL));
+    if (!buildDay(day)) {
+      Serial.println("[Stats] day summary too large -> skipped");
+      g_dayDirty[dirty] = false;
+      return false;
+    }
+    ok = uploadFn(node, g_payload);
+    if (ok) g_dayDirty[dirty] = false;
+  } else if (g_weekDirty) {
+    if (!buildWeek()) {
+      Serial.println("[Stats] week summary too large -> skipped");
+      g_weekDirty = false;
+      return false;
+    }
+    ok = uploadFn("week", g_payload);
+    if (ok) g_weekDirty = false;
+  } else {
+    return false;
+  }
+
+  // failed writes are retried after the same interval
+  g_lastPublishMs = millis();
+  g_publishedOnce = true;
+  return ok;
+}
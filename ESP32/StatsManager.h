@@ -0,0 +1,42 @@
+#ifndef STATSMANAGER_H
+#define STATSMANAGER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Daily consumption rollups, kept on the device so the app does not have to
+// download every /weights record to draw the week:
+// - one slot per day in a fixed ring (STATS_DAYS), per day up to
+//   STATS_MEALS_MAX meals: grams dispensed, grams eaten, feeds, failures,
+//   average time-to-target
+// - updated incrementally on every feed end / eaten figure, slot saved to
+//   NVS (only the day that changed)
+// - published as small summary nodes:
+//     /stats/daily/<YYYY-MM-DD> = {"d","e","n","f","tt","m":{"<meal>":{"d","e","n","f"}}}
+//     /stats/week               = {"<YYYY-MM-DD>":{"d","e","n","f"}, ...}  (all days in the ring)
+//   days that fall out of the ring are removed from /stats/daily.
+
+#define STATS_DAYS 8          // a week + today
+#define STATS_MEALS_MAX 6     // meals tracked per day (more -> counted in the day total only)
+
+// Once in setup() (loads the ring from NVS)
+void statsInit();
+
+// Feed ended. dateISO/mealName of the feed ("YYYY-MM-DD"; other dates are
+// ignored, e.g. no-clock feeds); failed = stopped by timeout / empty
+// container / disabled motor; msToTarget = 0 if the target was not reached.
+void statsRecordFeed(const char *dateISO, const char *mealName, float dispensedGrams,
+                     bool failed, uint32_t msToTarget);
+
+// Food eaten from a meal (bowl after it - bowl before the next one), known
+// when the next feed starts
+void statsRecordEaten(const char *dateISO, const char *mealName, float eatenGrams);
+
+// node = path under /stats ("daily/2026-01-31" or "week"); json = nullptr
+// -> remove the node
+typedef bool (*StatsUploadFn)(const char *node, const char *json);
+
+// From loop() while online: publishes at most one changed node per call
+bool statsTick(StatsUploadFn uploadFn);
+
+#endif
@@ -0,0 +1,69 @@
+#include "TaskManager.h"
+#include "MotorManager.h"
+#include "ScaleManager.h"
+#include "DistanceManager.h"
+#include <Arduino.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+static const BaseType_t MOTION_CORE        = 1;     // same core as loop(), preempts it
+static const UBaseType_t MOTION_PRIORITY   = 5;     // loop() runs at 1
+static const uint32_t MOTION_STACK         = 3072;
+static const BaseType_t SENSOR_CORE        = 0;     // WiFi / lwIP tasks are above it
+static const UBaseType_t SENSOR_PRIORITY   = 2;
+static const uint32_t SENSOR_STACK         = 4096;
+static const uint32_t SENSOR_FAST_MS       = 100;   // weight period while loop() is busy
+static const uint32_t DISTANCE_FAST_EVERY  = 2;     // distance every 2nd fast tick (200 ms)
+static const uint32_t SENSOR_IDLE_MS       = 1000;  // both, while loop() naps (<= one nap)
+
+static TaskHandle_t g_motionTask = nullptr;
+static TaskHandle_t g_sensorTask = nullptr;
+static std::atomic<bool> g_busy{true};
+
+static void motionTask(void*) {
+  for (;;) {
+    // 1 ms tick covers the 450 steps/s max speed; idle -> wait for a command
+    if (motorTaskTick()) vTaskDelay(1);
+    else ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  }
+}
+
+static void sensorTask(void*) {
+  ulTaskNotifyTake(pdTRUE, portMAX_DELAY);   // until the managers are attached
+  uint32_t tick = 0;
+  for (;;) {
+    const bool fast = g_busy.load(std::memory_order_relaxed);
+    scaleTaskTick();
+    if (!fast || (tick % DISTANCE_FAST_EVERY) == 0) distanceTaskTick();
+    tick++;
+    // a tare request (notification) cuts the wait short
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(fast ? SENSOR_FAST_MS : SENSOR_IDLE_MS));
+  }
+}
+
+bool tasksStart() {
+  if (xTaskCreatePinnedToCore(motionTask, "motion", MOTION_STACK, nullptr, MOTION_PRIORITY,
+                              &g_motionTask, MOTION_CORE) != pdPASS) {
+    g_motionTask = nullptr;
+    Serial.println("[Tasks] motion task not created -> motor stepped from loop()");
+  } else {
+    motorAttachTask(g_motionTask);
+  }
+
+  if (xTaskCreatePinnedToCore(sensorTask, "sensors", SENSOR_STACK, nullptr, SENSOR_PRIORITY,
+                              &g_sensorTask, SENSOR_CORE) != pdPASS) {
+    g_sensorTask = nullptr;
+    Serial.println("[Tasks] sensor task not created -> sensors read from loop()");
+  } else {
+    scaleAttachTask(g_sensorTask);
+    distanceAttachTask();
+    xTaskNotifyGive(g_sensorTask);
+  }
+
+  return g_motionTask && g_sensorTask;
+}
+
+void tasksSetBusy(bool busy) {
+  g_busy.store(busy, std::memory_order_relaxed);
+}
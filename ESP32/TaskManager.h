@@ -0,0 +1,30 @@
+#ifndef TASKMANAGER_H
+#define TASKMANAGER_H
+
+// FreeRTOS task layout. Before, everything ran in loop() and the slowest
+// call (a blocking HX711 read, a Firebase request, a LittleFS write) set the
+// stepping and sensing latency for everything else.
+//   motion  - core 1, above loop(): applies motor commands and calls
+//             stepper.run() every tick while the motor moves; blocked
+//             while it is idle (no cost, light sleep still possible)
+//   sensors - core 0, under the WiFi stack: HX711 + VL53L0X readings,
+//             fast while loop() is busy, slow while it naps
+//   loop()  - core 1 (Arduino task): feeding state machine, WiFi/Firebase,
+//             LittleFS/NVS, LEDs
+// Each cross-task path is a fixed-size lock-free SpscQueue (one producer,
+// one consumer):
+//   loop() -> motion:  start / stop / relative-move commands (MotorManager)
+//   sensors -> loop(): weight samples (ScaleManager), empty/full samples
+//                      (DistanceManager); tare requests go back via an
+//                      atomic generation counter
+// The manager APIs do not change, so main.ino calls them as before; only a
+// tare completes later (loop() polls scaleTarePoll()).
+
+// Once at the end of setup(), after the sensors and the motor are set up.
+// false = a task could not be created (everything stays inline in loop())
+bool tasksStart();
+
+// Every loop(): sensor rate follows the loop (busy = feeding / motor / etc.)
+void tasksSetBusy(bool busy);
+
+#endif
@@ -0,0 +1,284 @@
+#include "TelemetryManager.h"
+#include "CloudHealthManager.h"
+#include "FirebaseManager.h"
+#include "LatencyManager.h"
+#include "LocalManager.h"
+#include "PowerManager.h"
+#include <Arduino.h>
+#include <WiFi.h>
+#include <time.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+static const uint32_t INTERVAL_ACTIVE_MS = 60UL * 1000UL;        // something happened recently
+static const uint32_t INTERVAL_IDLE_MS   = 5UL * 60UL * 1000UL;  // normal
+static const uint32_t INTERVAL_QUIET_MS  = 15UL * 60UL * 1000UL; // nothing happened for a long time
+static const uint32_t ACTIVE_WINDOW_MS   = 10UL * 60UL * 1000UL; // activity keeps the short interval this long
+static const uint32_t QUIET_AFTER_MS     = 60UL * 60UL * 1000UL; // no activity this long -> quiet interval
+
+#define TELEMETRY_PAYLOAD_MAX 448
+#define TELEMETRY_LATENCY_PROBES 3     // step gap + slowest loop() probes per heartbeat
+#define DIAG_LATENCY_PROBES 8
+
+// ---------------- Metrics (fixed slots) ----------------
+enum Metric {
+  M_HEAP,        // free heap (B)
+  M_HEAP_MIN,    // lowest free heap since boot (B)
+  M_RSSI,        // WiFi RSSI (dBm)
+  M_QUEUE,       // offline weights queue size (B)
+  M_NTP,         // 1 = clock valid
+  M_BREAKER,     // BreakerState
+  M_REQ,         // cloud requests since boot
+  M_REQ_FAIL,    // failed cloud requests since boot
+  M_TLS,         // TLS handshakes since boot
+  M_FEEDS,       // feeds since boot
+  M_ALERTS,      // container alerts since boot
+  M_RECONNECTS,  // WiFi reconnects since boot
+  M_LOOP_MAX,    // slowest loop() since the last heartbeat (ms)
+  M_INTERVAL,    // current heartbeat interval (s)
+  M_CURRENT,     // estimated average current, last 24 h (0.1 mA)
+  M_NAPPING,     // share of that time spent napping (%)
+  M_WRITE_AMP,   // queue flash write amplification since boot (x100, 0 = nothing queued)
+  M_STEP_GAP,    // longest gap between two stepper.run() calls since the last heartbeat (ms)
+  M_COUNT
+};
+
+struct MetricDef {
+  const char* key;   // short JSON key (keeps the payload small)
+  int32_t deadband;  // change needed before the field is sent again
+};
+
+static const MetricDef kMetrics[M_COUNT] = {
+  {"hp", 1024}, {"hm", 1024}, {"rs", 3},   {"qb", 0},  {"ntp", 0},
+  {"br", 0},    {"rq", 0},    {"rf", 0},   {"tls", 0}, {"fd", 0},
+  {"al", 0},    {"nc", 0},    {"lm", 2},   {"iv", 0},  {"ma", 5},
+  {"np", 2},    {"wa", 10},  {"sg", 2},
+};
+
+static int32_t g_cur[M_COUNT];
+static int32_t g_sent[M_COUNT];      // values the cloud has (last accepted heartbeat)
+static bool g_haveSent = false;      // first heartbeat after boot sends everything
+
+static uint32_t g_loopHist[TELEMETRY_LOOP_BUCKETS];
+static uint32_t g_loopSamples = 0;
+static uint32_t g_loopMaxUs = 0;
+
+static uint32_t g_activityCount[3] = {0, 0, 0};
+static unsigned long g_lastActivityMs = 0;
+static unsigned long g_lastSendMs = 0;  // last attempt
+static bool g_attempted = false;
+static bool g_busy = false;          // breaker not closed / records waiting in the queue
+static uint32_t g_bootCounter = 0;
+
+static char g_payload[TELEMETRY_PAYLOAD_MAX];
+
+void telemetryInit(uint32_t bootCounter) {
+  g_bootCounter = bootCounter;
+  g_lastActivityMs = millis(); // boot counts as activity
+  g_attempted = false;
+  g_haveSent = false;
+  memset(g_loopHist, 0, sizeof(g_loopHist));
+  g_loopSamples = 0;
+  g_loopMaxUs = 0;
+}
+
+void telemetryLoopSample(uint32_t loopUs) {
+  uint32_t ms = loopUs / 1000UL;
+  uint8_t b = 0;
+  while (b < TELEMETRY_LOOP_BUCKETS - 1 && ms >= (1UL << b)) b++;
+
+  if (g_loopHist[b] != UINT32_MAX) g_loopHist[b]++;
+  g_loopSamples++;
+  if (loopUs > g_loopMaxUs) g_loopMaxUs = loopUs;
+}
+
+void telemetryNoteActivity(TelemetryActivity what) {
+  if ((int)what >= 0 && (int)what < 3) g_activityCount[what]++;
+  g_lastActivityMs = millis();
+}
+
+uint32_t telemetryIntervalMs() {
+  const unsigned long sinceActivity = millis() - g_lastActivityMs;
+  if (g_busy || sinceActivity < ACTIVE_WINDOW_MS) return INTERVAL_ACTIVE_MS;
+  if (sinceActivity >= QUIET_AFTER_MS) return INTERVAL_QUIET_MS;
+  return INTERVAL_IDLE_MS;
+}
+
+static void sampleMetrics(bool ntpValid) {
+  CloudHealthStats h;
+  cloudHealthGetStats(h);
+
+  FirebaseTlsStats tls;
+  firebaseGetTlsStats(tls);
+
+  g_cur[M_HEAP]       = (int32_t)ESP.getFreeHeap();
+  g_cur[M_HEAP_MIN]   = (int32_t)ESP.getMinFreeHeap();
+  g_cur[M_RSSI]       = (int32_t)WiFi.RSSI();
+  g_cur[M_QUEUE]      = (int32_t)localWeightsQueueBytes();
+  g_cur[M_NTP]        = ntpValid ? 1 : 0;
+  g_cur[M_BREAKER]    = (int32_t)h.state;
+  g_cur[M_REQ]        = (int32_t)h.requests;
+  g_cur[M_REQ_FAIL]   = (int32_t)h.failures;
+  g_cur[M_TLS]        = (int32_t)tls.handshakes;
+  g_cur[M_FEEDS]      = (int32_t)g_activityCount[TELEMETRY_ACT_FEED];
+  g_cur[M_ALERTS]     = (int32_t)g_activityCount[TELEMETRY_ACT_ALERT];
+  g_cur[M_RECONNECTS] = (int32_t)g_activityCount[TELEMETRY_ACT_NET];
+  g_cur[M_LOOP_MAX]   = (int32_t)(g_loopMaxUs / 1000UL);
+
+  PowerStats p;
+  powerGetStats(p);
+  g_cur[M_CURRENT]    = (int32_t)p.avgCurrentMa10;
+  g_cur[M_NAPPING]    = (int32_t)p.sleepPercent;
+
+  LocalQueueStats q;
+  localGetQueueStats(q);
+  g_cur[M_WRITE_AMP]  = q.recordBytes ? (int32_t)((uint64_t)q.flashPages * 256ULL * 100ULL / q.recordBytes) : 0;
+
+  LatencySummary gap;
+  latencyGetSummary(LAT_STEP_GAP, gap);
+  g_cur[M_STEP_GAP]   = (int32_t)(gap.maxUs / 1000UL);
+
+  g_busy = (h.state != BREAKER_CLOSED) || (g_cur[M_QUEUE] > 0);
+  g_cur[M_INTERVAL]   = (int32_t)(telemetryIntervalMs() / 1000UL);
+}
+
+// Appends to buf; false if it would not fit
+static bool appendf(char* buf, size_t size, size_t &len, const char* fmt, ...) __attribute__((format(printf, 4, 5)));
+static bool appendf(char* buf, size_t size, size_t &len, const char* fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+  int n = vsnprintf(buf + len, size - len, fmt, ap);
+  va_end(ap);
+  if (n < 0 || len + (size_t)n >= size) return false;
+  len += (size_t)n;
+  return true;
+}
+
+// Builds the delta heartbeat; marks which fields went in
+static bool encodeDelta(bool ntpValid, bool included[M_COUNT], bool &histIncluded) {
+  size_t len = 0;
+  bool ok = appendf(g_payload, sizeof(g_payload), len, "{\"up\":%lu", (unsigned long)(millis() / 1000UL));
+
+  if (ntpValid) ok = ok && appendf(g_payload, sizeof(g_payload), len, ",\"t\":%lu", (unsigned long)time(nullptr));
+  if (!g_haveSent) ok = ok && appendf(g_payload, sizeof(g_payload), len, ",\"bt\":%lu", (unsigned long)g_bootCounter);
+
+  for (int i = 0; i < M_COUNT; i++) {
+    const int32_t diff = g_cur[i] - g_sent[i];
+    included[i] = !g_haveSent || diff > kMetrics[i].deadband || diff < -kMetrics[i].deadband;
+    if (included[i]) ok = ok && appendf(g_payload, sizeof(g_payload), len, ",\"%s\":%ld", kMetrics[i].key, (long)g_cur[i]);
+  }
+
+  histIncluded = (g_loopSamples > 0);
+  if (histIncluded) {
+    ok = ok && appendf(g_payload, sizeof(g_payload), len, ",\"lh\":[");
+    for (int b = 0; b < TELEMETRY_LOOP_BUCKETS; b++) {
+      ok = ok && appendf(g_payload, sizeof(g_payload), len, b ? ",%lu" : "%lu", (unsigned long)g_loopHist[b]);
+    }
+    ok = ok && appendf(g_payload, sizeof(g_payload), len, "]");
+  }
+
+#if LATENCY_PROFILING
+  if (histIncluded) {
+    ok = ok && appendf(g_payload, sizeof(g_payload), len, ",\"lt\":") &&
+         latencyAppendJson(g_payload, sizeof(g_payload), len, TELEMETRY_LATENCY_PROBES);
+  }
+#endif
+
+  return ok && appendf(g_payload, sizeof(g_payload), len, "}");
+}
+
+bool telemetryTick(TelemetryUploadFn uploadFn, bool ntpValid) {
+  if (!uploadFn) return false;
+  if (g_attempted && (millis() - g_lastSendMs) < telemetryIntervalMs()) return false;
+  g_attempted = true;
+  g_lastSendMs = millis();
+
+  sampleMetrics(ntpValid);
+
+  bool included[M_COUNT];
+  bool histIncluded = false;
+  if (!encodeDelta(ntpValid, included, histIncluded)) {
+    Serial.println("[Telemetry] payload too large -> skipped");
+    return false;
+  }
+
+  if (!uploadFn(g_payload)) {
+    // keep the old base: the next heartbeat re-sends everything that moved
+    Serial.println("[Telemetry] heartbeat upload failed");
+    return false;
+  }
+
+  for (int i = 0; i < M_COUNT; i++) {
+    if (included[i]) g_sent[i] = g_cur[i];
+  }
+  g_haveSent = true;
+
+  // histograms + loop max restart with every heartbeat
+  memset(g_loopHist, 0, sizeof(g_loopHist));
+  g_loopSamples = 0;
+  g_loopMaxUs = 0;
+  latencyReset();
+
+  Serial.printf("[Telemetry] heartbeat %u B, next in %lu s\n",
+                (unsigned)strlen(g_payload), (unsigned long)(telemetryIntervalMs() / 1000UL));
+  return true;
+}
+
+bool telemetryDiagnosticsJson(char *out, size_t outSize, bool ntpValid) {
+  if (!out || outSize == 0) return false;
+  sampleMetrics(ntpValid);
+
+  CloudHealthStats h;
+  cloudHealthGetStats(h);
+  FirebaseTlsStats tls;
+  firebaseGetTlsStats(tls);
+
+  size_t len = 0;
+  bool ok = appendf(out, outSize, len,
+                    "{\"up\":%lu,\"bt\":%lu,\"ntp\":%d,\"t\":%lu,"
+                    "\"heap\":%lu,\"heapMin\":%lu,\"heapMaxAlloc\":%lu,\"rssi\":%d,\"queueBytes\":%lu,",
+                    (unsigned long)(millis() / 1000UL), (unsigned long)g_bootCounter, ntpValid ? 1 : 0,
+                    ntpValid ? (unsigned long)time(nullptr) : 0UL,
+                    (unsigned long)ESP.getFreeHeap(), (unsigned long)ESP.getMinFreeHeap(),
+                    (unsigned long)ESP.getMaxAllocHeap(), (int)WiFi.RSSI(),
+                    (unsigned long)g_cur[M_QUEUE]);
+
+  ok = ok && appendf(out, outSize, len,
+                     "\"cloud\":{\"state\":%d,\"requests\":%lu,\"failures\":%lu,\"consecutive\":%lu,"
+                     "\"avgMs\":%lu,\"maxMs\":%lu,\"opens\":%lu,\"cooldownMs\":%lu},",
+                     (int)h.state, (unsigned long)h.requests, (unsigned long)h.failures,
+                     (unsigned long)h.consecutiveFailures, (unsigned long)h.avgLatencyMs,
+                     (unsigned long)h.maxLatencyMs, (unsigned long)h.opens, (unsigned long)h.cooldownMs);
+
+  ok = ok && appendf(out, outSize, len,
+                     "\"tls\":{\"handshakes\":%lu,\"failures\":%lu,\"avgMs\":%lu,\"maxMs\":%lu,\"heapCost\":%ld},",
+                     (unsigned long)tls.handshakes, (unsigned long)tls.failures,
+                     (unsigned long)(tls.handshakes ? tls.totalMs / tls.handshakes : 0),
+                     (unsigned long)tls.maxMs, (long)tls.lastHeapCost);
+
+  LocalQueueStats q;
+  localGetQueueStats(q);
+  ok = ok && appendf(out, outSize, len,
+                     "\"queueFlash\":{\"records\":%lu,\"recordBytes\":%lu,\"flashBytes\":%lu,\"pages\":%lu,"
+                     "\"commits\":%lu,\"nvsWrites\":%lu,\"staged\":%lu},",
+                     (unsigned long)q.records, (unsigned long)q.recordBytes, (unsigned long)q.flashBytes,
+                     (unsigned long)q.flashPages, (unsigned long)q.commits, (unsigned long)q.nvsWrites,
+                     (unsigned long)q.stagedBytes);
+
+  ok = ok && appendf(out, outSize, len, "\"loopMaxMs\":%lu,\"loopHist\":[", (unsigned long)(g_loopMaxUs / 1000UL));
+  for (int b = 0; b < TELEMETRY_LOOP_BUCKETS; b++) {
+    ok = ok && appendf(out, outSize, len, b ? ",%lu" : "%lu", (unsigned long)g_loopHist[b]);
+  }
+  ok = ok && appendf(out, outSize, len, "]");
+#if LATENCY_PROFILING
+  ok = ok && appendf(out, outSize, len, ",\"latencyUs\":") &&
+       latencyAppendJson(out, outSize, len, DIAG_LATENCY_PROBES);
+#endif
+  ok = ok && appendf(out, outSize, len, ",\"feeds\":%lu,\"alerts\":%lu,\"reconnects\":%lu,\"intervalS\":%lu}",
+                     (unsigned long)g_activityCount[TELEMETRY_ACT_FEED],
+                     (unsigned long)g_activityCount[TELEMETRY_ACT_ALERT],
+                     (unsigned long)g_activityCount[TELEMETRY_ACT_NET],
+                     (unsigned long)(telemetryIntervalMs() / 1000UL));
+  return ok;
+}
@@ -0,0 +1,50 @@
+#ifndef TELEMETRYMANAGER_H
+#define TELEMETRYMANAGER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Device heartbeat: metrics are aggregated on-device into fixed-size counters
+// and a loop-time histogram, and uploaded as ONE small write per interval to
+// /status/telemetry.
+// - delta encoded: only fields that moved more than their deadband since the
+//   last heartbeat the cloud accepted are sent (the update merges them into
+//   the node, so it always holds the full latest state)
+// - adaptive interval: 1 min while something is happening (feeds, alerts,
+//   reconnects, breaker not closed, queued records), 5 min when idle,
+//   15 min after an hour of quiet
+// - the per-subsystem latency histograms (LatencyManager) ride along: the
+//   longest stepper gap as a metric, the slowest probes as "lt"
+
+// Loop-time histogram buckets: <1, <2, <4, <8, <16, <32, <64, >=64 ms
+#define TELEMETRY_LOOP_BUCKETS 8
+
+enum TelemetryActivity {
+  TELEMETRY_ACT_FEED,      // a feeding started
+  TELEMETRY_ACT_ALERT,     // container empty/refilled
+  TELEMETRY_ACT_NET        // WiFi came back
+};
+
+void telemetryInit(uint32_t bootCounter);
+
+// Once per loop(), with that loop's duration
+void telemetryLoopSample(uint32_t loopUs);
+
+// Something happened -> count it + switch to the short interval
+void telemetryNoteActivity(TelemetryActivity what);
+
+// Upload-callback (we will pass firebasePublishTelemetry here).
+// json = a flat JSON object to merge into the heartbeat node.
+typedef bool (*TelemetryUploadFn)(const char *json);
+
+// Call from loop() while online + idle. Samples, encodes and uploads the
+// heartbeat when the interval elapsed. Returns true if one was sent.
+bool telemetryTick(TelemetryUploadFn uploadFn, bool ntpValid);
+
+// Current heartbeat interval (ms)
+uint32_t telemetryIntervalMs();
+
+// Full (non-delta) dump of everything we track, for a diagnostics request
+bool telemetryDiagnosticsJson(char *out, size_t outSize, bool ntpValid);
+
+#endif
@@ -7,6 +7,17 @@
 #include "NtpManager.h"
 #include "FirebaseManager.h"
 #include "LocalManager.h"
+#include "EventIdManager.h"
+#include "CloudHealthManager.h"
+#include "TelemetryManager.h"
+#include "FeedProgressManager.h"
+#include "ScheduleManager.h"
+#include "PowerManager.h"
+#include "StatsManager.h"
+#include "EatingManager.h"
+#include "TaskManager.h"
+#include "EventBus.h"
+#include "LatencyManager.h"
 
 #include <Arduino.h>
 #include <WiFi.h>
@@ -53,6 +64,7 @@ float feedTargetWeightGrams      = 0.0f;   // Target = current weight + portion
 bool pendingContainerStatusUpdate = false;
 bool pendingContainerEmptyValue = false;
 unsigned long lastContainerStatusPublishAttemptMs = 0;
+uint64_t pendingContainerEventId = EVENT_ID_NONE;   // one ID per empty/refill transition
 const unsigned long CONTAINER_STATUS_PUBLISH_RETRY_MS = 5000; // 5s
 
 // Feeding notification logging (RTDB)
@@ -61,14 +73,12 @@ bool firebaseLogMealNotification(const char* type,
                                  int hour,
                                  int minute,
                                  int amountGrams,
-                                 int32_t eventId);
+                                 uint64_t eventId);
 
 // Track current feeding "session"
-int32_t currentFeedingEventId = -1;
+uint64_t currentFeedingEventId = EVENT_ID_NONE;
 
 
-static bool feedingStopNotified = false;
-
 // One-time initial sync after boot
 bool didInitialContainerSync = false;
 
@@ -87,9 +97,11 @@ MotorState motorState = MOTOR_ENABLED;
 // ---------- Feeding state machine ----------
 enum FeedState {
   FEED_IDLE,
+  FEED_TARING,   // feed requested, waiting for the sensor task's tare
   FEED_ACTIVE
 };
 FeedState feedState = FEED_IDLE;
+static float feedPortionGrams = 0.0f;  // portion of the feed being started (FEED_TARING)
 
 // Track if we already started motor for this feeding cycle
 bool motorStartedThisCycle = false;
@@ -113,6 +125,9 @@ char prev_mealName[30] = {0};
 char prev_day[10] = {0};
 char prev_dateISO[11] = {0};
 float prev_currentWeightGramsRecieved = 0.0f;
+uint64_t prev_eventId = EVENT_ID_NONE;
+bool prev_noClock = false;   // fed without a valid clock: the no-clock log owns its record
+uint32_t prev_feedStartMs = 0; // millis() at its feed start (the no-clock log's time base)
 
 bool upload_status = true;
 
@@ -195,6 +210,7 @@ static const unsigned long OPEN_PORTAL_AFTER_MS = 100UL * 1000UL;
 
 
 static bool portalPending = false;
+static bool wifiWasConnected = true;   // first offline loop -> WifiChanged (starts the portal timer)
 static unsigned long motorDoneSinceMs = 0;
 static const unsigned long MOTOR_DONE_STABLE_MS = 400;
 
@@ -206,16 +222,16 @@ static bool firebaseInited = false;
 static Preferences prefs;
 static uint32_t bootCounter = 0;
 
-// --------------------  No-clock OFFLINE accumulator (RAM only) --------------------
-static bool  noClockAccumHasData       = false;
-static int   noClockAccumTotalGrams    = 0;
-static float noClockAccumSumPrevWeight = 0.0f;
-static float noClockAccumLastNewWeight = 0.0f;
-
-// Track current feeding start info (so we can accumulate at END of feeding)
+// Track current feeding start info (no-clock feeds are logged at END of feeding)
 static bool  curFeedingNoClock       = false;
 static int   curFeedingAmountGrams   = 0;
 static float curFeedingStartWeight   = 0.0f;
+static uint32_t curFeedingStartMs    = 0;
+static uint64_t curFeedingEventId    = EVENT_ID_NONE;
+static char  curFeedingMealName[30]  = "";
+
+// Grams of the last meal already added to the daily stats (eating sessions)
+static float prevMealEatenCounted    = 0.0f;
 
 // -------------------- Helpers --------------------
 static bool timeIsValid() {
@@ -254,12 +270,6 @@ static void scheduleInitialOfflineFeed() {
   }
 }
 
-static int32_t makeEventIdEpochSecondsLocal() {//make a unique id from the time
-  time_t now = time(nullptr);
-  if (now >= 100000) return (int32_t)now;
-  return (int32_t)(millis() / 1000UL);
-}
-
 void getCurrentDayNameNow(char *dayOut, size_t dayOutSize) {//print current time
   if (!dayOut || dayOutSize == 0) return;
 
@@ -318,16 +328,222 @@ void update_prevs() { //store latest feeding starting parameters
 
   strncpy(prev_dateISO, dateISO, sizeof(prev_dateISO) - 1);
   prev_dateISO[sizeof(prev_dateISO) - 1] = '\0';
+
+  prev_eventId = currentFeedingEventId;
+  prev_noClock = !timeIsValid();
+}
+
+// Record of the previous meal (prev_* = last feed) with the bowl weight now.
+// Eaten since the last call -> daily stats; record -> cloud or the offline
+// queue (cloud unreachable / upload failed). Same event key every time, so a
+// later call (eating session, next feed) just rewrites the node.
+// No-clock meals: prev_day/prev_dateISO are not theirs. While the feed is
+// in the no-clock log the reading goes there (same event key); once the log
+// has been queued the meal takes its reconstructed time and goes on as usual.
+static void storePrevMealRecord(float bowlNow) {
+  if (!prev_mealName[0]) return;
+  if (prev_noClock) {
+    if (localLogNoClockReading(prev_eventId, bowlNow)) return;
+    if (!localNoClockFeedTime(prev_feedStartMs, prev_feed_hour, prev_feed_minute,
+                              prev_day, sizeof(prev_day), prev_dateISO, sizeof(prev_dateISO))) {
+      Serial.println(" No-clock meal: reading not logged.");
+      return;
+    }
+    prev_noClock = false;
+  }
+  LATENCY_SCOPE(LAT_MEAL_RECORD);
+
+  const float eaten = prev_currentWeightGramsRecieved - bowlNow;
+  if (eaten > prevMealEatenCounted) {
+    statsRecordEaten(prev_dateISO, prev_mealName, eaten - prevMealEatenCounted);
+    prevMealEatenCounted = eaten;
+  }
+
+  // one key per meal for every retry (minted once, kept in prev_eventId)
+  if (prev_eventId == EVENT_ID_NONE) prev_eventId = eventIdNext();
+
+  upload_status = false;
+  if (firebaseIsDatabaseConnected()) {
+    upload_status = update_weight(prev_dueAmount,
+                                  prev_feed_hour,
+                                  prev_feed_minute,
+                                  prev_mealName,
+                                  prev_day,
+                                  prev_dateISO,
+                                  prev_currentWeightGramsRecieved,
+                                  bowlNow,
+                                  prev_eventId);
+  }
+  if (!upload_status) {
+    if (timeIsValid()) {
+      (void)localQueueWeightUpdate(prev_dueAmount,
+                                   prev_feed_hour,
+                                   prev_feed_minute,
+                                   prev_mealName,
+                                   prev_day,
+                                   prev_dateISO,
+                                   prev_currentWeightGramsRecieved,
+                                   bowlNow,
+                                   prev_eventId);
+    } else {
+      Serial.println(" No-clock mode: skipping file queue (no-clock log will handle it).");
+    }
+    upload_status = true;
+  }
+}
+
+// -------------------- Events (EventBus.h) --------------------
+
+// feedProgressEnd / stats result of a FeedEnded
+static const char *feedEndResult(FeedEndReason reason) {
+  switch (reason) {
+    case FEED_END_TARGET_REACHED: return "done";
+    case FEED_END_TIMEOUT:        return "timeout";
+    case FEED_END_EMPTY:          return "empty";
+    case FEED_END_DISABLED:       return "disabled";
+    case FEED_END_CANCELLED:      return "cancelled";
+  }
+  return "unknown";
+}
+
+// /notifications type of a FeedEnded
+static const char *feedEndNotification(FeedEndReason reason) {
+  switch (reason) {
+    case FEED_END_TARGET_REACHED: return "feeding_success";
+    case FEED_END_TIMEOUT:        return "feeding_failed_timeout";
+    case FEED_END_EMPTY:          return "feeding_stopped_empty";
+    case FEED_END_DISABLED:       return "feeding_stopped_disabled";
+    case FEED_END_CANCELLED:      return "feeding_cancelled";
+  }
+  return "feeding_stopped";
+}
+
+// Stops the running feed (no-op when none runs -> each feed ends once)
+static void endFeed(FeedEndReason reason) {
+  if (feedState != FEED_ACTIVE) return;
+  if (currentFeedingEventId == EVENT_ID_NONE) { currentFeedingEventId = eventIdNext(); }
+  eventPublish(FeedEnded{reason, currentFeedingEventId, currentWeightGramsRecieved});
+}
+
+// Feed state machine: motor off, back to idle, final weight once the motor has stopped
+static void onFeedEndedStop(const FeedEnded &e) {
+  stopMotor();
+  feedState = FEED_IDLE;
+  aboveTargetCount = 0;
+  motorStartedThisCycle = false;
+
+  timeoutRecoveryPhase = TR_NONE;
+  timeoutRecoveryCount = 0;
+
+  pendingFinalWeight = true; // still record what was given
+  motorStoppedAtMs = 0;
+  pendingFinalWeightSinceMs = millis(); //  start watchdog timer
+
+  currentFeedingEventId = EVENT_ID_NONE;
+  Serial.printf(" Feeding ended (%s) -> motor stopping\n", feedEndResult(e.reason));
+}
+
+// Feed dropped while still taring (cancel, tare failed): back to idle before
+// the motor ever ran; the bowl weight is captured like after any stopped feed
+static void abortTaringFeed(const char *why) {
+  scaleTareCancel();
+  feedState = FEED_IDLE;
+  currentFeedingEventId = EVENT_ID_NONE;
+
+  pendingFinalWeight = true;
+  motorStoppedAtMs = 0;
+  pendingFinalWeightSinceMs = millis();
+  Serial.printf(" Feeding dropped before the motor started (%s)\n", why);
+}
+
+// Last live-progress write + daily rollup
+static void onFeedEndedRecord(const FeedEnded &e) {
+  const char *result = feedEndResult(e.reason);
+  feedProgressEnd(result, e.bowlGrams);
+
+  const bool reached = (e.reason == FEED_END_TARGET_REACHED);
+  const bool failed = !reached && e.reason != FEED_END_CANCELLED;
+  statsRecordFeed(dateISO, mealName, e.bowlGrams - curFeedingStartWeight,
+                  failed, reached ? (uint32_t)(millis() - curFeedingStartMs) : 0);
+}
+
+static void onFeedEndedNotify(const FeedEnded &e) {
+  if (!firebaseIsDatabaseConnected()) return;
+  LATENCY_SCOPE(LAT_NOTIFY);
+  (void)firebaseLogMealNotification(
+      feedEndNotification(e.reason),
+      mealName,
+      feed_hour,
+      feed_minute,
+      dueAmount,
+      e.eventId);
 }
 
 // Only store the scheduled portion; the state machine will start feeding in FEED_IDLE.
+static void onFeedRequested(const FeedRequested &e) {
+  scheduledPortionGrams = e.portionGrams;
+  scheduledFeedRequest = true;
+
+  Serial.printf(" Scheduled feeding requested: +%.1f grams\n", e.portionGrams);
+}
+
 void startScheduledFeeding(float portionGrams) {
   if (portionGrams <= 0) return;
+  eventPublish(FeedRequested{portionGrams});
+}
 
-  scheduledPortionGrams = portionGrams;
-  scheduledFeedRequest = true;
+// /status container flag, published (with retry) once the feeder is idle
+static void queueContainerStatus(bool empty) {
+  pendingContainerStatusUpdate = true;
+  pendingContainerEmptyValue = empty;
+  pendingContainerEventId = eventIdNext();
+  lastContainerStatusPublishAttemptMs = 0;
+}
 
-  Serial.printf(" Scheduled feeding requested: +%.1f grams\n", portionGrams);
+static void onContainerChangedFeeding(const ContainerChanged &e) {
+  if (e.empty) {
+    endFeed(FEED_END_EMPTY);
+    motorState = MOTOR_DISABLED;
+    Serial.println(" Container empty -> motor disabled");
+  } else {
+    motorState = MOTOR_ENABLED;
+    Serial.println(" Container refilled -> motor enabled");
+  }
+}
+
+static void onContainerChangedStatus(const ContainerChanged &e) {
+  queueContainerStatus(e.empty);
+  telemetryNoteActivity(TELEMETRY_ACT_ALERT);
+}
+
+// Auto-portal timer: runs while offline, cancelled when WiFi returns
+static void onWifiChangedPortal(const WifiChanged &e) {
+  if (!e.connected) {
+    offlineSinceMs = millis();
+    firebaseInited = false;
+    return;
+  }
+  offlineSinceMs = 0;
+  portalPending = false;      // cancel if WiFi returned
+  motorDoneSinceMs = 0;
+}
+
+static void onWifiChangedCloud(const WifiChanged &e) {
+  if (!e.connected) return;
+  cloudHealthReset(); // WiFi just returned -> fresh breaker
+  telemetryNoteActivity(TELEMETRY_ACT_NET);
+}
+
+// Subscriber order = call order (see EventBus.h)
+static void subscribeEvents() {
+  eventSubscribe<FeedRequested>(onFeedRequested);
+  eventSubscribe<FeedEnded>(onFeedEndedRecord);
+  eventSubscribe<FeedEnded>(onFeedEndedNotify);
+  eventSubscribe<FeedEnded>(onFeedEndedStop);
+  eventSubscribe<ContainerChanged>(onContainerChangedFeeding);
+  eventSubscribe<ContainerChanged>(onContainerChangedStatus);
+  eventSubscribe<WifiChanged>(onWifiChangedPortal);
+  eventSubscribe<WifiChanged>(onWifiChangedCloud);
 }
 
 // --------------------  FIX: clear stale scheduledFeedRequest --------------------
@@ -352,6 +568,8 @@ void setup() {
   Serial.begin(115200);
   delay(500);
 
+  subscribeEvents();
+
   initDistance();
   initPixels();
   initMotor();
@@ -362,6 +580,13 @@ void setup() {
   initLocalStorage();
 
   prefsBootInitAndLoad();
+  scheduleInit();
+  (void)localLoadScheduleCache();
+  statsInit();
+  initEventIds(bootCounter);
+  localNoClockBegin(bootCounter);
+  telemetryInit(bootCounter);
+  powerInit(FEED_BUTTON_PIN);
 
   wipeCreds();
 
@@ -386,12 +611,15 @@ void setup() {
 
   prevTimeValid = timeIsValid();
 
+  // motor stepping + sensor reads leave loop() (see TaskManager.h)
+  (void)tasksStart();
+
   Serial.println(" Boot complete");
 }
 
 // ---------- Motor + feeding logic (state machine) ----------
 void updateMotorAndFeeding() {
-  updateMotor();
+  LATENCY_CALL(LAT_MOTOR, updateMotor());
 
   bool buttonPressed    = (digitalRead(FEED_BUTTON_PIN) == LOW);
   bool buttonRisingEdge = (buttonPressed && !prevButtonPressed);
@@ -406,40 +634,11 @@ void updateMotorAndFeeding() {
   }
 
 
-  // If we are ACTIVE and we are forced to stop due to motor disabled / container empty,
-  // log a stop reason ONCE before we wipe eventId/state.
-  if (motorState == MOTOR_DISABLED || containerEmpty) {
-
-    if (feedState == FEED_ACTIVE && !feedingStopNotified) {
-      if (currentFeedingEventId < 0) { currentFeedingEventId = makeEventIdEpochSecondsLocal(); }
-
-      if (WiFi.status() == WL_CONNECTED) {
-        (void)firebaseLogMealNotification(
-            containerEmpty ? "feeding_stopped_empty" : "feeding_stopped_disabled",
-            mealName,
-            feed_hour,
-            feed_minute,
-            dueAmount,
-            currentFeedingEventId);
-      }
-      feedingStopNotified = true;
-    }
-
-    stopMotor();
-    feedState = FEED_IDLE;
-    aboveTargetCount = 0;
-    motorStartedThisCycle = false;
-
-    timeoutRecoveryPhase = TR_NONE;
-    timeoutRecoveryCount = 0;
-
-    currentFeedingEventId = -1;
-
-    // avoid stale state
-    curFeedingNoClock = false;
-    curFeedingAmountGrams = 0;
-    curFeedingStartWeight = 0.0f;
-
+  // Nothing starts while the motor is disabled / the container is empty
+  // (a running feed is normally ended by ContainerChanged already; a feed
+  // still taring starts first and is ended right after, like any other)
+  if ((motorState == MOTOR_DISABLED || containerEmpty) && feedState != FEED_TARING) {
+    endFeed(containerEmpty ? FEED_END_EMPTY : FEED_END_DISABLED);
     return;
   }
 
@@ -478,9 +677,11 @@ void updateMotorAndFeeding() {
 
         dueAmount = (int)lroundf(portion);
 
-        currentFeedingEventId = makeEventIdEpochSecondsLocal();
+        currentFeedingEventId = eventIdNext();
+        telemetryNoteActivity(TELEMETRY_ACT_FEED);
 
-        if (WiFi.status() == WL_CONNECTED) {
+        if (firebaseIsDatabaseConnected()) {
+          LATENCY_SCOPE(LAT_NOTIFY);
           (void)firebaseLogMealNotification(
               "feeding_started",
               mealName,
@@ -491,96 +692,60 @@ void updateMotorAndFeeding() {
         }
 
 
-        feedingStopNotified = false;
-
-        // Upload/store previous feeding weights
-        if (prev_mealName[0]) {
-          if (WiFi.status() == WL_CONNECTED) {
-            upload_status = update_weight(prev_dueAmount,
-                                          prev_feed_hour,
-                                          prev_feed_minute,
-                                          prev_mealName,
-                                          prev_day,
-                                          prev_dateISO,
-                                          prev_currentWeightGramsRecieved,
-                                          currentWeightGramsRecieved);
-          } else {
-            if (timeIsValid()) {
-              (void)localQueueWeightUpdate(prev_dueAmount,
-                                           prev_feed_hour,
-                                           prev_feed_minute,
-                                           prev_mealName,
-                                           prev_day,
-                                           prev_dateISO,
-                                           prev_currentWeightGramsRecieved,
-                                           currentWeightGramsRecieved);
-            } else {
-              Serial.println(" No-clock mode: skipping file queue (RAM accumulation will handle it).");
-            }
-            upload_status = true;
-          }
-        }
+        // Upload/store previous feeding weights (final: bowl weight right before this feed)
+        storePrevMealRecord(currentWeightGramsRecieved);
+        prevMealEatenCounted = 0.0f;
+        eatingStop();
 
         update_prevs();
 
+        // the tare runs in the sensor task; the feed goes on in FEED_TARING
         reZeroScale();
-        updateWeight();
-        currentWeightGramsRecieved = getWeight();
+        feedPortionGrams = portion;
+        feedState = FEED_TARING;
+      }
+      break;
 
-        // tag this feeding so we can accumulate when it FINISHES (final weight)
-        curFeedingNoClock     = !timeIsValid();
-        curFeedingAmountGrams = dueAmount;
-        curFeedingStartWeight = currentWeightGramsRecieved;
+    case FEED_TARING: {
+      const ScaleTareState tare = scaleTarePoll();
+      if (tare == SCALE_TARE_PENDING) break;
+      if (tare == SCALE_TARE_FAILED) {
+        abortTaringFeed("scale tare failed");  // no real zero -> the target would be wrong
+        break;
+      }
 
-        timeoutRecoveryPhase = TR_NONE;
-        timeoutRecoveryCount = 0;
+      // first reading after the tare (scaleTarePoll() waited for it)
+      const float portion = feedPortionGrams;
+      currentWeightGramsRecieved = getWeight();
 
-        feedTargetWeightGrams = currentWeightGramsRecieved + portion;
-        feedStartMillis       = millis();
-        feedState             = FEED_ACTIVE;
+      // tag this feeding so we can accumulate when it FINISHES (final weight)
+      curFeedingNoClock     = prev_noClock;
+      curFeedingAmountGrams = dueAmount;
+      curFeedingStartWeight = currentWeightGramsRecieved;
+      curFeedingStartMs     = millis();
+      prev_feedStartMs      = curFeedingStartMs;
+      curFeedingEventId     = currentFeedingEventId;
+      strncpy(curFeedingMealName, mealName, sizeof(curFeedingMealName) - 1);
+      curFeedingMealName[sizeof(curFeedingMealName) - 1] = '\0';
 
-        startMotor();
-        motorStartedThisCycle = true;
+      timeoutRecoveryPhase = TR_NONE;
+      timeoutRecoveryCount = 0;
 
-        Serial.printf(" Feeding started (portion=%.1f, target=%.1f)\n",
-                      portion, feedTargetWeightGrams);
-      }
-      break;
+      feedTargetWeightGrams = currentWeightGramsRecieved + portion;
+      feedStartMillis       = millis();
+      feedState             = FEED_ACTIVE;
 
-    case FEED_ACTIVE:
-      // NOTE: containerEmpty stop is already handled by the guard above,
-      // but keeping this block is fine. We'll keep it, but ensure it logs once.
-      if (containerEmpty) {
-        stopMotor();
-        feedState = FEED_IDLE;
-        aboveTargetCount = 0;
-        motorStartedThisCycle = false;
+      startMotor();
+      motorStartedThisCycle = true;
 
-        timeoutRecoveryPhase = TR_NONE;
+      feedProgressBegin(currentFeedingEventId, portion, currentWeightGramsRecieved);
 
-        pendingFinalWeight = true;
-        motorStoppedAtMs = 0;
-        pendingFinalWeightSinceMs = millis(); //  start watchdog timer
-
-        //  log stop due to empty (once)
-        if (!feedingStopNotified) {
-          if (currentFeedingEventId < 0) { currentFeedingEventId = makeEventIdEpochSecondsLocal(); }
-          if (WiFi.status() == WL_CONNECTED) {
-            (void)firebaseLogMealNotification(
-                "feeding_stopped_empty",
-                mealName,
-                feed_hour,
-                feed_minute,
-                dueAmount,
-                currentFeedingEventId);
-          }
-          feedingStopNotified = true;
-        }
-
-        currentFeedingEventId = -1;
-        break;
-      }
+      Serial.printf(" Feeding started (portion=%.1f, target=%.1f)\n",
+                    portion, feedTargetWeightGrams);
+      break;
+    }
 
+    case FEED_ACTIVE:
       // recovery wiggle handling
       if (timeoutRecoveryPhase != TR_NONE) {
         unsigned long nowMs = millis();
@@ -616,65 +781,12 @@ void updateMotorAndFeeding() {
       }
 
       if (aboveTargetCount >= REQUIRED_ABOVE_TARGET) {
-        stopMotor();
-        feedState = FEED_IDLE;
-        motorStartedThisCycle = false;
-
-        timeoutRecoveryPhase = TR_NONE;
-
-        pendingFinalWeight = true;
-        motorStoppedAtMs = 0;
-        pendingFinalWeightSinceMs = millis(); 
-
-        if (currentFeedingEventId < 0) { currentFeedingEventId = makeEventIdEpochSecondsLocal(); }
-
-        if (WiFi.status() == WL_CONNECTED) {
-          (void)firebaseLogMealNotification(
-              "feeding_success",
-              mealName,
-              feed_hour,
-              feed_minute,
-              dueAmount,
-              currentFeedingEventId);
-        }
-
-        //   already notified for this session
-        feedingStopNotified = true;
-
-        currentFeedingEventId = -1;
-        Serial.println(" Target reached, motor stopping");
+        endFeed(FEED_END_TARGET_REACHED);
       }
       else if (millis() - feedStartMillis > FEED_TIMEOUT_MS) {
 
         if (timeoutRecoveryCount >= TIMEOUT_RECOVERY_MAX) {
-          stopMotor();
-          feedState = FEED_IDLE;
-          aboveTargetCount = 0;
-          motorStartedThisCycle = false;
-
-          timeoutRecoveryPhase = TR_NONE;
-
-          pendingFinalWeight = true;
-          motorStoppedAtMs = 0;
-          pendingFinalWeightSinceMs = millis(); //  start watchdog timer
-
-          if (currentFeedingEventId < 0) { currentFeedingEventId = makeEventIdEpochSecondsLocal(); }
-
-          if (WiFi.status() == WL_CONNECTED) {
-            (void)firebaseLogMealNotification(
-                "feeding_failed_timeout",
-                mealName,
-                feed_hour,
-                feed_minute,
-                dueAmount,
-                currentFeedingEventId);
-          }
-
-          
-          feedingStopNotified = true;
-
-          currentFeedingEventId = -1;
-          Serial.println("Timeout reached (max recoveries) -> motor stopping");
+          endFeed(FEED_END_TIMEOUT);
           break;
         }
 
@@ -698,17 +810,190 @@ void updateMotorAndFeeding() {
   }
 }
 
+// -------------------- Remote commands (streamed from /commands) --------------------
+static const float MAX_REMOTE_PORTION_GRAMS = 100.0f; // refuse anything bigger than this from the app
+
+// The ack is a network write -> sent after updateMotorAndFeeding() so it never delays the motor.
+// It stays pending until the write succeeds (retried with backoff); no new command runs meanwhile.
+static const unsigned long ACK_RETRY_MIN_MS = 1000;
+static const unsigned long ACK_RETRY_MAX_MS = 30000;
+static RemoteCommand pendingAckCmd;
+static bool pendingAck = false;
+static const char* pendingAckStatus = "done";
+static const char* pendingAckReason = "";
+static unsigned long pendingAckExecutedMs = 0;
+static unsigned long pendingAckNextTryMs = 0;
+static unsigned long pendingAckBackoffMs = ACK_RETRY_MIN_MS;
+
+static void queueCommandAck(const RemoteCommand& cmd, const char* status, const char* reason) {
+  pendingAckCmd = cmd;
+  pendingAckStatus = status;
+  pendingAckReason = reason ? reason : "";
+  pendingAckExecutedMs = millis();
+  pendingAckNextTryMs = pendingAckExecutedMs;
+  pendingAckBackoffMs = ACK_RETRY_MIN_MS;
+  pendingAck = true;
+  Serial.printf(" Remote command %s -> %s %s (%lu ms)\n", cmd.id, status, pendingAckReason,
+                pendingAckExecutedMs - cmd.receivedMs);
+}
+
+static void flushCommandAck() {
+  if (!pendingAck) return;
+  if (!firebaseInited || WiFi.status() != WL_CONNECTED) return;
+  if ((long)(millis() - pendingAckNextTryMs) < 0) return;
+
+  if (firebaseAckCommand(pendingAckCmd, pendingAckStatus, pendingAckReason, pendingAckExecutedMs)) {
+    pendingAck = false;
+    return;
+  }
+  Serial.printf("[Cmd] ack %s failed -> retry in %lu ms\n", pendingAckCmd.id, pendingAckBackoffMs);
+  pendingAckNextTryMs = millis() + pendingAckBackoffMs;
+  pendingAckBackoffMs = (pendingAckBackoffMs >= ACK_RETRY_MAX_MS / 2) ? ACK_RETRY_MAX_MS : pendingAckBackoffMs * 2;
+}
+
+// "tare" is acked once the sensor task really tared (no new command meanwhile)
+static RemoteCommand tareAckCmd;
+static bool tareAckPending = false;
+
+static void tareCommandTick() {
+  if (!tareAckPending) return;
+  const ScaleTareState tare = scaleTarePoll();
+  if (tare == SCALE_TARE_PENDING) return;
+  tareAckPending = false;
+  if (tare == SCALE_TARE_DONE) queueCommandAck(tareAckCmd, "done", "");
+  else queueCommandAck(tareAckCmd, "failed", "tare_timeout");
+}
+
+static void handleRemoteCommand(const RemoteCommand& cmd) {
+  if (cmd.expired) { queueCommandAck(cmd, "expired", nullptr); return; }
+  switch (cmd.type) {
+    case CMD_FEED_NOW: {
+      float portion = cmd.grams > 0 ? (float)cmd.grams : FEED_PORTION_GRAMS;
+      if (portion > MAX_REMOTE_PORTION_GRAMS) { queueCommandAck(cmd, "rejected", "too_much"); return; }
+      if (feedState != FEED_IDLE || scheduledFeedRequest || pendingFinalWeight) {
+        queueCommandAck(cmd, "rejected", "busy");
+        return;
+      }
+      if (motorState == MOTOR_DISABLED || containerEmpty) {
+        queueCommandAck(cmd, "rejected", containerEmpty ? "container_empty" : "motor_disabled");
+        return;
+      }
+
+      time_t now = time(nullptr);
+      if (now >= 100000) {
+        struct tm tmNow;
+        localtime_r(&now, &tmNow);
+        feed_hour = tmNow.tm_hour;
+        feed_minute = tmNow.tm_min;
+      } else {
+        feed_hour = 0;
+        feed_minute = 0;
+      }
+      strncpy(mealName, "remote", sizeof(mealName) - 1);
+      mealName[sizeof(mealName) - 1] = '\0';
+      dueAmount = (int)lroundf(portion);
+      setCurrentDayName(day, sizeof(day));
+      setCurrentDateISO(dateISO, sizeof(dateISO));
+
+      startScheduledFeeding(portion); // picked up by FEED_IDLE in this same loop()
+      queueCommandAck(cmd, "done", "");
+      return;
+    }
+
+    case CMD_CANCEL:
+      if (feedState == FEED_ACTIVE) {
+        endFeed(FEED_END_CANCELLED);
+        queueCommandAck(cmd, "done", "");
+      } else if (feedState == FEED_TARING) {
+        abortTaringFeed("remote cancel");     // the motor never ran
+        queueCommandAck(cmd, "cancelled", "");
+      } else if (scheduledFeedRequest) {
+        clearScheduledFeedRequest("remote cancel");
+        queueCommandAck(cmd, "done", "");
+      } else {
+        queueCommandAck(cmd, "rejected", "idle");
+      }
+      return;
+
+    case CMD_TARE:
+      if (feedState != FEED_IDLE || scheduledFeedRequest || pendingFinalWeight) {
+        queueCommandAck(cmd, "rejected", "busy");
+        return;
+      }
+      {
+        const float bowlBefore = getWeight();
+        reZeroScale();
+        // last meal's bowl weight moves to the new zero (keeps "eaten" right)
+        prev_currentWeightGramsRecieved -= bowlBefore;
+        eatingStart(0.0f);
+      }
+      tareAckCmd = cmd;
+      tareAckPending = true;
+      return;
+
+    case CMD_DIAGNOSTICS: {
+      static char diag[1024];
+      bool ok = telemetryDiagnosticsJson(diag, sizeof(diag), ntpValid) && firebasePublishDiagnostics(diag);
+      queueCommandAck(cmd, ok ? "done" : "failed", ok ? "" : "upload_failed");
+      return;
+    }
+  }
+}
+
+// Serial console: "lat" = latency table, "lat reset" = restart the histograms
+static void serialCommandTick() {
+  static char line[16];
+  static uint8_t len = 0;
+  while (Serial.available() > 0) {
+    const int c = Serial.read();
+    if (c == '\r') continue;
+    if (c != '\n') {
+      if (len < sizeof(line) - 1) line[len++] = (char)c;
+      continue;
+    }
+    line[len] = '\0';
+    len = 0;
+    if (strcmp(line, "lat") == 0) {
+      latencyPrint();
+    } else if (strcmp(line, "lat reset") == 0) {
+      latencyReset();
+      Serial.println("[Latency] reset");
+    } else if (line[0]) {
+      Serial.printf(" Unknown command '%s' (lat, lat reset)\n", line);
+    }
+  }
+}
+
+// ms until the loop must run on time again (next meal / offline interval feed)
+static uint32_t msUntilNextWake() {
+  if (ntpValid) {
+    const time_t now = time(nullptr);
+    const time_t next = scheduleNextEventTime(now);
+    if (next == 0) return POWER_NO_DEADLINE;
+    if (next <= now) return 0;
+    const time_t sec = next - now;
+    return (sec >= (time_t)(POWER_NO_DEADLINE / 1000UL)) ? POWER_NO_DEADLINE : (uint32_t)sec * 1000UL;
+  }
+
+  // no clock: interval feeding (only if it could actually run)
+  if (motorState != MOTOR_ENABLED || containerEmpty) return POWER_NO_DEADLINE;
+  const int32_t left = (int32_t)(nextOfflineFeedMs - millis());
+  return left > 0 ? (uint32_t)left : 0;
+}
+
 // ---------- main loop ----------
 void loop() {
-  updateMotor();
+  const unsigned long loopStartUs = micros();
+
+  LATENCY_CALL(LAT_MOTOR, updateMotor());
 
-  updateDistance();
-  updateWeight();
+  LATENCY_CALL(LAT_SENSORS, updateDistance(); updateWeight());
 
-  wifiAutoReconnectTick();
+  LATENCY_CALL(LAT_WIFI, wifiAutoReconnectTick());
 
   // ---- Capture final weight only after motor fully stops + settles ----
   if (pendingFinalWeight) {
+    LATENCY_SCOPE(LAT_FINAL_WEIGHT);
 
 
     if (pendingFinalWeightSinceMs != 0 &&
@@ -718,7 +1003,7 @@ void loop() {
 
       // Best effort: ensure stop command, then read weight anyway
       stopMotor();
-      updateMotor();
+      LATENCY_CALL(LAT_MOTOR, updateMotor());
       delay(20);
 
       updateWeight();
@@ -727,6 +1012,7 @@ void loop() {
       pendingFinalWeight = false;
       motorStoppedAtMs = 0;
       pendingFinalWeightSinceMs = 0;
+      eatingStart(prev_currentWeightGramsRecieved);
 
       Serial.print(" Forced final weight captured: ");
       Serial.println(prev_currentWeightGramsRecieved);
@@ -742,21 +1028,13 @@ void loop() {
           prev_currentWeightGramsRecieved = getWeight();
 
           if (curFeedingNoClock) {
-            if (!noClockAccumHasData) {
-              noClockAccumHasData = true;
-              noClockAccumTotalGrams = 0;
-              noClockAccumSumPrevWeight = 0.0f;
-            }
-
-            noClockAccumTotalGrams += curFeedingAmountGrams;
-            noClockAccumSumPrevWeight += prev_currentWeightGramsRecieved;
-
-            Serial.printf(" No-clock accum: +%d g (total=%d), +prev=%.1f (sumPrev=%.1f), lastNew=%.1f\n",
-                          curFeedingAmountGrams,
-                          noClockAccumTotalGrams,
-                          curFeedingStartWeight,
-                          noClockAccumSumPrevWeight,
-                          noClockAccumLastNewWeight);
+            // one record per feed; timestamped once NTP is valid
+            (void)localLogNoClockFeed(curFeedingEventId,
+                                      curFeedingStartMs,
+                                      curFeedingAmountGrams,
+                                      curFeedingStartWeight,
+                                      prev_currentWeightGramsRecieved,
+                                      curFeedingMealName);
 
             curFeedingNoClock = false;
             curFeedingAmountGrams = 0;
@@ -766,6 +1044,7 @@ void loop() {
           pendingFinalWeight = false;
           motorStoppedAtMs = 0;
           pendingFinalWeightSinceMs = 0; 
+          eatingStart(prev_currentWeightGramsRecieved);
 
           Serial.print(" Final weight captured: ");
           Serial.println(prev_currentWeightGramsRecieved);
@@ -792,54 +1071,13 @@ void loop() {
 
   // ---- Initial container sync ----
   if (!didInitialContainerSync) {
-    pendingContainerStatusUpdate = true;
-    pendingContainerEmptyValue = containerEmpty;
-    lastContainerStatusPublishAttemptMs = 0;
+    queueContainerStatus(containerEmpty);
     didInitialContainerSync = true;
   }
 
   // ---- Container transitions ----
-  if (!prevEmpty && containerEmpty) {
-
-    //   (MINIMAL): if container becomes empty DURING an active feed,
-    // log "feeding_stopped_empty" BEFORE we wipe feedState/eventId here.
-    if (feedState == FEED_ACTIVE && !feedingStopNotified) {
-      if (currentFeedingEventId < 0) { currentFeedingEventId = makeEventIdEpochSecondsLocal(); }
-      if (WiFi.status() == WL_CONNECTED) {
-        (void)firebaseLogMealNotification(
-            "feeding_stopped_empty",
-            mealName,
-            feed_hour,
-            feed_minute,
-            dueAmount,
-            currentFeedingEventId);
-      }
-      feedingStopNotified = true;
-    }
-
-    motorState = MOTOR_DISABLED;
-    feedState = FEED_IDLE;
-    stopMotor();
-    motorStartedThisCycle = false;
-
-    timeoutRecoveryPhase = TR_NONE;
-    timeoutRecoveryCount = 0;
-
-    currentFeedingEventId = -1;
-
-    Serial.println(" Container empty -> motor disabled");
-
-    pendingContainerStatusUpdate = true;
-    pendingContainerEmptyValue = true;
-    lastContainerStatusPublishAttemptMs = 0;
-
-  } else if (prevEmpty && !containerEmpty) {
-    motorState = MOTOR_ENABLED;
-    Serial.println(" Container refilled -> motor enabled");
-
-    pendingContainerStatusUpdate = true;
-    pendingContainerEmptyValue = false;
-    lastContainerStatusPublishAttemptMs = 0;
+  if (prevEmpty != containerEmpty) {
+    eventPublish(ContainerChanged{containerEmpty});
   }
 
   // ---- Publish container status (retry) ----
@@ -849,8 +1087,9 @@ void loop() {
 
     lastContainerStatusPublishAttemptMs = millis();
 
-    if (WiFi.status() == WL_CONNECTED) {
-      bool ok = firebasePublishContainerEmpty(pendingContainerEmptyValue);
+    if (firebaseIsDatabaseConnected()) {
+      LATENCY_SCOPE(LAT_CONTAINER);
+      bool ok = firebasePublishContainerEmpty(pendingContainerEmptyValue, pendingContainerEventId);
       if (ok) {
         pendingContainerStatusUpdate = false;
       }
@@ -858,18 +1097,15 @@ void loop() {
   }
 
   bool wifiConnected = (WiFi.status() == WL_CONNECTED);
-  updateNeoPixel(containerEmpty, wifiConnected);
+  LATENCY_CALL(LAT_PIXELS, updateNeoPixel(containerEmpty, wifiConnected));
 
-  // -------------------- AUTO portal open (DEFERRED) --------------------
-  if (WiFi.status() != WL_CONNECTED) {
-    if (offlineSinceMs == 0) offlineSinceMs = millis();
-    firebaseInited = false;
-  } else {
-    offlineSinceMs = 0;
-    portalPending = false;      // cancel if WiFi returned
-    motorDoneSinceMs = 0;
+  if (wifiConnected != wifiWasConnected) {
+    wifiWasConnected = wifiConnected;
+    eventPublish(WifiChanged{wifiConnected});
   }
 
+  // -------------------- AUTO portal open (DEFERRED) --------------------
+
   // Arm portalPending after being offline long enough (do NOT block yet)
   if (WiFi.status() != WL_CONNECTED &&
       offlineSinceMs != 0 &&
@@ -905,7 +1141,7 @@ void loop() {
       Serial.println(" portalPending: motor stopped + stable -> opening provisioning portal (blocking)...");
       portalPending = false;
       motorDoneSinceMs = 0;
-      offlineSinceMs = 0;
+      offlineSinceMs = millis(); // portal gave up -> wait the full offline time again
 
       
       
@@ -932,6 +1168,7 @@ void loop() {
 
   // If idle, keep trying NTP non-blocking
   if (feedState == FEED_IDLE) {
+    LATENCY_SCOPE(LAT_NTP);
     ntpValid = ntpTick();
     if (ntpValid) {
       prefsClearOfflineFeedMarker();
@@ -945,64 +1182,48 @@ void loop() {
   //  clear stale scheduledFeedRequest on NO-CLOCK -> CLOCK transition
   handleTimeRecoveryClear();
 
-  updateMotor();
+  LATENCY_CALL(LAT_MOTOR, updateMotor());
 
   // ---- Scheduling decisions ----
   if (feedState == FEED_IDLE) {
 
-    //  If WiFi+clock are back and we have RAM no-clock data -> upload ONE row
-    if (WiFi.status() == WL_CONNECTED && timeIsValid() && noClockAccumHasData) {
-
-      time_t now = time(nullptr);
-      struct tm tmNow;
-      localtime_r(&now, &tmNow);
-
-      char nowDay[10];
-      char nowDate[11];
-      getCurrentDayNameNow(nowDay, sizeof(nowDay));
-      getCurrentDateISONow(nowDate, sizeof(nowDate));
-
-      int nowHour = tmNow.tm_hour;
-      int nowMin  = tmNow.tm_min;
-
-      char meal[32];
-      snprintf(meal, sizeof(meal), "offline_%s_%02d-%02d", nowDate, nowHour, nowMin);
-      noClockAccumLastNewWeight = getWeight();
-
-      bool ok = update_weight(
-          noClockAccumTotalGrams,
-          nowHour,
-          nowMin,
-          meal,
-          nowDay,
-          nowDate,
-          noClockAccumSumPrevWeight,
-          noClockAccumLastNewWeight
-      );
-
-      if (ok) {
-        Serial.println(" Uploaded NO-CLOCK accumulated entry -> clearing RAM accumulator");
-        noClockAccumHasData = false;
-        noClockAccumTotalGrams = 0;
-        noClockAccumSumPrevWeight = 0.0f;
-        noClockAccumLastNewWeight = 0.0f;
-      } else {
-        Serial.println(" Upload of NO-CLOCK accumulated entry failed -> will retry later");
+    //  Clock is back -> no-clock feeds get their timestamps and join the offline queue
+    LATENCY_CALL(LAT_NOCLOCK, localNoClockTick(timeIsValid()));
+
+    // Dog stopped eating -> finalize the meal record + stats now, not at the next feed
+    if (!pendingFinalWeight) {
+      eatingSample(getWeight());
+      EatingSession session;
+      if (eatingPollSession(session)) {
+        Serial.printf(" Eating session: %.1f g in %lu s (bowl now %.1f g)\n",
+                      session.gramsRemoved, (unsigned long)(session.durationMs / 1000UL),
+                      session.levelAfter);
+        storePrevMealRecord(session.levelAfter);
       }
     }
 
+    // Staged offline records -> flash after a while (group commit)
+    LATENCY_CALL(LAT_QUEUE_COMMIT, localQueueTick());
+
     // 1) If online + idle -> try flushing normal offline queue (throttled)
-    if (WiFi.status() == WL_CONNECTED && localWeightsQueueExists()) {
+    if (firebaseIsDatabaseConnected() && localWeightsQueueExists()) {
       if (lastQueueSyncMs == 0 || (millis() - lastQueueSyncMs) >= QUEUE_SYNC_INTERVAL_MS) {
         lastQueueSyncMs = millis();
-        (void)localFlushWeightsQueue(update_weight);
+        LATENCY_CALL(LAT_QUEUE_FLUSH, (void)localFlushWeightsQueueBatched(update_weights_batch));
       }
     }
 
+    // Device heartbeat (one small delta write per interval, interval adapts to activity)
+    if (firebaseIsDatabaseConnected()) {
+      LATENCY_CALL(LAT_TELEMETRY, (void)telemetryTick(firebasePublishTelemetry, ntpValid));
+      LATENCY_CALL(LAT_STATS, (void)statsTick(firebasePublishStats));
+    }
+
     // 2) If we have real time -> normal schedule (Firebase / Local schedule)
     if (ntpValid) {
 
       if (firebaseIsDatabaseConnected()) {
+        LATENCY_SCOPE(LAT_SCHEDULE);
         firebaseLoop();
 
         bool due = firebaseGetDueFeeding(dueAmount, feed_hour, feed_minute,
@@ -1021,6 +1242,7 @@ void loop() {
         }
       } else {
         //Serial.println("couldnt reach firebase (offline db) -> using LOCAL schedule");
+        LATENCY_SCOPE(LAT_SCHEDULE);
 
         bool dueLocal = localGetDueFeeding(dueAmount, feed_hour, feed_minute,
                                            mealName, sizeof(mealName));
@@ -1066,6 +1288,36 @@ void loop() {
     }
   }
 
-  updateMotorAndFeeding();
-  delay(1);
+  // ---- Remote commands (stream; handled right before the state machine so a
+  // "feed now" starts the motor in this same loop) ----
+  if (firebaseInited && WiFi.status() == WL_CONNECTED) {
+    LATENCY_SCOPE(LAT_COMMANDS);
+    firebaseCommandsLoop();
+    RemoteCommand cmd;
+    if (!pendingAck && !tareAckPending && firebasePollCommand(cmd)) handleRemoteCommand(cmd);
+  }
+
+  LATENCY_CALL(LAT_FEEDING, updateMotorAndFeeding());
+  tareCommandTick();
+  LATENCY_CALL(LAT_ACK, flushCommandAck());
+  serialCommandTick();
+
+  // Live progress for the app (4 Hz max, async write; ends with the feed)
+  if (feedState == FEED_ACTIVE) {
+    feedProgressSample(currentWeightGramsRecieved, timeoutRecoveryPhase != TR_NONE);
+  }
+  if (feedProgressActive() && firebaseInited && WiFi.status() == WL_CONNECTED) {
+    LATENCY_CALL(LAT_PROGRESS, (void)feedProgressTick(firebasePublishFeedProgress));
+  }
+
+  telemetryLoopSample((uint32_t)(micros() - loopStartUs));
+
+  // ---- Power: nap until the next deadline when nothing is going on ----
+  const bool motorRunning = !motorMoveDone();
+  const bool powerBusy = feedState != FEED_IDLE || scheduledFeedRequest || pendingFinalWeight ||
+                         motorRunning || (pendingAck && WiFi.status() == WL_CONNECTED) || tareAckPending ||
+                         feedProgressActive() || portalPending ||
+                         pendingContainerStatusUpdate || rawEmptyCandidate != containerEmpty;
+  tasksSetBusy(powerBusy);
+  powerIdle(powerBusy, motorRunning, WiFi.status() == WL_CONNECTED, msUntilNextWake());
 }
@@ -0,0 +1,168 @@
+// Minimal Arduino core for building the feeder's network code on Linux.
+// Only what FirebaseManager / LocalManager / EventIdManager /
+// CloudHealthManager use; not a general Arduino emulation.
+#pragma once
+
+#include <math.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <string>
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define IRAM_ATTR
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
+#define F(x) (x)
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void yield();
+uint32_t esp_random();
+
+// Host only: move millis()/micros() forward without sleeping, so the
+// firmware's interval timers (schedule poll, retries) can be driven quickly.
+void hostClockAdvance(unsigned long ms);
+
+bool getLocalTime(struct tm* info, uint32_t ms = 5000);
+
+#if defined(__GLIBC__) && (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38)
+size_t strlcpy(char* dst, const char* src, size_t size);
+#endif
+
+// ---------------- String ----------------
+class String {
+public:
+  String() {}
+  String(const char* c) : s_(c ? c : "") {}
+  String(const std::string& s) : s_(s) {}
+  String(char c) : s_(1, c) {}
+  String(int v) : s_(std::to_string(v)) {}
+  String(unsigned v) : s_(std::to_string(v)) {}
+  String(long v) : s_(std::to_string(v)) {}
+  String(unsigned long v) : s_(std::to_string(v)) {}
+  String(long long v) : s_(std::to_string(v)) {}
+  String(unsigned long long v) : s_(std::to_string(v)) {}
+  String(double v, unsigned decimals = 2);
+
+  const char* c_str() const { return s_.c_str(); }
+  unsigned length() const { return (unsigned)s_.size(); }
+  bool isEmpty() const { return s_.empty(); }
+  void reserve(unsigned n) { s_.reserve(n); }
+
+  bool concat(const char* c) { s_ += c ? c : ""; return true; }
+  bool concat(const char* c, unsigned n) { s_.append(c, n); return true; }
+  bool concat(char c) { s_ += c; return true; }
+  bool concat(const String& o) { s_ += o.s_; return true; }
+
+  String& operator+=(const String& o) { s_ += o.s_; return *this; }
+  String& operator+=(const char* c) { s_ += c ? c : ""; return *this; }
+  String& operator+=(char c) { s_ += c; return *this; }
+
+  bool operator==(const String& o) const { return s_ == o.s_; }
+  bool operator==(const char* c) const { return s_ == (c ? c : ""); }
+  bool operator!=(const String& o) const { return s_ != o.s_; }
+  bool operator!=(const char* c) const { return !(*this == c); }
+  char operator[](unsigned i) const { return i < s_.size() ? s_[i] : 0; }
+
+  int indexOf(char c, unsigned from = 0) const;
+  int indexOf(const String& o, unsigned from = 0) const;
+  String substring(unsigned from) const;
+  String substring(unsigned from, unsigned to) const;
+  bool startsWith(const String& o) const { return s_.compare(0, o.s_.size(), o.s_) == 0; }
+  bool endsWith(const String& o) const;
+  void trim();
+  void toLowerCase();
+  void remove(unsigned index, unsigned count = 1);
+  long toInt() const { return strtol(s_.c_str(), nullptr, 10); }
+  float toFloat() const { return strtof(s_.c_str(), nullptr); }
+
+  const std::string& std() const { return s_; }
+
+private:
+  std::string s_;
+};
+
+// ArduinoJson's String adapter also matches this type
+class StringSumHelper : public String {
+public:
+  StringSumHelper(const String& s) : String(s) {}
+};
+
+StringSumHelper operator+(const String& a, const String& b);
+StringSumHelper operator+(const String& a, const char* b);
+StringSumHelper operator+(const char* a, const String& b);
+
+// ---------------- Print / Stream ----------------
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buf, size_t n);
+  size_t write(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+  size_t write(const char* s, size_t n) { return write((const uint8_t*)s, n); }
+
+  size_t print(const char* s) { return write(s); }
+  size_t print(const String& s) { return write(s.c_str(), s.length()); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(int v) { return print(String(v)); }
+  size_t print(unsigned v) { return print(String(v)); }
+  size_t print(long v) { return print(String(v)); }
+  size_t print(unsigned long v) { return print(String(v)); }
+  size_t print(double v, int decimals = 2) { return print(String(v, (unsigned)decimals)); }
+
+  template <class T> size_t println(const T& v) { return print(v) + println(); }
+  size_t println(double v, int decimals) { return print(v, decimals) + println(); }
+  size_t println() { return write("\r\n"); }
+
+  int printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+  virtual void flush() {}
+};
+
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+
+  void setTimeout(unsigned long ms) { timeoutMs_ = ms; }
+  size_t readBytes(char* buf, size_t n);
+  size_t readBytes(uint8_t* buf, size_t n) { return readBytes((char*)buf, n); }
+  size_t readBytesUntil(char term, char* buf, size_t n);
+  String readString();
+  String readStringUntil(char term);
+
+protected:
+  int timedRead();
+  unsigned long timeoutMs_ = 1000;
+};
+
+// stdout-backed Serial
+class HardwareSerial : public Stream {
+public:
+  using Print::write;
+  void begin(unsigned long) {}
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* buf, size_t n) override;
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+  void flush() override { fflush(stdout); }
+  operator bool() const { return true; }
+  void setQuiet(bool quiet) { quiet_ = quiet; } // benchmarks mute firmware logs
+
+private:
+  bool quiet_ = false;
+};
+
+extern HardwareSerial Serial;
+
+#include "Esp.h"
@@ -0,0 +1,15 @@
+#pragma once
+#include <stdint.h>
+
+// Heap figures are constants on the host (no ESP32 heap to measure)
+class EspClass {
+public:
+  uint32_t getFreeHeap() { return 200000; }
+  uint32_t getMinFreeHeap() { return 200000; }
+  uint32_t getMaxAllocHeap() { return 110000; }
+  uint32_t getCpuFreqMHz() { return 240; }
+  uint32_t getCycleCount();
+  void restart() {}
+};
+
+extern EspClass ESP;
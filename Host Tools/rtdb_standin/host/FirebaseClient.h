@@ -0,0 +1,218 @@
+// Host subset of FirebaseClient (Mobizt) 2.x: the synchronous RealtimeDatabase
+// calls the firmware makes, sent as plain HTTP/1.1 keep-alive requests over the
+// AsyncClient's network client to the RTDB stand-in.
+//
+// Streams (Database.get(..., cb, true)) are real SSE connections on the
+// stream client, read without blocking from FirebaseApp::loop().
+//
+// Target: $RTDB_HOST:$RTDB_PORT (default 127.0.0.1:9000); DATABASE_URL is ignored.
+// Auth is skipped (the app is "ready" right away). Each request carries an
+// ?auth= query of $RTDB_AUTH_BYTES characters (default 950, about the size of a
+// real Firebase ID token) so byte counts stay close to the device's.
+#pragma once
+
+#include <string>
+
+#include "Arduino.h"
+#include "WiFiClient.h"
+
+class FirebaseError {
+public:
+  int code() const { return code_; }
+  String message() const { return message_; }
+  void set(int code, const String& message) { code_ = code; message_ = message; }
+
+private:
+  int code_ = 0;
+  String message_;
+};
+
+class AppEvent {
+public:
+  int code() const { return 0; }
+  String message() const { return String(); }
+};
+
+// One SSE event ("put"/"patch"/"keep-alive"...) of a stream
+class RealtimeDatabaseResult {
+public:
+  bool isStream() const { return stream_; }
+  String event() const { return event_; }
+  String dataPath() const { return path_; }
+  template <class T> T to() const { return T(data_); }
+
+  void setEvent(const String& event, const String& path, const String& data) {
+    stream_ = true;
+    event_ = event;
+    path_ = path;
+    data_ = data;
+  }
+
+private:
+  bool stream_ = false;
+  String event_, path_, data_;
+};
+
+// Only delivered to stream callbacks on the host
+class AsyncResult {
+public:
+  bool isResult() const { return available_ || error_.code() != 0; }
+  bool isEvent() const { return false; }
+  bool isError() const { return error_.code() != 0; }
+  bool available() const { return available_; }
+  String uid() const { return uid_; }
+  AppEvent appEvent() const { return AppEvent(); }
+  FirebaseError error() const { return error_; }
+  const char* c_str() const { return raw_.c_str(); }
+  template <class T> T& to() { return rtdb_; }
+
+  void setStreamEvent(const String& uid, const String& event, const String& path, const String& data) {
+    uid_ = uid;
+    raw_ = data;
+    available_ = true;
+    rtdb_.setEvent(event, path, data);
+  }
+  void setResult(const String& uid, const String& data) {
+    uid_ = uid;
+    raw_ = data;
+    available_ = true;
+  }
+  void setError(const String& uid, int code, const String& message) {
+    uid_ = uid;
+    error_.set(code, message);
+  }
+
+private:
+  bool available_ = false;
+  String uid_, raw_;
+  FirebaseError error_;
+  RealtimeDatabaseResult rtdb_;
+};
+typedef void (*AsyncResultCallback)(AsyncResult&);
+
+class AsyncClientClass {
+public:
+  explicit AsyncClientClass(Client& client) : client_(client) {}
+  FirebaseError lastError() const { return error_; }
+
+  // One request/response on the keep-alive connection (reconnects if needed).
+  // Returns the HTTP status, or a negative code on network errors.
+  int request(const char* method, const String& path, const std::string& body, String& response);
+
+  // SSE stream on this client (it can't serve plain requests while open)
+  void openStream(const String& path, AsyncResultCallback cb, const String& uid);
+  void pollStream();
+  void stopAsync();
+
+private:
+  bool connectStream();
+
+  Client& client_;
+  FirebaseError error_;
+  AsyncResultCallback streamCb_ = nullptr;
+  String streamPath_, streamUid_;
+  std::string streamBuf_;
+  bool streamHeadersDone_ = false;
+};
+
+// Reads whatever arrived on every open stream and runs their callbacks
+void hostPollStreams();
+
+class UserAuth {
+public:
+  UserAuth(const char*, const char*, const char*, size_t = 3300) {}
+};
+
+class user_auth_data {};
+user_auth_data& getAuth(UserAuth& auth);
+
+class FirebaseApp {
+public:
+  void loop() { hostPollStreams(); }
+  bool ready() { return ready_; }
+  bool isAuthenticated() { return ready_; }
+  template <class T> void getApp(T&) {}
+  void setReady() { ready_ = true; }
+
+private:
+  bool ready_ = false;
+};
+
+void initializeApp(AsyncClientClass& client, FirebaseApp& app, user_auth_data& auth,
+                   AsyncResultCallback cb, const String& uid = "");
+
+// Raw JSON value (object/array) written as-is
+class object_t {
+public:
+  object_t() {}
+  explicit object_t(const String& json) : json_(json) {}
+  explicit object_t(const char* json) : json_(json) {}
+  const char* c_str() const { return json_.c_str(); }
+
+private:
+  String json_;
+};
+
+class RealtimeDatabase {
+public:
+  void url(const String&) {}
+
+  template <class T> T get(AsyncClientClass& client, const String& path) {
+    String body;
+    int status = client.request("GET", path, std::string(), body);
+    return (status >= 200 && status < 300) ? T(body) : T();
+  }
+
+  // Stream (sse = true); a one-shot async get is not used by the firmware
+  void get(AsyncClientClass& client, const String& path, AsyncResultCallback cb, bool sse,
+           const String& uid = "") {
+    if (sse) client.openStream(path, cb, uid);
+  }
+
+  template <class T> bool set(AsyncClientClass& client, const String& path, const T& value) {
+    return write(client, "PUT", path, toJson(value));
+  }
+
+  template <class T> bool update(AsyncClientClass& client, const String& path, const T& value) {
+    return write(client, "PATCH", path, toJson(value));
+  }
+
+  // Async form: done synchronously on the host, result delivered right away
+  template <class T> void update(AsyncClientClass& client, const String& path, const T& value,
+                                 AsyncResultCallback cb, const String& uid = "") {
+    String response;
+    int status = client.request("PATCH", path, toJson(value), response);
+    AsyncResult r;
+    if (status >= 200 && status < 300) r.setResult(uid, response);
+    else r.setError(uid, status, response);
+    if (cb) cb(r);
+  }
+
+  template <class T> String push(AsyncClientClass& client, const String& path, const T& value) {
+    String body;
+    int status = client.request("POST", path, toJson(value), body);
+    return (status >= 200 && status < 300) ? body : String();
+  }
+
+  bool remove(AsyncClientClass& client, const String& path) {
+    return write(client, "DELETE", path, std::string());
+  }
+
+private:
+  bool write(AsyncClientClass& client, const char* method, const String& path, const std::string& body) {
+    String response;
+    int status = client.request(method, path, body, response);
+    return status >= 200 && status < 300;
+  }
+
+  static std::string toJson(const object_t& v) { return v.c_str(); }
+  static std::string toJson(bool v) { return v ? "true" : "false"; }
+  static std::string toJson(int v) { return std::to_string(v); }
+  static std::string toJson(unsigned v) { return std::to_string(v); }
+  static std::string toJson(long v) { return std::to_string(v); }
+  static std::string toJson(unsigned long v) { return std::to_string(v); }
+  static std::string toJson(float v) { return String((double)v, 3).c_str(); }
+  static std::string toJson(double v) { return String(v, 6).c_str(); }
+  static std::string toJson(const String& v);
+  static std::string toJson(const char* v) { return toJson(String(v)); }
+};
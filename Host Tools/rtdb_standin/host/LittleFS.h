@@ -0,0 +1,14 @@
+#pragma once
+#include "FS.h"
+
+class LittleFSFS : public fs::FS {
+public:
+  // Root directory = $RTDB_BENCH_FS (default ./bench_fs), created on begin()
+  bool begin(bool formatOnFail = false, const char* basePath = "/littlefs",
+             uint8_t maxOpenFiles = 10, const char* partitionLabel = "spiffs");
+  bool format();
+  size_t totalBytes() { return 1536 * 1024; }
+  size_t usedBytes();
+};
+
+extern LittleFSFS LittleFS;
@@ -0,0 +1,38 @@
+#pragma once
+#include <stddef.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include <vector>
+
+// In-memory NVS: values live for the run only (the bench restarts clean)
+class Preferences {
+public:
+  bool begin(const char* name, bool readOnly = false) { ns_ = name ? name : ""; (void)readOnly; return true; }
+  void end() {}
+
+  size_t putBytes(const char* key, const void* value, size_t len) {
+    const uint8_t* p = (const uint8_t*)value;
+    store()[ns_ + "/" + key].assign(p, p + len);
+    return len;
+  }
+  size_t getBytes(const char* key, void* buf, size_t maxLen) {
+    auto it = store().find(ns_ + "/" + key);
+    if (it == store().end() || it->second.size() > maxLen) return 0;
+    memcpy(buf, it->second.data(), it->second.size());
+    return it->second.size();
+  }
+  size_t getBytesLength(const char* key) {
+    auto it = store().find(ns_ + "/" + key);
+    return it == store().end() ? 0 : it->second.size();
+  }
+  bool isKey(const char* key) { return store().count(ns_ + "/" + key) != 0; }
+  bool remove(const char* key) { return store().erase(ns_ + "/" + key) != 0; }
+
+private:
+  static std::map<std::string, std::vector<uint8_t>>& store() {
+    static std::map<std::string, std::vector<uint8_t>> s;
+    return s;
+  }
+  std::string ns_;
+};
@@ -0,0 +1,12 @@
+#ifndef SECRETS_H
+#define SECRETS_H
+
+// Host build: credentials are not used (the stand-in ignores auth) and the
+// database address comes from RTDB_HOST / RTDB_PORT (see FirebaseClient.h).
+constexpr const char* AP_PASS = "";
+#define Web_API_KEY     "host"
+#define DATABASE_URL    "http://127.0.0.1:9000"
+#define USER_EMAIL      "host@localhost"
+#define USER_PASS       "host"
+#define FIREBASE_ROOT_CA ""
+#endif
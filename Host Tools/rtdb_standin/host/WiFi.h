@@ -0,0 +1,13 @@
+#pragma once
+#include "Arduino.h"
+
+// The host is always "connected"
+typedef enum { WL_IDLE_STATUS = 0, WL_CONNECTED = 3, WL_DISCONNECTED = 6 } wl_status_t;
+
+class WiFiClass {
+public:
+  wl_status_t status() { return WL_CONNECTED; }
+  int8_t RSSI() { return -50; }
+};
+
+extern WiFiClass WiFi;
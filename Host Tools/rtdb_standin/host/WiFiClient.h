@@ -0,0 +1,36 @@
+#pragma once
+#include "Arduino.h"
+
+class Client : public Stream {
+public:
+  virtual int connect(const char* host, uint16_t port) = 0;
+  virtual void stop() = 0;
+  virtual uint8_t connected() = 0;
+};
+
+// Plain TCP socket
+class WiFiClient : public Client {
+public:
+  WiFiClient() {}
+  ~WiFiClient() override { stop(); }
+  WiFiClient(const WiFiClient&) = delete;
+  WiFiClient& operator=(const WiFiClient&) = delete;
+
+  using Print::write;
+  int connect(const char* host, uint16_t port) override;
+  void stop() override;
+  uint8_t connected() override;
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t* buf, size_t n) override;
+  int available() override;
+  int read() override;
+  int peek() override;
+  int read(uint8_t* buf, size_t n);
+  void setTimeout(unsigned long ms) { timeoutMs_ = ms; Stream::setTimeout(ms); }
+
+protected:
+  bool waitReadable(unsigned long ms);
+  int fd_ = -1;
+  int peeked_ = -1;
+  unsigned long timeoutMs_ = 5000;
+};
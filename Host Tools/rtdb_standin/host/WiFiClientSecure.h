@@ -0,0 +1,12 @@
+#pragma once
+#include "WiFiClient.h"
+
+// No TLS on the host: the stand-in speaks plain HTTP. connect() still marks
+// the point where the ESP32 would do a full handshake, so the firmware's
+// handshake metering keeps counting reconnects.
+class WiFiClientSecure : public WiFiClient {
+public:
+  void setInsecure() {}
+  void setCACert(const char*) {}
+  void setHandshakeTimeout(unsigned long) {}
+};
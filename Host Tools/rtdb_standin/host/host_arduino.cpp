@@ -0,0 +1,204 @@
+// Arduino core pieces for the host build (String, Serial, time, ESP, WiFi)
+#include "Arduino.h"
+
+#include <chrono>
+#include <random>
+#include <thread>
+
+#include "WiFi.h"
+
+HardwareSerial Serial;
+EspClass ESP;
+WiFiClass WiFi;
+
+// ---------------- time ----------------
+static const auto g_start = std::chrono::steady_clock::now();
+static unsigned long g_offsetMs = 0;
+
+unsigned long millis() {
+  using namespace std::chrono;
+  return (unsigned long)duration_cast<milliseconds>(steady_clock::now() - g_start).count() + g_offsetMs;
+}
+
+unsigned long micros() {
+  using namespace std::chrono;
+  return (unsigned long)duration_cast<microseconds>(steady_clock::now() - g_start).count() +
+         g_offsetMs * 1000UL;
+}
+
+void hostClockAdvance(unsigned long ms) {
+  g_offsetMs += ms;
+}
+
+void delay(unsigned long ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void yield() {}
+
+uint32_t esp_random() {
+  static std::mt19937 rng(std::random_device{}());
+  return rng();
+}
+
+uint32_t EspClass::getCycleCount() {
+  return (uint32_t)(micros() * 240UL);
+}
+
+bool getLocalTime(struct tm* info, uint32_t) {
+  time_t now = time(nullptr);
+  localtime_r(&now, info);
+  return true;
+}
+
+#if defined(__GLIBC__) && (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38)
+size_t strlcpy(char* dst, const char* src, size_t size) {
+  size_t len = strlen(src);
+  if (size > 0) {
+    size_t n = (len < size - 1) ? len : size - 1;
+    memcpy(dst, src, n);
+    dst[n] = '\0';
+  }
+  return len;
+}
+#endif
+
+// ---------------- String ----------------
+String::String(double v, unsigned decimals) {
+  char buf[64];
+  snprintf(buf, sizeof(buf), "%.*f", (int)decimals, v);
+  s_ = buf;
+}
+
+int String::indexOf(char c, unsigned from) const {
+  size_t p = s_.find(c, from);
+  return p == std::string::npos ? -1 : (int)p;
+}
+
+int String::indexOf(const String& o, unsigned from) const {
+  size_t p = s_.find(o.s_, from);
+  return p == std::string::npos ? -1 : (int)p;
+}
+
+String String::substring(unsigned from) const {
+  return from >= s_.size() ? String() : String(s_.substr(from));
+}
+
+String String::substring(unsigned from, unsigned to) const {
+  if (from > to) std::swap(from, to);
+  if (from >= s_.size()) return String();
+  return String(s_.substr(from, to - from));
+}
+
+bool String::endsWith(const String& o) const {
+  return s_.size() >= o.s_.size() && s_.compare(s_.size() - o.s_.size(), o.s_.size(), o.s_) == 0;
+}
+
+void String::trim() {
+  size_t b = s_.find_first_not_of(" \t\r\n");
+  size_t e = s_.find_last_not_of(" \t\r\n");
+  s_ = (b == std::string::npos) ? std::string() : s_.substr(b, e - b + 1);
+}
+
+void String::toLowerCase() {
+  for (auto& c : s_) c = (char)tolower((unsigned char)c);
+}
+
+void String::remove(unsigned index, unsigned count) {
+  if (index < s_.size()) s_.erase(index, count);
+}
+
+StringSumHelper operator+(const String& a, const String& b) {
+  String r(a);
+  r += b;
+  return r;
+}
+
+StringSumHelper operator+(const String& a, const char* b) {
+  String r(a);
+  r += b;
+  return r;
+}
+
+StringSumHelper operator+(const char* a, const String& b) {
+  String r(a);
+  r += b;
+  return r;
+}
+
+// ---------------- Print / Stream ----------------
+size_t Print::write(const uint8_t* buf, size_t n) {
+  size_t done = 0;
+  while (done < n && write(buf[done])) done++;
+  return done;
+}
+
+int Print::printf(const char* fmt, ...) {
+  char small[256];
+  va_list ap;
+  va_start(ap, fmt);
+  int len = vsnprintf(small, sizeof(small), fmt, ap);
+  va_end(ap);
+  if (len < 0) return len;
+
+  if ((size_t)len < sizeof(small)) return (int)write((const uint8_t*)small, (size_t)len);
+
+  std::string big((size_t)len + 1, '\0');
+  va_start(ap, fmt);
+  vsnprintf(&big[0], big.size(), fmt, ap);
+  va_end(ap);
+  return (int)write((const uint8_t*)big.data(), (size_t)len);
+}
+
+int Stream::timedRead() {
+  unsigned long start = millis();
+  do {
+    int c = read();
+    if (c >= 0) return c;
+    if (timeoutMs_ == 0) break;
+    delay(1);
+  } while (millis() - start < timeoutMs_);
+  return -1;
+}
+
+size_t Stream::readBytes(char* buf, size_t n) {
+  size_t i = 0;
+  while (i < n) {
+    int c = timedRead();
+    if (c < 0) break;
+    buf[i++] = (char)c;
+  }
+  return i;
+}
+
+size_t Stream::readBytesUntil(char term, char* buf, size_t n) {
+  size_t i = 0;
+  while (i < n) {
+    int c = timedRead();
+    if (c < 0 || c == term) break;
+    buf[i++] = (char)c;
+  }
+  return i;
+}
+
+String Stream::readString() {
+  std::string s;
+  int c;
+  while ((c = timedRead()) >= 0) s += (char)c;
+  return String(s);
+}
+
+String Stream::readStringUntil(char term) {
+  std::string s;
+  int c;
+  while ((c = timedRead()) >= 0 && c != term) s += (char)c;
+  return String(s);
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+  return quiet_ ? 1 : fwrite(&c, 1, 1, stdout);
+}
+
+size_t HardwareSerial::write(const uint8_t* buf, size_t n) {
+  return quiet_ ? n : fwrite(buf, 1, n, stdout);
+}
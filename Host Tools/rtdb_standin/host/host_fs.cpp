@@ -0,0 +1,164 @@
+// LittleFS on the host: "/x" maps to $RTDB_BENCH_FS/x (default ./bench_fs/x)
+#include "LittleFS.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+LittleFSFS LittleFS;
+
+namespace fs {
+
+struct HostFile {
+  FILE* fp = nullptr;
+  std::string path; // device path ("/weights_queue.bin")
+  ~HostFile() {
+    if (fp) fclose(fp);
+  }
+};
+
+size_t File::write(uint8_t c) {
+  return write(&c, 1);
+}
+
+size_t File::write(const uint8_t* buf, size_t n) {
+  return (f_ && f_->fp) ? fwrite(buf, 1, n, f_->fp) : 0;
+}
+
+int File::available() {
+  if (!f_ || !f_->fp) return 0;
+  long pos = ftell(f_->fp);
+  return (int)(size() - (size_t)pos);
+}
+
+int File::read() {
+  if (!f_ || !f_->fp) return -1;
+  int c = fgetc(f_->fp);
+  return c == EOF ? -1 : c;
+}
+
+int File::peek() {
+  if (!f_ || !f_->fp) return -1;
+  int c = fgetc(f_->fp);
+  if (c == EOF) return -1;
+  ungetc(c, f_->fp);
+  return c;
+}
+
+size_t File::read(uint8_t* buf, size_t n) {
+  return (f_ && f_->fp) ? fread(buf, 1, n, f_->fp) : 0;
+}
+
+void File::flush() {
+  if (f_ && f_->fp) fflush(f_->fp);
+}
+
+bool File::seek(uint32_t pos, SeekMode mode) {
+  if (!f_ || !f_->fp) return false;
+  int whence = (mode == SeekCur) ? SEEK_CUR : (mode == SeekEnd) ? SEEK_END : SEEK_SET;
+  return fseek(f_->fp, (long)pos, whence) == 0;
+}
+
+size_t File::position() const {
+  return (f_ && f_->fp) ? (size_t)ftell(f_->fp) : 0;
+}
+
+size_t File::size() const {
+  if (!f_ || !f_->fp) return 0;
+  fflush(f_->fp);
+  struct stat st;
+  return fstat(fileno(f_->fp), &st) == 0 ? (size_t)st.st_size : 0;
+}
+
+void File::close() {
+  if (f_ && f_->fp) {
+    fclose(f_->fp);
+    f_->fp = nullptr;
+  }
+  f_.reset();
+}
+
+File::operator bool() const {
+  return f_ && f_->fp;
+}
+
+const char* File::name() const {
+  if (!f_) return "";
+  size_t slash = f_->path.rfind('/');
+  return f_->path.c_str() + (slash == std::string::npos ? 0 : slash + 1);
+}
+
+const char* File::path() const {
+  return f_ ? f_->path.c_str() : "";
+}
+
+std::string FS::hostPath(const char* path) const {
+  std::string p = path ? path : "";
+  if (p.empty() || p[0] != '/') p = "/" + p;
+  return root_ + p;
+}
+
+File FS::open(const char* path, const char* mode, bool) {
+  std::string m = mode ? mode : "r";
+  if (m == "r") m = "rb";
+  else if (m == "w") m = "wb";
+  else if (m == "a") m = "ab";
+
+  FILE* fp = fopen(hostPath(path).c_str(), m.c_str());
+  if (!fp) return File();
+
+  auto f = std::make_shared<HostFile>();
+  f->fp = fp;
+  f->path = path;
+  File file(f);
+  file.setTimeout(0); // a file never "waits" for more data: EOF is final
+  return file;
+}
+
+bool FS::exists(const char* path) {
+  struct stat st;
+  return stat(hostPath(path).c_str(), &st) == 0;
+}
+
+bool FS::remove(const char* path) {
+  return unlink(hostPath(path).c_str()) == 0;
+}
+
+bool FS::rename(const char* from, const char* to) {
+  return ::rename(hostPath(from).c_str(), hostPath(to).c_str()) == 0;
+}
+
+bool FS::mkdir(const char* path) {
+  return ::mkdir(hostPath(path).c_str(), 0755) == 0 || errno == EEXIST;
+}
+
+} // namespace fs
+
+bool LittleFSFS::begin(bool, const char*, uint8_t, const char*) {
+  const char* dir = getenv("RTDB_BENCH_FS");
+  root_ = (dir && *dir) ? dir : "bench_fs";
+  return ::mkdir(root_.c_str(), 0755) == 0 || errno == EEXIST;
+}
+
+bool LittleFSFS::format() {
+  DIR* d = opendir(root_.c_str());
+  if (!d) return false;
+  while (struct dirent* e = readdir(d)) {
+    if (e->d_type == DT_REG) unlink((root_ + "/" + e->d_name).c_str());
+  }
+  closedir(d);
+  return true;
+}
+
+size_t LittleFSFS::usedBytes() {
+  size_t total = 0;
+  DIR* d = opendir(root_.c_str());
+  if (!d) return 0;
+  while (struct dirent* e = readdir(d)) {
+    struct stat st;
+    if (stat((root_ + "/" + e->d_name).c_str(), &st) == 0 && S_ISREG(st.st_mode)) total += (size_t)st.st_size;
+  }
+  closedir(d);
+  return total;
+}
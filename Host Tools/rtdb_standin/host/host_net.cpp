@@ -0,0 +1,367 @@
+// Network pieces for the host build: plain TCP WiFiClient and the
+// FirebaseClient request path (HTTP/1.1 keep-alive to the RTDB stand-in,
+// SSE for streams)
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "FirebaseClient.h"
+#include "WiFiClientSecure.h"
+
+// ---------------- WiFiClient ----------------
+int WiFiClient::connect(const char* host, uint16_t port) {
+  stop();
+
+  addrinfo hints{};
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* res = nullptr;
+  char portStr[8];
+  snprintf(portStr, sizeof(portStr), "%u", (unsigned)port);
+  if (getaddrinfo(host, portStr, &hints, &res) != 0 || !res) return 0;
+
+  int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+  if (fd >= 0 && ::connect(fd, res->ai_addr, res->ai_addrlen) != 0) {
+    ::close(fd);
+    fd = -1;
+  }
+  freeaddrinfo(res);
+  if (fd < 0) return 0;
+
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  fd_ = fd;
+  peeked_ = -1;
+  return 1;
+}
+
+void WiFiClient::stop() {
+  if (fd_ >= 0) ::close(fd_);
+  fd_ = -1;
+  peeked_ = -1;
+}
+
+uint8_t WiFiClient::connected() {
+  if (fd_ < 0) return 0;
+  if (peeked_ >= 0) return 1;
+  // closed by the peer? (readable with 0 bytes)
+  pollfd p{fd_, POLLIN, 0};
+  if (poll(&p, 1, 0) > 0) {
+    char c;
+    ssize_t n = recv(fd_, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+    if (n == 0) {
+      stop();
+      return 0;
+    }
+  }
+  return 1;
+}
+
+size_t WiFiClient::write(const uint8_t* buf, size_t n) {
+  if (fd_ < 0) return 0;
+  size_t off = 0;
+  while (off < n) {
+    ssize_t w = send(fd_, buf + off, n - off, MSG_NOSIGNAL);
+    if (w <= 0) {
+      stop();
+      return off;
+    }
+    off += (size_t)w;
+  }
+  return off;
+}
+
+bool WiFiClient::waitReadable(unsigned long ms) {
+  if (fd_ < 0) return false;
+  pollfd p{fd_, POLLIN, 0};
+  return poll(&p, 1, (int)ms) > 0;
+}
+
+int WiFiClient::available() {
+  if (fd_ < 0) return 0;
+  int n = (peeked_ >= 0) ? 1 : 0;
+  if (waitReadable(0)) n++;
+  return n;
+}
+
+int WiFiClient::read() {
+  if (peeked_ >= 0) {
+    int c = peeked_;
+    peeked_ = -1;
+    return c;
+  }
+  uint8_t c;
+  return (read(&c, 1) == 1) ? c : -1;
+}
+
+int WiFiClient::read(uint8_t* buf, size_t n) {
+  if (fd_ < 0 || n == 0) return -1;
+  size_t off = 0;
+  if (peeked_ >= 0) {
+    buf[off++] = (uint8_t)peeked_;
+    peeked_ = -1;
+    if (off == n) return (int)off;
+  }
+  if (!waitReadable(timeoutMs_)) return off ? (int)off : -1;
+  ssize_t r = recv(fd_, buf + off, n - off, 0);
+  if (r <= 0) {
+    stop();
+    return off ? (int)off : -1;
+  }
+  return (int)(off + (size_t)r);
+}
+
+int WiFiClient::peek() {
+  if (peeked_ < 0) peeked_ = read();
+  return peeked_;
+}
+
+// ---------------- FirebaseClient ----------------
+static user_auth_data g_authData;
+
+user_auth_data& getAuth(UserAuth&) {
+  return g_authData;
+}
+
+void initializeApp(AsyncClientClass&, FirebaseApp& app, user_auth_data&, AsyncResultCallback, const String&) {
+  app.setReady();
+}
+
+static const char* envOr(const char* name, const char* fallback) {
+  const char* v = getenv(name);
+  return (v && *v) ? v : fallback;
+}
+
+static const std::string& authQuery() {
+  static std::string q;
+  if (q.empty()) {
+    int n = atoi(envOr("RTDB_AUTH_BYTES", "950"));
+    q = "?auth=" + std::string(n > 0 ? (size_t)n : 0, 'x');
+  }
+  return q;
+}
+
+// Reads "\r\n"-terminated line; false on timeout/close
+static bool readLine(Client& c, std::string& line) {
+  line.clear();
+  for (;;) {
+    int ch = c.read();
+    if (ch < 0) return false;
+    if (ch == '\n') {
+      if (!line.empty() && line.back() == '\r') line.pop_back();
+      return true;
+    }
+    line += (char)ch;
+  }
+}
+
+static int sendAndReceive(Client& client, const std::string& req, String& response, bool& keepAlive) {
+  if (client.write((const uint8_t*)req.data(), req.size()) != req.size()) return -1;
+
+  std::string line;
+  if (!readLine(client, line)) return -2; // no answer (stale keep-alive / timeout)
+
+  int status = 0;
+  if (sscanf(line.c_str(), "HTTP/%*s %d", &status) != 1) return -3;
+
+  size_t contentLength = 0;
+  keepAlive = true;
+  while (readLine(client, line) && !line.empty()) {
+    std::string lower;
+    for (char ch : line) lower += (char)tolower((unsigned char)ch);
+    if (lower.compare(0, 15, "content-length:") == 0) contentLength = (size_t)strtoul(line.c_str() + 15, nullptr, 10);
+    if (lower.compare(0, 11, "connection:") == 0 && lower.find("close") != std::string::npos) keepAlive = false;
+  }
+
+  std::string body(contentLength, '\0');
+  size_t got = 0;
+  while (got < contentLength) {
+    int ch = client.read();
+    if (ch < 0) return -3;
+    body[got++] = (char)ch;
+  }
+  response = String(body);
+  return status;
+}
+
+int AsyncClientClass::request(const char* method, const String& path, const std::string& body, String& response) {
+  static const std::string host = envOr("RTDB_HOST", "127.0.0.1");
+  static const uint16_t port = (uint16_t)atoi(envOr("RTDB_PORT", "9000"));
+
+  std::string p = path.c_str();
+  if (p.empty() || p[0] != '/') p = "/" + p;
+  while (p.size() > 1 && p.back() == '/') p.pop_back();
+
+  const std::string target = (p == "/") ? "/.json" : p + ".json";
+  std::string req = std::string(method) + " " + target + authQuery() + " HTTP/1.1\r\n";
+  req +="Host: " + host + "\r\n";
+  req += "Connection: keep-alive\r\n";
+  req += "Content-Type: application/json\r\n";
+  req += "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n";
+  req += body;
+
+  response = String();
+  for (int attempt = 0; attempt < 2; attempt++) { // one retry on a stale keep-alive connection
+    if (!client_.connected() && !client_.connect(host.c_str(), port)) {
+      error_.set(-1, "TCP connection failed");
+      return -1;
+    }
+
+    bool keepAlive = true;
+    int status = sendAndReceive(client_, req, response, keepAlive);
+    if (!keepAlive || status < 0) client_.stop();
+    if (status == -1 || status == -2) continue;
+
+    if (status < 0) {
+      error_.set(status, "bad response");
+    } else if (status >= 200 && status < 300) {
+      error_.set(0, "");
+    } else {
+      error_.set(status, response);
+    }
+    return status;
+  }
+
+  error_.set(-2, "no response");
+  return -2;
+}
+
+std::string RealtimeDatabase::toJson(const String& v) {
+  std::string out = "\"";
+  for (const char* s = v.c_str(); *s; s++) {
+    char c = *s;
+    if (c == '"' || c == '\\') {
+      out += '\\';
+      out += c;
+    } else if ((unsigned char)c < 0x20) {
+      char buf[8];
+      snprintf(buf, sizeof(buf), "\\u%04x", c);
+      out += buf;
+    } else {
+      out += c;
+    }
+  }
+  return out + "\"";
+}
+
+// ---------------- Streams (SSE) ----------------
+static std::vector<AsyncClientClass*> g_streams;
+
+void hostPollStreams() {
+  for (AsyncClientClass* c : g_streams) c->pollStream();
+}
+
+bool AsyncClientClass::connectStream() {
+  static const std::string host = envOr("RTDB_HOST", "127.0.0.1");
+  static const uint16_t port = (uint16_t)atoi(envOr("RTDB_PORT", "9000"));
+
+  std::string p = streamPath_.c_str();
+  if (p.empty() || p[0] != '/') p = "/" + p;
+  std::string req = "GET " + p + ".json" + authQuery() + " HTTP/1.1\r\n";
+  req += "Host: " + host + "\r\n";
+  req += "Accept: text/event-stream\r\n";
+  req += "Connection: keep-alive\r\n\r\n";
+
+  streamBuf_.clear();
+  streamHeadersDone_ = false;
+  if (!client_.connect(host.c_str(), port)) return false;
+  return client_.write((const uint8_t*)req.data(), req.size()) == req.size();
+}
+
+void AsyncClientClass::openStream(const String& path, AsyncResultCallback cb, const String& uid) {
+  stopAsync();
+  streamPath_ = path;
+  streamUid_ = uid;
+  streamCb_ = cb;
+  g_streams.push_back(this);
+  (void)connectStream();
+}
+
+void AsyncClientClass::stopAsync() {
+  g_streams.erase(std::remove(g_streams.begin(), g_streams.end(), this), g_streams.end());
+  streamCb_ = nullptr;
+  client_.stop();
+}
+
+// "{"path":"/x","data":...}" -> path + raw data JSON
+static void splitStreamData(const std::string& json, std::string& path, std::string& data) {
+  path = "/";
+  data = "null";
+  size_t p = json.find("\"path\":\"");
+  if (p != std::string::npos) {
+    size_t start = p + 8;
+    size_t end = json.find('"', start);
+    if (end != std::string::npos) path = json.substr(start, end - start);
+  }
+  size_t d = json.find("\"data\":");
+  if (d != std::string::npos && json.size() > d + 7) {
+    data = json.substr(d + 7);
+    if (!data.empty() && data.back() == '}') data.pop_back();
+  }
+}
+
+void AsyncClientClass::pollStream() {
+  if (!streamCb_) return;
+
+  if (!client_.connected()) { // dropped -> reconnect like the library does
+    if (!connectStream()) {
+      AsyncResult r;
+      r.setError(streamUid_, -1, "stream connection failed");
+      streamCb_(r);
+      return;
+    }
+  }
+
+  while (client_.available() > 0) {
+    int ch = client_.read();
+    if (ch < 0) break;
+    streamBuf_ += (char)ch;
+  }
+
+  if (!streamHeadersDone_) {
+    size_t end = streamBuf_.find("\r\n\r\n");
+    if (end == std::string::npos) return;
+    int status = 0;
+    sscanf(streamBuf_.c_str(), "HTTP/%*s %d", &status);
+    streamBuf_.erase(0, end + 4);
+    streamHeadersDone_ = true;
+    if (status != 200) {
+      client_.stop();
+      AsyncResult r;
+      r.setError(streamUid_, status, "stream rejected");
+      streamCb_(r);
+      return;
+    }
+  }
+
+  size_t end;
+  while (streamCb_ && (end = streamBuf_.find("\n\n")) != std::string::npos) {
+    std::string block = streamBuf_.substr(0, end);
+    streamBuf_.erase(0, end + 2);
+
+    std::string event, payload;
+    size_t pos = 0;
+    while (pos <= block.size()) {
+      size_t nl = block.find('\n', pos);
+      std::string line = block.substr(pos, nl == std::string::npos ? std::string::npos : nl - pos);
+      if (line.compare(0, 7, "event: ") == 0) event = line.substr(7);
+      if (line.compare(0, 6, "data: ") == 0) payload = line.substr(6);
+      if (nl == std::string::npos) break;
+      pos = nl + 1;
+    }
+
+    std::string path = "/", data = payload;
+    if (event == "put" || event == "patch") splitStreamData(payload, path, data);
+
+    AsyncResult r;
+    r.setStreamEvent(streamUid_, String(event), String(path), String(data));
+    streamCb_(r);
+  }
+}
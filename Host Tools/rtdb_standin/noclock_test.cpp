@@ -0,0 +1,112 @@
+// noclock_test.cpp
+//
+// Runs the firmware's no-clock feed log (LocalManager from ../../ESP32) on
+// Linux and checks the /weights records it queues once the clock is valid:
+// the fields the app reads and the "eaten" it computes from them
+// (stats_provider.dart: prev_current_weight - new_current_weight, >= 0).
+//
+// Cases:
+//   no reading   : bowl after the feed only -> nothing eaten yet
+//   readings     : eating session + next feed logged under the feed's event
+//                  key -> the last one is the later weight
+//   other event  : a reading for another feed does not touch the record
+//   after queued : no more log readings; the live path gets the same time
+//
+// Usage: noclock_test [--verbose]   (exit code 1 on a failed check)
+
+#include <string.h>
+#include <time.h>
+
+#include <string>
+#include <vector>
+
+#include "Arduino.h"
+#include "LittleFS.h"
+#include "EventIdManager.h"
+#include "LocalManager.h"
+
+static std::vector<WeightQueueRecord> g_uploaded;
+static int g_failures = 0;
+
+static bool captureBatch(const WeightQueueRecord* records, size_t count) {
+  g_uploaded.insert(g_uploaded.end(), records, records + count);
+  return true;
+}
+
+static const WeightQueueRecord* uploaded(uint64_t eventId) {
+  char key[sizeof(((WeightQueueRecord*)0)->key)];
+  eventIdToKey(eventId, key, sizeof(key));
+  for (const WeightQueueRecord& r : g_uploaded) {
+    if (strcmp(r.key, key) == 0) return &r;
+  }
+  return nullptr;
+}
+
+// what the app shows as eaten: the record holds whole grams (fillWeightRecord)
+static long appEaten(float prevWeight, float currentWeight) {
+  const long eaten = lroundf(prevWeight) - lroundf(currentWeight);
+  return eaten < 0 ? 0 : eaten;
+}
+
+static void check(bool ok, const char* what) {
+  printf("%s %s\n", ok ? "ok  " : "FAIL", what);
+  if (!ok) g_failures++;
+}
+
+int main(int argc, char** argv) {
+  Serial.setQuiet(!(argc > 1 && strcmp(argv[1], "--verbose") == 0));
+
+  // fresh "flash" for every run
+  LittleFS.begin(true);
+  LittleFS.format();
+  initLocalStorage();
+  initEventIds(7);
+  localNoClockBegin(7);
+
+  // three feeds before the clock is valid (20 g in, bowl 12 -> 52 g etc.)
+  const uint64_t plain = eventIdNext();
+  (void)localLogNoClockFeed(plain, millis(), 40, 12.0f, 52.0f, "Breakfast");
+  hostClockAdvance(60UL * 60UL * 1000UL);
+
+  const uint64_t eaten = eventIdNext();
+  const uint32_t eatenStartMs = millis();
+  (void)localLogNoClockFeed(eaten, eatenStartMs, 40, 10.0f, 50.0f, "Lunch");
+  check(localLogNoClockReading(eaten, 35.0f), "reading logged while the feed is in the log");
+  check(localLogNoClockReading(eaten, 30.0f), "second reading logged");
+  hostClockAdvance(60UL * 60UL * 1000UL);
+
+  const uint64_t other = eventIdNext();
+  (void)localLogNoClockFeed(other, millis(), 40, 30.0f, 70.0f, "Dinner");
+  (void)localLogNoClockReading(eaten, 1.0f);   // stale: not the feed before it
+
+  // clock valid -> records queued -> uploaded
+  localNoClockTick(true);
+  (void)localQueueCommit();
+  check(localFlushWeightsQueueBatched(captureBatch), "queue flushed");
+
+  const WeightQueueRecord* r = uploaded(plain);
+  check(r && r->prevWeight == 52.0f && r->currentWeight == 52.0f,
+        "no reading: prev = current = bowl after the feed");
+  check(r && appEaten(r->prevWeight, r->currentWeight) == 0, "no reading: eaten 0 g");
+
+  r = uploaded(eaten);
+  check(r && r->prevWeight == 50.0f && r->currentWeight == 30.0f,
+        "readings: prev = bowl after the feed, current = last reading");
+  check(r && appEaten(r->prevWeight, r->currentWeight) == 20, "readings: eaten 20 g");
+
+  r = uploaded(other);
+  check(r && appEaten(r->prevWeight, r->currentWeight) == 0, "other event: eaten 0 g");
+
+  // queued: readings now go the live way, with the record's own time
+  check(!localLogNoClockReading(eaten, 25.0f), "no log reading once queued");
+  int hour = -1, minute = -1;
+  char day[10], date[11];
+  r = uploaded(eaten);
+  check(localNoClockFeedTime(eatenStartMs, hour, minute, day, sizeof(day), date, sizeof(date)) &&
+        r && hour == r->feedHour && minute == r->feedMinute &&
+        strcmp(day, r->day) == 0 && strcmp(date, r->dateISO) == 0,
+        "live path gets the queued record's time");
+
+  printf("%s (%d failed)\n", g_failures ? "FAILED" : "passed", g_failures);
+  return g_failures ? 1 : 0;
+}
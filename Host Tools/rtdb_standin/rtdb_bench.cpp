@@ -0,0 +1,206 @@
+// rtdb_bench.cpp
+//
+// Runs the firmware's own network code (FirebaseManager, LocalManager,
+// EventIdManager, CloudHealthManager from ../../ESP32) on Linux against the
+// RTDB stand-in and reports what the device would send per operation.
+//
+// Phases:
+//   poll  : firebaseLoop() every (virtual) 15 s with an unchanged schedule
+//   feed  : one normal meal = "feeding_started" + "feeding_success"
+//           notifications + the /weights record
+//   flush : --queued offline records flushed with the batched uploader
+//
+// Counts come from the stand-in's /.stats (requests, bytes both ways) plus
+// the firmware's own TLS (connect) and cloud-health counters.
+//
+// Usage: rtdb_bench [--port N] [--feeds N] [--polls N] [--queued N]
+//                   [--latency-ms N] [--error-rate P] [--verbose]
+// (start ./rtdb_standin --seed seed.json first; same --port)
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <string>
+
+#include "Arduino.h"
+#include "LittleFS.h"
+#include "CloudHealthManager.h"
+#include "EventIdManager.h"
+#include "FirebaseManager.h"
+#include "LocalManager.h"
+
+// ---------------- stand-in control channel (outside the firmware's client) ----------------
+static int g_port = 9000;
+
+static std::string controlGet(const std::string& target) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in a{};
+  a.sin_family = AF_INET;
+  a.sin_port = htons((uint16_t)g_port);
+  a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (fd < 0 || connect(fd, (sockaddr*)&a, sizeof(a)) != 0) {
+    if (fd >= 0) close(fd);
+    return "";
+  }
+  std::string req = "GET " + target + " HTTP/1.1\r\nHost: 127.0.0.1\r\nConnection: close\r\n\r\n";
+  send(fd, req.data(), req.size(), MSG_NOSIGNAL);
+
+  std::string resp;
+  char buf[2048];
+  ssize_t n;
+  while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) resp.append(buf, (size_t)n);
+  close(fd);
+
+  size_t body = resp.find("\r\n\r\n");
+  return body == std::string::npos ? "" : resp.substr(body + 4);
+}
+
+// tiny lookup of a top-level numeric field in the stats JSON
+static unsigned long long statField(const std::string& json, const char* key) {
+  std::string k = std::string("\"") + key + "\":";
+  size_t p = json.find(k);
+  return p == std::string::npos ? 0 : strtoull(json.c_str() + p + k.size(), nullptr, 10);
+}
+
+// ---------------- measurement ----------------
+struct PhaseResult {
+  const char* name;
+  int ops;
+  unsigned long long requests;
+  unsigned long long bytesUp;    // device -> server
+  unsigned long long bytesDown;  // server -> device
+  unsigned long long errors;     // injected by the stand-in
+  uint32_t connects;             // TLS handshakes on the device
+  double wallMs;
+};
+
+static FirebaseTlsStats g_tlsBefore;
+static std::chrono::steady_clock::time_point g_t0;
+
+static void phaseBegin() {
+  controlGet("/.stats?reset=1");
+  firebaseGetTlsStats(g_tlsBefore);
+  g_t0 = std::chrono::steady_clock::now();
+}
+
+static PhaseResult phaseEnd(const char* name, int ops) {
+  PhaseResult r;
+  r.wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - g_t0).count();
+  std::string s = controlGet("/.stats");
+  FirebaseTlsStats tls;
+  firebaseGetTlsStats(tls);
+
+  r.name = name;
+  r.ops = ops;
+  r.requests = statField(s, "requests");
+  r.bytesUp = statField(s, "bytes_in");
+  r.bytesDown = statField(s, "bytes_out");
+  r.errors = statField(s, "injected_errors");
+  r.connects = tls.handshakes - g_tlsBefore.handshakes;
+  return r;
+}
+
+static void printResult(const PhaseResult& r) {
+  const double ops = r.ops > 0 ? (double)r.ops : 1.0;
+  printf("%-6s %5d ops | req/op %6.2f | up B/op %8.0f | down B/op %8.0f | ms/op %8.2f | connects %3u | errors %llu\n",
+         r.name, r.ops, r.requests / ops, r.bytesUp / ops, r.bytesDown / ops, r.wallMs / ops,
+         (unsigned)r.connects, r.errors);
+}
+
+// ---------------- main ----------------
+int main(int argc, char** argv) {
+  int feeds = 20;
+  int polls = 40;
+  int queued = 32;
+  int latencyMs = 0;
+  double errorRate = 0.0;
+  bool verbose = false;
+
+  for (int i = 1; i < argc; i++) {
+    std::string a = argv[i];
+    auto next = [&]() -> const char* { return (i + 1 < argc) ? argv[++i] : "0"; };
+    if (a == "--port") g_port = atoi(next());
+    else if (a == "--feeds") feeds = atoi(next());
+    else if (a == "--polls") polls = atoi(next());
+    else if (a == "--queued") queued = atoi(next());
+    else if (a == "--latency-ms") latencyMs = atoi(next());
+    else if (a == "--error-rate") errorRate = atof(next());
+    else if (a == "--verbose") verbose = true;
+    else {
+      fprintf(stderr, "usage: %s [--port N] [--feeds N] [--polls N] [--queued N] "
+                      "[--latency-ms N] [--error-rate P] [--verbose]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  char portStr[8];
+  snprintf(portStr, sizeof(portStr), "%d", g_port);
+  setenv("RTDB_PORT", portStr, 0);
+
+  if (controlGet("/.stats").empty()) {
+    fprintf(stderr, "stand-in not reachable on 127.0.0.1:%d (start ./rtdb_standin first)\n", g_port);
+    return 1;
+  }
+
+  char control[96];
+  snprintf(control, sizeof(control), "/.control?latency_ms=%d&error_rate=%.3f", latencyMs, errorRate);
+  controlGet(control);
+
+  Serial.setQuiet(!verbose);
+
+  // fresh "flash" for every run
+  LittleFS.begin(true);
+  LittleFS.format();
+  initLocalStorage();
+  initEventIds(1);
+  initFirebase();
+
+  // ---- first schedule download (not part of a phase) ----
+  firebaseLoop();
+
+  // ---- poll: unchanged schedule, every 15 s ----
+  phaseBegin();
+  for (int i = 0; i < polls; i++) {
+    hostClockAdvance(15UL * 1000UL);
+    firebaseLoop();
+  }
+  PhaseResult poll = phaseEnd("poll", polls);
+
+  // ---- feed: started + success notifications + weights record ----
+  phaseBegin();
+  int feedFailures = 0;
+  for (int i = 0; i < feeds; i++) {
+    const uint64_t id = eventIdNext();
+    bool ok = true;
+    ok &= firebaseLogMealNotification("feeding_started", "Breakfast", 8, 0, 50, id);
+    ok &= firebaseLogMealNotification("feeding_success", "Breakfast", 8, 0, 50, id);
+    ok &= update_weight(50, 8, 0, "Breakfast", "monday", "2026-01-05", 12.0f, 61.0f, id);
+    if (!ok) feedFailures++;
+    hostClockAdvance(60UL * 1000UL);
+  }
+  PhaseResult feed = phaseEnd("feed", feeds);
+
+  // ---- flush: offline queue -> batched upload ----
+  for (int i = 0; i < queued; i++) {
+    localQueueWeightUpdate(40, 18, 0, "Dinner", "monday", "2026-01-05", 5.0f, 44.0f, eventIdNext());
+  }
+  phaseBegin();
+  bool flushed = localFlushWeightsQueueBatched(update_weights_batch);
+  PhaseResult flush = phaseEnd("flush", queued);
+
+  CloudHealthStats h;
+  cloudHealthGetStats(h);
+
+  printf("\nRTDB stand-in benchmark (latency %d ms, error rate %.3f)\n", latencyMs, errorRate);
+  printResult(poll);
+  printResult(feed);
+  printResult(flush);
+  printf("feeds failed: %d/%d, queue flushed: %s\n", feedFailures, feeds, flushed ? "yes" : "no");
+  printf("cloud health: requests=%lu failed=%lu avg=%lu ms max=%lu ms breaker-opens=%lu\n",
+         (unsigned long)h.requests, (unsigned long)h.failures, (unsigned long)h.avgLatencyMs,
+         (unsigned long)h.maxLatencyMs, (unsigned long)h.opens);
+  return 0;
+}
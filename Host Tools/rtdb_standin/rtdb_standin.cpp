@@ -0,0 +1,855 @@
+// rtdb_standin.cpp
+//
+// Local stand-in for the Firebase Realtime Database REST API, for host tests
+// and load benchmarks of the feeder's network code (no real project needed).
+//
+// Speaks the subset the firmware uses:
+//   GET / PUT / PATCH / POST / DELETE  on  /<path>.json[?shallow=true]
+//   X-Firebase-ETag: true  -> ETag response header
+//   if-match: <etag>       -> conditional PUT/PATCH/DELETE (412 on mismatch)
+//   Accept: text/event-stream -> SSE stream ("put" events) of a subtree
+//   {".sv":"timestamp"}    -> server timestamp (ms)
+//
+// Fault injection (command line or at runtime via /.control):
+//   --latency-ms N   --jitter-ms N   --error-rate P (0..1, answers 503)
+//
+// Stats: GET /.stats (JSON), GET /.stats?reset=1 to clear.
+//
+// Build: make -C "Host Tools/rtdb_standin" rtdb_standin
+// Run:   ./rtdb_standin --port 9000 --seed seed.json
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// -------------------- JSON tree --------------------
+
+struct Json {
+  enum Type { NUL, BOOL, NUM, STR, OBJ };
+  Type type = NUL;
+  bool b = false;
+  std::string s;                                   // number text or string value
+  std::map<std::string, std::shared_ptr<Json>> o;  // arrays are stored as objects ("0","1",...)
+};
+typedef std::shared_ptr<Json> JsonPtr;
+
+static int64_t nowMs() {
+  using namespace std::chrono;
+  return duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+class JsonParser {
+public:
+  explicit JsonParser(const std::string& in) : in_(in) {}
+
+  bool parse(JsonPtr& out) {
+    out = value();
+    ws();
+    return ok_ && pos_ == in_.size();
+  }
+
+private:
+  const std::string& in_;
+  size_t pos_ = 0;
+  bool ok_ = true;
+
+  void ws() {
+    while (pos_ < in_.size() && isspace((unsigned char)in_[pos_])) pos_++;
+  }
+
+  bool eat(char c) {
+    ws();
+    if (pos_ < in_.size() && in_[pos_] == c) { pos_++; return true; }
+    return false;
+  }
+
+  std::string str() {
+    std::string r;
+    if (!eat('"')) { ok_ = false; return r; }
+    while (pos_ < in_.size() && in_[pos_] != '"') {
+      char c = in_[pos_++];
+      if (c == '\\' && pos_ < in_.size()) {
+        char e = in_[pos_++];
+        switch (e) {
+          case 'n': r += '\n'; break;
+          case 't': r += '\t'; break;
+          case 'r': r += '\r'; break;
+          case 'b': r += '\b'; break;
+          case 'f': r += '\f'; break;
+          case 'u':
+            if (pos_ + 4 <= in_.size()) {
+              unsigned cp = (unsigned)strtoul(in_.substr(pos_, 4).c_str(), nullptr, 16);
+              pos_ += 4;
+              if (cp < 0x80) r += (char)cp;
+              else if (cp < 0x800) { r += (char)(0xC0 | (cp >> 6)); r += (char)(0x80 | (cp & 0x3F)); }
+              else { r += (char)(0xE0 | (cp >> 12)); r += (char)(0x80 | ((cp >> 6) & 0x3F)); r += (char)(0x80 | (cp & 0x3F)); }
+            }
+            break;
+          default: r += e; break;
+        }
+      } else {
+        r += c;
+      }
+    }
+    if (pos_ >= in_.size()) { ok_ = false; return r; }
+    pos_++;
+    return r;
+  }
+
+  JsonPtr value() {
+    JsonPtr v = std::make_shared<Json>();
+    ws();
+    if (pos_ >= in_.size()) { ok_ = false; return v; }
+    char c = in_[pos_];
+    if (c == '{') {
+      pos_++;
+      v->type = Json::OBJ;
+      if (eat('}')) return v;
+      do {
+        std::string k = str();
+        if (!eat(':')) { ok_ = false; return v; }
+        JsonPtr child = value();
+        if (child->type != Json::NUL) v->o[k] = child;
+      } while (ok_ && eat(','));
+      if (!eat('}')) ok_ = false;
+    } else if (c == '[') {
+      pos_++;
+      v->type = Json::OBJ;
+      if (eat(']')) return v;
+      int i = 0;
+      do {
+        JsonPtr child = value();
+        if (child->type != Json::NUL) v->o[std::to_string(i)] = child;
+        i++;
+      } while (ok_ && eat(','));
+      if (!eat(']')) ok_ = false;
+    } else if (c == '"') {
+      v->type = Json::STR;
+      v->s = str();
+    } else if (in_.compare(pos_, 4, "true") == 0) {
+      v->type = Json::BOOL; v->b = true; pos_ += 4;
+    } else if (in_.compare(pos_, 5, "false") == 0) {
+      v->type = Json::BOOL; v->b = false; pos_ += 5;
+    } else if (in_.compare(pos_, 4, "null") == 0) {
+      pos_ += 4;
+    } else {
+      size_t start = pos_;
+      while (pos_ < in_.size() && strchr("+-0123456789.eE", in_[pos_])) pos_++;
+      if (pos_ == start) { ok_ = false; return v; }
+      v->type = Json::NUM;
+      v->s = in_.substr(start, pos_ - start);
+    }
+    if (v->type == Json::OBJ && v->o.empty()) v->type = Json::NUL; // RTDB drops empty objects
+    return v;
+  }
+};
+
+static void jsonEscape(const std::string& s, std::string& out) {
+  out += '"';
+  for (char c : s) {
+    switch (c) {
+      case '"':  out += "\\\""; break;
+      case '\\': out += "\\\\"; break;
+      case '\n': out += "\\n"; break;
+      case '\r': out += "\\r"; break;
+      case '\t': out += "\\t"; break;
+      default:
+        if ((unsigned char)c < 0x20) {
+          char buf[8];
+          snprintf(buf, sizeof(buf), "\\u%04x", c);
+          out += buf;
+        } else {
+          out += c;
+        }
+    }
+  }
+  out += '"';
+}
+
+static void jsonWrite(const JsonPtr& v, std::string& out, bool shallow = false) {
+  if (!v) { out += "null"; return; }
+  switch (v->type) {
+    case Json::NUL:  out += "null"; break;
+    case Json::BOOL: out += v->b ? "true" : "false"; break;
+    case Json::NUM:  out += v->s; break;
+    case Json::STR:  jsonEscape(v->s, out); break;
+    case Json::OBJ: {
+      out += '{';
+      bool first = true;
+      for (auto& kv : v->o) {
+        if (!first) out += ',';
+        first = false;
+        jsonEscape(kv.first, out);
+        out += ':';
+        if (shallow && kv.second->type == Json::OBJ) out += "true";
+        else jsonWrite(kv.second, out);
+      }
+      out += '}';
+      break;
+    }
+  }
+}
+
+static std::string toJson(const JsonPtr& v, bool shallow = false) {
+  std::string out;
+  jsonWrite(v, out, shallow);
+  return out;
+}
+
+// Replace {".sv":"timestamp"} placeholders with the server time
+static void resolveServerValues(JsonPtr& v) {
+  if (!v || v->type != Json::OBJ) return;
+  auto it = v->o.find(".sv");
+  if (v->o.size() == 1 && it != v->o.end() && it->second->type == Json::STR &&
+      it->second->s == "timestamp") {
+    v = std::make_shared<Json>();
+    v->type = Json::NUM;
+    v->s = std::to_string(nowMs());
+    return;
+  }
+  for (auto& kv : v->o) resolveServerValues(kv.second);
+}
+
+static JsonPtr deepCopy(const JsonPtr& v) {
+  if (!v) return nullptr;
+  JsonPtr c = std::make_shared<Json>(*v);
+  for (auto& kv : c->o) kv.second = deepCopy(kv.second);
+  return c;
+}
+
+// -------------------- Database --------------------
+
+static std::vector<std::string> splitPath(const std::string& path) {
+  std::vector<std::string> parts;
+  std::string cur;
+  for (char c : path) {
+    if (c == '/') {
+      if (!cur.empty()) parts.push_back(cur);
+      cur.clear();
+    } else {
+      cur += c;
+    }
+  }
+  if (!cur.empty()) parts.push_back(cur);
+  return parts;
+}
+
+static std::string joinPath(const std::vector<std::string>& parts) {
+  std::string p;
+  for (auto& s : parts) p += "/" + s;
+  return p.empty() ? "/" : p;
+}
+
+struct Listener {
+  std::vector<std::string> path;
+  std::vector<std::string> events; // pending "event: ...\ndata: ...\n\n"
+};
+
+class Database {
+public:
+  JsonPtr get(const std::string& path) {
+    std::lock_guard<std::mutex> lk(mu_);
+    return lookup(splitPath(path));
+  }
+
+  // Returns the ETag of the subtree (stable hash of its JSON)
+  std::string etag(const std::string& path) {
+    std::lock_guard<std::mutex> lk(mu_);
+    return etagOf(lookup(splitPath(path)));
+  }
+
+  // Conditional write helpers return false on if-match mismatch
+  bool set(const std::string& path, JsonPtr v, const std::string& ifMatch, std::string& curEtag) {
+    std::lock_guard<std::mutex> lk(mu_);
+    auto parts = splitPath(path);
+    if (!ifMatch.empty() && ifMatch != etagOf(lookup(parts))) {
+      curEtag = etagOf(lookup(parts));
+      return false;
+    }
+    resolveServerValues(v);
+    setLocked(parts, v);
+    notify(parts);
+    curEtag = etagOf(lookup(parts));
+    return true;
+  }
+
+  bool update(const std::string& path, JsonPtr v, const std::string& ifMatch, std::string& curEtag) {
+    std::lock_guard<std::mutex> lk(mu_);
+    auto parts = splitPath(path);
+    if (!ifMatch.empty() && ifMatch != etagOf(lookup(parts))) {
+      curEtag = etagOf(lookup(parts));
+      return false;
+    }
+    resolveServerValues(v);
+    if (v && v->type == Json::OBJ) {
+      for (auto& kv : v->o) { // keys may be multi-location ("a/b/c")
+        auto sub = parts;
+        for (auto& p : splitPath(kv.first)) sub.push_back(p);
+        setLocked(sub, kv.second);
+        notify(sub);
+      }
+    }
+    curEtag = etagOf(lookup(parts));
+    return true;
+  }
+
+  std::string push(const std::string& path, JsonPtr v) {
+    std::string id = pushId();
+    std::lock_guard<std::mutex> lk(mu_);
+    auto parts = splitPath(path);
+    parts.push_back(id);
+    resolveServerValues(v);
+    setLocked(parts, v);
+    notify(parts);
+    return id;
+  }
+
+  std::shared_ptr<Listener> listen(const std::string& path) {
+    std::lock_guard<std::mutex> lk(mu_);
+    auto l = std::make_shared<Listener>();
+    l->path = splitPath(path);
+    l->events.push_back(sseEvent("put", "/", lookup(l->path)));
+    listeners_.push_back(l);
+    return l;
+  }
+
+  void unlisten(const std::shared_ptr<Listener>& l) {
+    std::lock_guard<std::mutex> lk(mu_);
+    for (size_t i = 0; i < listeners_.size(); i++) {
+      if (listeners_[i] == l) { listeners_.erase(listeners_.begin() + i); break; }
+    }
+  }
+
+  // Wait up to timeoutMs for events; returns them (empty on timeout)
+  std::vector<std::string> waitEvents(const std::shared_ptr<Listener>& l, int timeoutMs) {
+    std::unique_lock<std::mutex> lk(mu_);
+    cv_.wait_for(lk, std::chrono::milliseconds(timeoutMs), [&] { return !l->events.empty(); });
+    std::vector<std::string> out;
+    out.swap(l->events);
+    return out;
+  }
+
+  size_t listenerCount() {
+    std::lock_guard<std::mutex> lk(mu_);
+    return listeners_.size();
+  }
+
+  void load(JsonPtr root) {
+    std::lock_guard<std::mutex> lk(mu_);
+    root_ = root ? root : std::make_shared<Json>();
+  }
+
+private:
+  std::mutex mu_;
+  std::condition_variable cv_;
+  JsonPtr root_ = std::make_shared<Json>();
+  std::vector<std::shared_ptr<Listener>> listeners_;
+
+  JsonPtr lookup(const std::vector<std::string>& parts) {
+    JsonPtr cur = root_;
+    for (auto& p : parts) {
+      if (!cur || cur->type != Json::OBJ) return nullptr;
+      auto it = cur->o.find(p);
+      if (it == cur->o.end()) return nullptr;
+      cur = it->second;
+    }
+    return (cur && cur->type != Json::NUL) ? cur : nullptr;
+  }
+
+  void setLocked(const std::vector<std::string>& parts, JsonPtr v) {
+    if (v && v->type == Json::NUL) v = nullptr;
+    if (parts.empty()) {
+      root_ = v ? deepCopy(v) : std::make_shared<Json>();
+      return;
+    }
+    // walk/create parents
+    std::vector<JsonPtr> chain{root_};
+    JsonPtr cur = root_;
+    for (size_t i = 0; i + 1 < parts.size(); i++) {
+      if (cur->type != Json::OBJ) { cur->type = Json::OBJ; cur->o.clear(); }
+      JsonPtr& next = cur->o[parts[i]];
+      if (!next) next = std::make_shared<Json>();
+      cur = next;
+      chain.push_back(cur);
+    }
+    if (cur->type != Json::OBJ) { cur->type = Json::OBJ; cur->o.clear(); }
+    if (v) cur->o[parts.back()] = deepCopy(v);
+    else cur->o.erase(parts.back());
+
+    // prune empty parents (RTDB has no empty objects)
+    for (size_t i = chain.size(); i-- > 1;) {
+      if (chain[i]->type == Json::OBJ && chain[i]->o.empty()) {
+        chain[i - 1]->o.erase(parts[i - 1]);
+      } else {
+        break;
+      }
+    }
+    if (root_->type == Json::OBJ && root_->o.empty()) root_->type = Json::NUL;
+  }
+
+  static std::string etagOf(const JsonPtr& v) {
+    std::string s = toJson(v);
+    uint64_t h = 1469598103934665603ULL;
+    for (unsigned char c : s) { h ^= c; h *= 1099511628211ULL; }
+    char buf[24];
+    snprintf(buf, sizeof(buf), "%016llx", (unsigned long long)h);
+    return buf;
+  }
+
+  static std::string sseEvent(const char* ev, const std::string& path, const JsonPtr& data) {
+    return std::string("event: ") + ev + "\ndata: {\"path\":" + toJson(strJson(path)) +
+           ",\"data\":" + toJson(data) + "}\n\n";
+  }
+
+  static JsonPtr strJson(const std::string& s) {
+    JsonPtr j = std::make_shared<Json>();
+    j->type = Json::STR;
+    j->s = s;
+    return j;
+  }
+
+  static bool isPrefix(const std::vector<std::string>& a, const std::vector<std::string>& b) {
+    if (a.size() > b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) if (a[i] != b[i]) return false;
+    return true;
+  }
+
+  // A write at `parts` -> "put" event for every listener above or below it
+  void notify(const std::vector<std::string>& parts) {
+    bool any = false;
+    for (auto& l : listeners_) {
+      if (isPrefix(l->path, parts)) {
+        std::vector<std::string> rel(parts.begin() + l->path.size(), parts.end());
+        l->events.push_back(sseEvent("put", joinPath(rel), lookup(parts)));
+        any = true;
+      } else if (isPrefix(parts, l->path)) {
+        l->events.push_back(sseEvent("put", "/", lookup(l->path)));
+        any = true;
+      }
+    }
+    if (any) cv_.notify_all();
+  }
+
+  // Firebase-style push ID: 8 chars of time + 12 random chars (sortable)
+  static std::string pushId() {
+    static const char* kChars = "-0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ_abcdefghijklmnopqrstuvwxyz";
+    static std::mutex m;
+    static std::mt19937_64 rng(std::random_device{}());
+    std::lock_guard<std::mutex> lk(m);
+    int64_t t = nowMs();
+    char id[21];
+    for (int i = 7; i >= 0; i--) { id[i] = kChars[t % 64]; t /= 64; }
+    for (int i = 8; i < 20; i++) id[i] = kChars[rng() % 64];
+    id[20] = '\0';
+    return id;
+  }
+};
+
+// -------------------- Fault injection + stats --------------------
+
+struct Config {
+  std::atomic<int> latencyMs{0};
+  std::atomic<int> jitterMs{0};
+  std::atomic<int> errorPermille{0}; // 0..1000
+  bool verbose = false;
+};
+
+struct Stats {
+  std::mutex mu;
+  uint64_t requests = 0;
+  uint64_t bytesIn = 0;
+  uint64_t bytesOut = 0;
+  uint64_t injectedErrors = 0;
+  uint64_t connections = 0;
+  uint64_t totalLatencyUs = 0;
+  std::map<std::string, uint64_t> byMethod;
+  std::map<std::string, uint64_t> byPath; // first path segment
+
+  std::string json() {
+    std::lock_guard<std::mutex> lk(mu);
+    std::ostringstream o;
+    o << "{\"requests\":" << requests << ",\"bytes_in\":" << bytesIn
+      << ",\"bytes_out\":" << bytesOut << ",\"connections\":" << connections
+      << ",\"injected_errors\":" << injectedErrors
+      << ",\"avg_latency_us\":" << (requests ? totalLatencyUs / requests : 0)
+      << ",\"by_method\":{";
+    bool first = true;
+    for (auto& kv : byMethod) { o << (first ? "" : ",") << "\"" << kv.first << "\":" << kv.second; first = false; }
+    o << "},\"by_path\":{";
+    first = true;
+    for (auto& kv : byPath) {
+      std::string k;
+      jsonEscape(kv.first, k);
+      o << (first ? "" : ",") << k << ":" << kv.second;
+      first = false;
+    }
+    o << "}}";
+    return o.str();
+  }
+
+  void reset() {
+    std::lock_guard<std::mutex> lk(mu);
+    requests = bytesIn = bytesOut = injectedErrors = connections = totalLatencyUs = 0;
+    byMethod.clear();
+    byPath.clear();
+  }
+};
+
+static Database g_db;
+static Config g_cfg;
+static Stats g_stats;
+
+// -------------------- HTTP --------------------
+
+struct Request {
+  std::string method;
+  std::string path;                          // without ".json" and query
+  std::map<std::string, std::string> query;
+  std::map<std::string, std::string> headers; // lower-case names
+  std::string body;
+  size_t rawBytes = 0;
+};
+
+static std::string lower(std::string s) {
+  for (auto& c : s) c = (char)tolower((unsigned char)c);
+  return s;
+}
+
+static bool sendAll(int fd, const std::string& data) {
+  size_t off = 0;
+  while (off < data.size()) {
+    ssize_t n = send(fd, data.data() + off, data.size() - off, MSG_NOSIGNAL);
+    if (n <= 0) return false;
+    off += (size_t)n;
+  }
+  return true;
+}
+
+// Reads one request (keep-alive aware). `buf` keeps leftover bytes.
+static bool readRequest(int fd, std::string& buf, Request& req) {
+  size_t hdrEnd;
+  while ((hdrEnd = buf.find("\r\n\r\n")) == std::string::npos) {
+    char tmp[4096];
+    ssize_t n = recv(fd, tmp, sizeof(tmp), 0);
+    if (n <= 0) return false;
+    buf.append(tmp, (size_t)n);
+    if (buf.size() > 1 << 20) return false;
+  }
+
+  std::istringstream hs(buf.substr(0, hdrEnd));
+  std::string line;
+  std::getline(hs, line);
+  std::istringstream rl(line);
+  std::string target, version;
+  rl >> req.method >> target >> version;
+
+  while (std::getline(hs, line)) {
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    size_t c = line.find(':');
+    if (c == std::string::npos) continue;
+    std::string v = line.substr(c + 1);
+    while (!v.empty() && v[0] == ' ') v.erase(0, 1);
+    req.headers[lower(line.substr(0, c))] = v;
+  }
+
+  size_t len = 0;
+  auto it = req.headers.find("content-length");
+  if (it != req.headers.end()) len = (size_t)strtoul(it->second.c_str(), nullptr, 10);
+
+  size_t total = hdrEnd + 4 + len;
+  while (buf.size() < total) {
+    char tmp[4096];
+    ssize_t n = recv(fd, tmp, sizeof(tmp), 0);
+    if (n <= 0) return false;
+    buf.append(tmp, (size_t)n);
+  }
+  req.body = buf.substr(hdrEnd + 4, len);
+  req.rawBytes = total;
+  buf.erase(0, total);
+
+  // target: /path.json?x=y&...
+  size_t q = target.find('?');
+  std::string p = target.substr(0, q);
+  if (q != std::string::npos) {
+    std::istringstream qs(target.substr(q + 1));
+    std::string kv;
+    while (std::getline(qs, kv, '&')) {
+      size_t e = kv.find('=');
+      req.query[kv.substr(0, e)] = (e == std::string::npos) ? "" : kv.substr(e + 1);
+    }
+  }
+  if (p.size() >= 5 && p.compare(p.size() - 5, 5, ".json") == 0) p.erase(p.size() - 5);
+  req.path = p.empty() ? "/" : p;
+
+  // method override used by some REST clients
+  auto mo = req.headers.find("x-http-method-override");
+  if (mo != req.headers.end()) req.method = mo->second;
+  return true;
+}
+
+static std::string response(int code, const char* reason, const std::string& body,
+                            const std::vector<std::string>& extraHeaders = {}) {
+  std::ostringstream o;
+  o << "HTTP/1.1 " << code << " " << reason << "\r\n"
+    << "Content-Type: application/json; charset=utf-8\r\n"
+    << "Content-Length: " << body.size() << "\r\n"
+    << "Connection: keep-alive\r\n";
+  for (auto& h : extraHeaders) o << h << "\r\n";
+  o << "\r\n" << body;
+  return o.str();
+}
+
+static void injectLatency() {
+  int lat = g_cfg.latencyMs.load();
+  int jit = g_cfg.jitterMs.load();
+  if (jit > 0) {
+    static thread_local std::mt19937 rng(std::random_device{}());
+    lat += (int)(rng() % (unsigned)(jit + 1));
+  }
+  if (lat > 0) std::this_thread::sleep_for(std::chrono::milliseconds(lat));
+}
+
+static bool injectError() {
+  int p = g_cfg.errorPermille.load();
+  if (p <= 0) return false;
+  static thread_local std::mt19937 rng(std::random_device{}());
+  return (int)(rng() % 1000) < p;
+}
+
+static void serveSse(int fd, const Request& req) {
+  std::string hdr =
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Type: text/event-stream\r\n"
+      "Cache-Control: no-cache\r\n"
+      "Connection: keep-alive\r\n\r\n";
+  if (!sendAll(fd, hdr)) return;
+
+  auto l = g_db.listen(req.path);
+  if (g_cfg.verbose) printf("[sse] listening on %s\n", req.path.c_str());
+
+  auto lastKeepAlive = std::chrono::steady_clock::now();
+  for (;;) {
+    auto evs = g_db.waitEvents(l, 1000);
+    std::string out;
+    for (auto& e : evs) out += e;
+
+    if (std::chrono::steady_clock::now() - lastKeepAlive > std::chrono::seconds(30)) {
+      out += "event: keep-alive\ndata: null\n\n";
+      lastKeepAlive = std::chrono::steady_clock::now();
+    }
+
+    if (!out.empty()) {
+      {
+        std::lock_guard<std::mutex> lk(g_stats.mu);
+        g_stats.bytesOut += out.size();
+      }
+      if (!sendAll(fd, out)) break;
+    }
+  }
+
+  g_db.unlisten(l);
+  if (g_cfg.verbose) printf("[sse] closed %s\n", req.path.c_str());
+}
+
+static std::string handleControl(const Request& req) {
+  auto q = req.query;
+  if (q.count("latency_ms")) g_cfg.latencyMs = atoi(q["latency_ms"].c_str());
+  if (q.count("jitter_ms")) g_cfg.jitterMs = atoi(q["jitter_ms"].c_str());
+  if (q.count("error_rate")) g_cfg.errorPermille = (int)(atof(q["error_rate"].c_str()) * 1000.0);
+  std::ostringstream o;
+  o << "{\"latency_ms\":" << g_cfg.latencyMs.load() << ",\"jitter_ms\":" << g_cfg.jitterMs.load()
+    << ",\"error_rate\":" << (g_cfg.errorPermille.load() / 1000.0) << "}";
+  return o.str();
+}
+
+static void serveConnection(int fd) {
+  {
+    std::lock_guard<std::mutex> lk(g_stats.mu);
+    g_stats.connections++;
+  }
+
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+  std::string buf;
+  Request req;
+  while (readRequest(fd, buf, req)) {
+    auto t0 = std::chrono::steady_clock::now();
+    std::string out;
+
+    // ---- service endpoints (not counted, no faults) ----
+    if (req.path == "/.stats") {
+      std::string body = g_stats.json();
+      if (req.query.count("reset")) g_stats.reset();
+      if (!sendAll(fd, response(200, "OK", body))) break;
+      req = Request();
+      continue;
+    }
+    if (req.path == "/.control") {
+      if (!sendAll(fd, response(200, "OK", handleControl(req)))) break;
+      req = Request();
+      continue;
+    }
+
+    const bool wantsEtag = lower(req.headers["x-firebase-etag"]) == "true";
+    const std::string ifMatch = req.headers.count("if-match") ? req.headers["if-match"] : "";
+    const bool sse = req.method == "GET" &&
+                     lower(req.headers["accept"]).find("text/event-stream") != std::string::npos;
+
+    injectLatency();
+
+    {
+      std::lock_guard<std::mutex> lk(g_stats.mu);
+      g_stats.requests++;
+      g_stats.bytesIn += req.rawBytes;
+      g_stats.byMethod[sse ? "SSE" : req.method]++;
+      auto parts = splitPath(req.path);
+      g_stats.byPath[parts.empty() ? "/" : "/" + parts[0]]++;
+    }
+
+    if (injectError()) {
+      {
+        std::lock_guard<std::mutex> lk(g_stats.mu);
+        g_stats.injectedErrors++;
+      }
+      out = response(503, "Service Unavailable", "{\"error\":\"injected failure\"}");
+    } else if (sse) {
+      serveSse(fd, req);
+      break;
+    } else if (req.method == "GET") {
+      JsonPtr v = g_db.get(req.path);
+      std::vector<std::string> h;
+      if (wantsEtag) h.push_back("ETag: " + g_db.etag(req.path));
+      out = response(200, "OK", toJson(v, req.query.count("shallow") > 0), h);
+    } else if (req.method == "PUT" || req.method == "PATCH" || req.method == "POST") {
+      JsonPtr v;
+      if (!JsonParser(req.body).parse(v)) {
+        out = response(400, "Bad Request", "{\"error\":\"Invalid data; couldn't parse JSON object.\"}");
+      } else if (req.method == "POST") {
+        std::string id = g_db.push(req.path, v);
+        out = response(200, "OK", "{\"name\":\"" + id + "\"}");
+      } else {
+        std::string etag;
+        if (req.method == "PATCH") resolveServerValues(v); // echoed back below
+        bool ok = (req.method == "PUT") ? g_db.set(req.path, v, ifMatch, etag)
+                                        : g_db.update(req.path, v, ifMatch, etag);
+        std::vector<std::string> h;
+        if (wantsEtag || !ifMatch.empty()) h.push_back("ETag: " + etag);
+        if (!ok) {
+          out = response(412, "Precondition Failed", toJson(g_db.get(req.path)), h);
+        } else {
+          const bool silent = req.query.count("print") && req.query["print"] == "silent";
+          // RTDB echoes the written data (PATCH: only the patch, not the node)
+          const std::string echo = (req.method == "PATCH") ? toJson(v) : toJson(g_db.get(req.path));
+          out = silent ? response(204, "No Content", "", h) : response(200, "OK", echo, h);
+        }
+      }
+    } else if (req.method == "DELETE") {
+      std::string etag;
+      bool ok = g_db.set(req.path, nullptr, ifMatch, etag);
+      out = ok ? response(200, "OK", "null") : response(412, "Precondition Failed", toJson(g_db.get(req.path)));
+    } else {
+      out = response(405, "Method Not Allowed", "{\"error\":\"method not allowed\"}");
+    }
+
+    {
+      std::lock_guard<std::mutex> lk(g_stats.mu);
+      g_stats.bytesOut += out.size();
+      g_stats.totalLatencyUs += (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+                                    std::chrono::steady_clock::now() - t0).count();
+    }
+
+    if (g_cfg.verbose) {
+      printf("%s %s -> %.*s (%zu B in, %zu B out)\n", req.method.c_str(), req.path.c_str(),
+             12, out.c_str() + 9, req.rawBytes, out.size());
+    }
+
+    if (!sendAll(fd, out)) break;
+    if (lower(req.headers["connection"]) == "close") break;
+    req = Request();
+  }
+
+  close(fd);
+}
+
+// -------------------- main --------------------
+
+static void usage(const char* argv0) {
+  fprintf(stderr,
+          "usage: %s [--port N] [--seed file.json] [--latency-ms N] [--jitter-ms N]\n"
+          "          [--error-rate P] [--verbose]\n",
+          argv0);
+}
+
+int main(int argc, char** argv) {
+  int port = 9000;
+  std::string seedFile;
+
+  for (int i = 1; i < argc; i++) {
+    std::string a = argv[i];
+    auto next = [&]() -> const char* { return (i + 1 < argc) ? argv[++i] : ""; };
+    if (a == "--port") port = atoi(next());
+    else if (a == "--seed") seedFile = next();
+    else if (a == "--latency-ms") g_cfg.latencyMs = atoi(next());
+    else if (a == "--jitter-ms") g_cfg.jitterMs = atoi(next());
+    else if (a == "--error-rate") g_cfg.errorPermille = (int)(atof(next()) * 1000.0);
+    else if (a == "--verbose") g_cfg.verbose = true;
+    else { usage(argv[0]); return 2; }
+  }
+
+  if (!seedFile.empty()) {
+    std::ifstream f(seedFile);
+    std::stringstream ss;
+    ss << f.rdbuf();
+    JsonPtr root;
+    if (!f || !JsonParser(ss.str()).parse(root)) {
+      fprintf(stderr, "cannot parse seed file %s\n", seedFile.c_str());
+      return 1;
+    }
+    g_db.load(root);
+  }
+
+  signal(SIGPIPE, SIG_IGN);
+
+  int srv = socket(AF_INET, SOCK_STREAM, 0);
+  int one = 1;
+  setsockopt(srv, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons((uint16_t)port);
+  if (bind(srv, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(srv, 16) != 0) {
+    perror("bind/listen");
+    return 1;
+  }
+
+  printf("rtdb_standin listening on 127.0.0.1:%d (latency=%d ms, jitter=%d ms, error_rate=%.3f)\n",
+         port, g_cfg.latencyMs.load(), g_cfg.jitterMs.load(), g_cfg.errorPermille.load() / 1000.0);
+  fflush(stdout);
+
+  for (;;) {
+    int fd = accept(srv, nullptr, nullptr);
+    if (fd < 0) continue;
+    std::thread(serveConnection, fd).detach();
+  }
+}
@@ -139,18 +139,56 @@ class MealProvider extends ChangeNotifier {
     final id = nextIndex.toString();
     final meal = Meal(id: id, name: name, time: time, amount: amount);
 
-    await _feedingsRef.child(id).set(meal.toFirebaseMap());
+    await FirebaseDatabase.instance.ref().update({
+      "feedings/$id": meal.toFirebaseMap(),
+      "feedings_version": ServerValue.timestamp,
+    });
   }
 
+  // The feeder polls "feedings_version" and downloads the schedule only when
+  // it changes, so every schedule edit must bump it in the same update.
   Future<void> deleteMeal(String id) async {
-    await _feedingsRef.child(id).remove();
+    await FirebaseDatabase.instance.ref().update({
+      "feedings/$id": null,
+      "feedings_version": ServerValue.timestamp,
+    });
   }
 
-  Future<void> feedNow(Meal nextMeal) async {
-    await FirebaseDatabase.instance.ref("feedings/commands/feedNow").set({
-      "meal_id": nextMeal.id,
-      "amount_grams": nextMeal.amount,
-      "time": ServerValue.timestamp,
+  // Commands are pushed to /commands; the feeder holds a stream on that node,
+  // runs each one once, then writes its status to /commandAcks/<id>
+  // ("done"/"rejected"/"failed"/"cancelled"/"expired") and removes the
+  // command from /commands in the same update.
+  Future<String?> _sendCommand(String type, [Map<String, Object?> extra = const {}]) async {
+    final ref = FirebaseDatabase.instance.ref("commands").push();
+    await ref.set({
+      "type": type,
+      ...extra,
+      "createdAt": ServerValue.timestamp,
     });
+    return ref.key;
+  }
+
+  // Status of a command sent by _sendCommand (null until the feeder acks it)
+  Stream<String?> commandStatus(String id) {
+    return FirebaseDatabase.instance
+        .ref("commandAcks/$id/status")
+        .onValue
+        .map((event) => event.snapshot.value as String?);
+  }
+
+  Future<void> feedNow(Meal nextMeal) async {
+    await _sendCommand("feed_now", {"grams": nextMeal.amount});
+  }
+
+  Future<void> cancelFeeding() async {
+    await _sendCommand("cancel");
+  }
+
+  Future<void> tareScale() async {
+    await _sendCommand("tare");
+  }
+
+  Future<void> requestDiagnostics() async {
+    await _sendCommand("diagnostics");
   }
 }
@@ -48,9 +48,17 @@ class StatsProvider extends ChangeNotifier {
   final DatabaseReference _weightsRef = FirebaseDatabase.instance.ref(
     'weights',
   );
+  // Daily totals rolled up by the feeder (a few hundred bytes for the week)
+  final DatabaseReference _weekRef = FirebaseDatabase.instance.ref(
+    'stats/week',
+  );
   StreamSubscription<DatabaseEvent>? _sub;
+  StreamSubscription<DatabaseEvent>? _weekSub;
   bool _pruneInProgress = false;
 
+  // date ("YYYY-MM-DD") -> grams eaten, from /stats/week
+  Map<String, double> _eatenByDate = {};
+
   List<WeightEntry> _weights = [];
   List<WeightEntry> get weights => List.unmodifiable(_weights);
 
@@ -61,10 +69,27 @@ class StatsProvider extends ChangeNotifier {
   @override
   void dispose() {
     _sub?.cancel();
+    _weekSub?.cancel();
     super.dispose();
   }
 
   void _startListening() {
+    _weekSub?.cancel();
+    _weekSub = _weekRef.onValue.listen((event) {
+      final data = event.snapshot.value;
+      final totals = <String, double>{};
+      if (data is Map<dynamic, dynamic>) {
+        data.forEach((key, value) {
+          if (value is Map<dynamic, dynamic>) {
+            final e = value['e'];
+            if (e is num) totals[key.toString()] = e.toDouble();
+          }
+        });
+      }
+      _eatenByDate = totals;
+      notifyListeners();
+    });
+
     _sub?.cancel();
     _sub = _weightsRef.onValue.listen((event) {
       final data = event.snapshot.value;
@@ -218,6 +243,9 @@ class StatsProvider extends ChangeNotifier {
   }
 
   double totalForDateStr(String dateStr) {
+    final rolledUp = _eatenByDate[dateStr];
+    if (rolledUp != null) return rolledUp;
+
     double sum = 0.0;
     for (final r in _allMealRows()) {
       if (r.date == dateStr) sum += r.ateG;